@@ -64,7 +64,7 @@
 #define __PLATFORM_MACOSX__
 #endif
 
-#if defined(__LINUX_ALSA__) || defined(__LINUX_JACK__) || defined(__LINUX_OSS__) 
+#if defined(__LINUX_ALSA__) || defined(__LINUX_JACK__) || defined(__LINUX_OSS__) || defined(__linux__)
 #define __PLATFORM_LINUX__
 #endif
 
@@ -38,6 +38,7 @@
 #include <math.h>
 #include <iostream>
 #include <algorithm>
+#include <sys/time.h>
 
 using namespace std;
 
@@ -95,6 +96,19 @@ void XFun::srand()
 
 
 
+//-----------------------------------------------------------------------------
+// name: srand()
+// desc: seeds random with a fixed seed
+//-----------------------------------------------------------------------------
+void XFun::srand( unsigned int seed )
+{
+    // seed
+    srandom( seed );
+}
+
+
+
+
 //-----------------------------------------------------------------------------
 // name: freq2midi()
 // desc: converts frequency to midi notenum
@@ -231,6 +245,27 @@ string XFun::toUpper( const string & str )
 
 
 
+//-----------------------------------------------------------------------------
+// name: now()
+// desc: monotonic time in seconds (not the time of day: it doesn't jump when
+//       the clock is set)
+//-----------------------------------------------------------------------------
+double XFun::now()
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + tv.tv_usec / 1e6;
+#endif
+}
+
+
+
+
 //-----------------------------------------------------------------------------
 // name: diffTime()
 // desc: calculates difference in seconds between current time and input time
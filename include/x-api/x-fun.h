@@ -57,6 +57,8 @@ public:
     static double rand2f( double low, double high );
     // seed random
     static void srand();
+    // seed random with a fixed seed (reproducible runs)
+    static void srand( unsigned int seed );
 
     // frequency to midi
     static double freq2midi( double freq );
@@ -78,6 +80,9 @@ public:
     // return an upper case version of a string
     static std::string toUpper( const std::string & str );
 	
+    // monotonic time in seconds (for measuring intervals)
+    static double now();
+
 	// find difference in seconds between current time and input time
 	static long diffTime( const char * str ); 
 	static std::string formatTime( long seconds, bool terse = false ); 
@@ -127,7 +127,394 @@ void XGfx::setDeltaFactor( GLfloat factor )
 
 
 
+//-----------------------------------------------------------------------------
+// name: identity()
+// desc: set to identity
+//-----------------------------------------------------------------------------
+void XMatrix4::identity()
+{
+    for( int i = 0; i < 16; i++ ) m[i] = 0;
+    m[0] = m[5] = m[10] = m[15] = 1;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: setTransform()
+// desc: T * Rz * Ry * Rx * S (the order YEntity::applyTransforms() uses)
+//-----------------------------------------------------------------------------
+void XMatrix4::setTransform( const Vector3D & loc, const Vector3D & ori, const Vector3D & sca )
+{
+    // columns of Rz * Ry * Rx
+    GLfloat r[9] = { 1, 0, 0,  0, 1, 0,  0, 0, 1 };
+    if( ori.x != 0 || ori.y != 0 || ori.z != 0 )
+    {
+        GLfloat rx = ori.x * (GLfloat)M_PI / 180, ry = ori.y * (GLfloat)M_PI / 180,
+                rz = ori.z * (GLfloat)M_PI / 180;
+        GLfloat cx = cosf( rx ), sx = sinf( rx ), cy = cosf( ry ), sy = sinf( ry ),
+                cz = cosf( rz ), sz = sinf( rz );
+        r[0] = cz * cy; r[1] = sz * cy; r[2] = -sy;
+        r[3] = cz * sy * sx - sz * cx; r[4] = sz * sy * sx + cz * cx; r[5] = cy * sx;
+        r[6] = cz * sy * cx + sz * sx; r[7] = sz * sy * cx - cz * sx; r[8] = cy * cx;
+    }
+    
+    m[0] = r[0] * sca.x; m[1] = r[1] * sca.x; m[2] = r[2] * sca.x; m[3] = 0;
+    m[4] = r[3] * sca.y; m[5] = r[4] * sca.y; m[6] = r[5] * sca.y; m[7] = 0;
+    m[8] = r[6] * sca.z; m[9] = r[7] * sca.z; m[10] = r[8] * sca.z; m[11] = 0;
+    m[12] = loc.x; m[13] = loc.y; m[14] = loc.z; m[15] = 1;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: mulAffine()
+// desc: this = lhs * rhs, both affine (skips the bottom row)
+//-----------------------------------------------------------------------------
+void XMatrix4::mulAffine( const XMatrix4 & lhs, const XMatrix4 & rhs )
+{
+    const GLfloat * a = lhs.m;
+    const GLfloat * b = rhs.m;
+    for( int c = 0; c < 4; c++ )
+    {
+        const GLfloat * col = b + c * 4;
+        m[c * 4 + 0] = a[0] * col[0] + a[4] * col[1] + a[8] * col[2];
+        m[c * 4 + 1] = a[1] * col[0] + a[5] * col[1] + a[9] * col[2];
+        m[c * 4 + 2] = a[2] * col[0] + a[6] * col[1] + a[10] * col[2];
+        m[c * 4 + 3] = 0;
+    }
+    m[12] += a[12]; m[13] += a[13]; m[14] += a[14];
+    m[15] = 1;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: operator *()
+// desc: general product
+//-----------------------------------------------------------------------------
+XMatrix4 XMatrix4::operator *( const XMatrix4 & rhs ) const
+{
+    XMatrix4 result;
+    for( int c = 0; c < 4; c++ )
+        for( int r = 0; r < 4; r++ )
+            result.m[c * 4 + r] = m[r] * rhs.m[c * 4] + m[4 + r] * rhs.m[c * 4 + 1]
+                                + m[8 + r] * rhs.m[c * 4 + 2] + m[12 + r] * rhs.m[c * 4 + 3];
+    return result;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: maxScale()
+// desc: length of the longest basis column
+//-----------------------------------------------------------------------------
+GLfloat XMatrix4::maxScale() const
+{
+    GLfloat sx = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+    GLfloat sy = m[4] * m[4] + m[5] * m[5] + m[6] * m[6];
+    GLfloat sz = m[8] * m[8] + m[9] * m[9] + m[10] * m[10];
+    GLfloat s = sx > sy ? sx : sy;
+    return sqrtf( s > sz ? s : sz );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: set()
+// desc: planes from the rows of the clip matrix (Gribb & Hartmann)
+//-----------------------------------------------------------------------------
+void XFrustum::set( const XMatrix4 & clip )
+{
+    const GLfloat * m = clip.m;
+    for( int p = 0; p < 6; p++ )
+    {
+        // row 3 +/- row (p / 2)
+        int row = p / 2;
+        GLfloat sign = ( p % 2 ) ? -1.0f : 1.0f;
+        for( int c = 0; c < 4; c++ )
+            planes[p][c] = m[c * 4 + 3] + sign * m[c * 4 + row];
+        
+        // normalize so distances are real distances
+        GLfloat len = sqrtf( planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1]
+                             + planes[p][2] * planes[p][2] );
+        if( len > 0 )
+            for( int c = 0; c < 4; c++ ) planes[p][c] /= len;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: classify()
+// desc: sphere vs the six planes
+//-----------------------------------------------------------------------------
+int XFrustum::classify( const Vector3D & center, GLfloat radius ) const
+{
+    int result = 1;
+    for( int p = 0; p < 6; p++ )
+    {
+        GLfloat d = planes[p][0] * center.x + planes[p][1] * center.y
+                  + planes[p][2] * center.z + planes[p][3];
+        if( d < -radius ) return -1;
+        if( d < radius ) result = 0;
+    }
+    return result;
+}
+
+
+
+
+// tracked capabilities, in ourCaps order
+static const GLenum g_xgl_caps[XGL_NUM_CAPS] = {
+    GL_BLEND, GL_TEXTURE_2D, GL_DEPTH_TEST, GL_LIGHTING,
+    GL_FOG, GL_CULL_FACE, GL_COLOR_MATERIAL, GL_NORMALIZE
+};
+// client arrays, in ourArrays order (XGL_*_ARRAY bit i)
+static const GLenum g_xgl_arrays[4] = {
+    GL_VERTEX_ARRAY, GL_NORMAL_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: capIndex()
+// desc: shadow slot of a capability (-1 if untracked)
+//-----------------------------------------------------------------------------
+int XGLState::capIndex( GLenum cap )
+{
+    for( int i = 0; i < XGL_NUM_CAPS; i++ )
+        if( g_xgl_caps[i] == cap ) return i;
+    return -1;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: changed()
+// desc: count a request against its shadow; true if it must be issued
+//-----------------------------------------------------------------------------
+bool XGLState::changed( int & shadow, int value )
+{
+    if( ourCaching && shadow == value )
+    {
+        ourSkipped++;
+        return false;
+    }
+
+    shadow = value;
+    ourIssued++;
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: setCap()
+// desc: glEnable / glDisable unless already so
+//-----------------------------------------------------------------------------
+void XGLState::setCap( GLenum cap, bool on )
+{
+    int index = capIndex( cap );
+    // untracked: always issued
+    int untracked = -1;
+    if( !changed( index >= 0 ? ourCaps[index] : untracked, on ? 1 : 0 ) ) return;
+
+    if( on ) glEnable( cap );
+    else glDisable( cap );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: enable() / disable()
+// desc: capabilities
+//-----------------------------------------------------------------------------
+void XGLState::enable( GLenum cap )
+{
+    setCap( cap, true );
+}
+
+void XGLState::disable( GLenum cap )
+{
+    setCap( cap, false );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: blendFunc()
+// desc: glBlendFunc unless already so
+//-----------------------------------------------------------------------------
+void XGLState::blendFunc( GLenum sfactor, GLenum dfactor )
+{
+    // one call: skipped only if both match
+    if( ourCaching && ourBlendSrc == (int)sfactor && ourBlendDst == (int)dfactor )
+    {
+        ourSkipped++;
+        return;
+    }
+
+    ourBlendSrc = (int)sfactor;
+    ourBlendDst = (int)dfactor;
+    ourIssued++;
+    glBlendFunc( sfactor, dfactor );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bindTexture()
+// desc: glBindTexture( GL_TEXTURE_2D ) unless already bound
+//-----------------------------------------------------------------------------
+void XGLState::bindTexture( GLuint texture )
+{
+    if( !changed( ourTexture, (int)texture ) ) return;
+    glBindTexture( GL_TEXTURE_2D, texture );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: depthMask()
+// desc: glDepthMask unless already so
+//-----------------------------------------------------------------------------
+void XGLState::depthMask( GLboolean flag )
+{
+    if( !changed( ourDepthMask, flag ? 1 : 0 ) ) return;
+    glDepthMask( flag );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: setArray()
+// desc: glEnableClientState / glDisableClientState unless already so
+//-----------------------------------------------------------------------------
+void XGLState::setArray( GLenum array, int index, bool on )
+{
+    int untracked = -1;
+    if( !changed( index >= 0 ? ourArrays[index] : untracked, on ? 1 : 0 ) ) return;
+
+    if( on ) glEnableClientState( array );
+    else glDisableClientState( array );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: arrayIndex()
+// desc: shadow slot of a client array (-1 if untracked)
+//-----------------------------------------------------------------------------
+int XGLState::arrayIndex( GLenum array )
+{
+    for( int i = 0; i < 4; i++ )
+        if( g_xgl_arrays[i] == array ) return i;
+    return -1;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: enableClientState() / disableClientState()
+// desc: one client array
+//-----------------------------------------------------------------------------
+void XGLState::enableClientState( GLenum array )
+{
+    setArray( array, arrayIndex( array ), true );
+}
+
+void XGLState::disableClientState( GLenum array )
+{
+    setArray( array, arrayIndex( array ), false );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: clientArrays()
+// desc: exactly these client arrays enabled
+//-----------------------------------------------------------------------------
+void XGLState::clientArrays( unsigned int arrays )
+{
+    for( int i = 0; i < 4; i++ )
+        setArray( g_xgl_arrays[i], i, ( arrays & ( 1 << i ) ) != 0 );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: invalidate()
+// desc: forget what's shadowed
+//-----------------------------------------------------------------------------
+void XGLState::invalidate()
+{
+    for( int i = 0; i < XGL_NUM_CAPS; i++ ) ourCaps[i] = -1;
+    for( int i = 0; i < 4; i++ ) ourArrays[i] = -1;
+    ourBlendSrc = ourBlendDst = -1;
+    ourTexture = -1;
+    ourDepthMask = -1;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: setCaching()
+// desc: skip redundant calls or not
+//-----------------------------------------------------------------------------
+void XGLState::setCaching( bool caching )
+{
+    ourCaching = caching;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: endFrame()
+// desc: this frame's counts become the last frame's
+//-----------------------------------------------------------------------------
+void XGLState::endFrame()
+{
+    ourLastIssued = ourIssued;
+    ourLastSkipped = ourSkipped;
+    ourIssued = ourSkipped = 0;
+}
+
+
+
+
 // static instantiation
 struct timeval XGfx::ourCurrTime;
 struct timeval XGfx::ourPrevTime;
 GLfloat XGfx::ourDeltaFactor = 1.0f;
+// nothing known until set through XGLState
+int XGLState::ourCaps[XGL_NUM_CAPS] = { -1, -1, -1, -1, -1, -1, -1, -1 };
+int XGLState::ourArrays[4] = { -1, -1, -1, -1 };
+int XGLState::ourBlendSrc = -1;
+int XGLState::ourBlendDst = -1;
+int XGLState::ourTexture = -1;
+int XGLState::ourDepthMask = -1;
+bool XGLState::ourCaching = true;
+unsigned long XGLState::ourIssued = 0;
+unsigned long XGLState::ourSkipped = 0;
+unsigned long XGLState::ourLastIssued = 0;
+unsigned long XGLState::ourLastSkipped = 0;
@@ -188,4 +188,134 @@ struct XPoint4D
 
 
 
+//-----------------------------------------------------------------------------
+// name: struct XMatrix4
+// desc: 4x4 matrix, column-major (as glLoadMatrixf / glGetFloatv expect)
+//-----------------------------------------------------------------------------
+struct XMatrix4
+{
+    GLfloat m[16];
+    
+    // constructor (identity)
+    XMatrix4() { identity(); }
+    
+    // set to identity
+    void identity();
+    // set to translate * rotate z/y/x (degrees) * scale (as glTranslatef,
+    // glRotatef and glScalef in that order)
+    void setTransform( const Vector3D & loc, const Vector3D & ori, const Vector3D & sca );
+    // this = lhs * rhs (affine: bottom rows assumed 0 0 0 1; neither may
+    // be this)
+    void mulAffine( const XMatrix4 & lhs, const XMatrix4 & rhs );
+    // this * rhs (general)
+    XMatrix4 operator *( const XMatrix4 & rhs ) const;
+    // transform a point (x, y, z, 1)
+    Vector3D transform( GLfloat x, GLfloat y, GLfloat z ) const
+    { return Vector3D( m[0] * x + m[4] * y + m[8] * z + m[12],
+                       m[1] * x + m[5] * y + m[9] * z + m[13],
+                       m[2] * x + m[6] * y + m[10] * z + m[14] ); }
+    // largest scale along any axis (for transforming radii)
+    GLfloat maxScale() const;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: struct XFrustum
+// desc: six clip planes (normalized, pointing in) for sphere tests
+//-----------------------------------------------------------------------------
+struct XFrustum
+{
+    // left, right, bottom, top, near, far: a x + b y + c z + d >= 0 inside
+    GLfloat planes[6][4];
+    
+    // extract from projection * modelview (gives planes in the space the
+    // modelview maps from)
+    void set( const XMatrix4 & clip );
+    // -1 outside, 0 intersecting, 1 inside
+    int classify( const Vector3D & center, GLfloat radius ) const;
+};
+
+
+
+
+// client arrays, for XGLState::clientArrays()
+#define XGL_VERTEX_ARRAY   0x1
+#define XGL_NORMAL_ARRAY   0x2
+#define XGL_COLOR_ARRAY    0x4
+#define XGL_TEXCOORD_ARRAY 0x8
+// capabilities XGLState tracks (others pass through)
+#define XGL_NUM_CAPS       8
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class XGLState
+// desc: shadows the GL state renders set around every draw (enable bits,
+//       blend function, 2D texture binding, depth mask, client arrays) and
+//       skips calls that wouldn't change it; renders set what they depend
+//       on and leave it there. Anything that changes this state behind its
+//       back (glPopAttrib, glDeleteTextures on the bound texture, glut's
+//       shape draws, raw glEnable of a tracked capability) must call
+//       invalidate(). GL thread only.
+//-----------------------------------------------------------------------------
+class XGLState
+{
+public:
+    // capabilities
+    static void enable( GLenum cap );
+    static void disable( GLenum cap );
+    // blend function
+    static void blendFunc( GLenum sfactor, GLenum dfactor );
+    // GL_TEXTURE_2D binding
+    static void bindTexture( GLuint texture );
+    // depth buffer writes
+    static void depthMask( GLboolean flag );
+    // client arrays, one at a time...
+    static void enableClientState( GLenum array );
+    static void disableClientState( GLenum array );
+    // ...or all at once (XGL_*_ARRAY bits; the ones not given are disabled)
+    static void clientArrays( unsigned int arrays );
+
+public:
+    // forget what's shadowed (the next call of each kind is issued)
+    static void invalidate();
+    // skip redundant calls (default); off issues everything, to compare
+    static void setCaching( bool caching );
+    static bool caching() { return ourCaching; }
+    // call once a frame: this frame's counts become the last frame's
+    static void endFrame();
+    // state calls issued and skipped in the last frame
+    static unsigned long numIssued() { return ourLastIssued; }
+    static unsigned long numSkipped() { return ourLastSkipped; }
+
+protected:
+    static int capIndex( GLenum cap );
+    static int arrayIndex( GLenum array );
+    static void setCap( GLenum cap, bool on );
+    static void setArray( GLenum array, int index, bool on );
+    // count a request; true if it has to be issued
+    static bool changed( int & shadow, int value );
+
+protected:
+    // shadows: -1 unknown
+    static int ourCaps[XGL_NUM_CAPS];
+    static int ourArrays[4];
+    static int ourBlendSrc;
+    static int ourBlendDst;
+    static int ourTexture;
+    static int ourDepthMask;
+    static bool ourCaching;
+    // this frame / last frame
+    static unsigned long ourIssued;
+    static unsigned long ourSkipped;
+    static unsigned long ourLastIssued;
+    static unsigned long ourLastSkipped;
+};
+
+
+
+
 #endif
@@ -459,39 +459,44 @@ void YHistoBin::render()
     if( !active ) return;
 
     // disable lighting
-    glDisable( GL_LIGHTING );
+    XGLState::disable( GL_LIGHTING );
 
     // depth
-    if( useDepth ) glEnable( GL_DEPTH_TEST );
-    else glDisable( GL_DEPTH_TEST );
+    if( useDepth ) XGLState::enable( GL_DEPTH_TEST );
+    else XGLState::disable( GL_DEPTH_TEST );
 
     // disable writing
-    glDepthMask( GL_FALSE );
+    XGLState::depthMask( GL_FALSE );
     
     // if texture
     if( texture )
     {
         // enable texture mapping
-        glEnable( GL_TEXTURE_2D );
+        XGLState::enable( GL_TEXTURE_2D );
         // enable blending
-        glEnable( GL_BLEND );
+        XGLState::enable( GL_BLEND );
         // blend function
-        // glBlendFunc( GL_ONE, GL_ONE );
-        glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+        // XGLState::blendFunc( GL_ONE, GL_ONE );
+        XGLState::blendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
         // bind the texture
-        glBindTexture( GL_TEXTURE_2D, texture );
+        XGLState::bindTexture( texture );
+        // arrays
+        XGLState::clientArrays( XGL_VERTEX_ARRAY | XGL_TEXCOORD_ARRAY );
+    }
+    else
+    {
+        // untextured (blending as the parent set it)
+        XGLState::disable( GL_TEXTURE_2D );
+        // arrays
+        XGLState::clientArrays( XGL_VERTEX_ARRAY );
     }
     
-    // enable
-    glEnableClientState( GL_VERTEX_ARRAY );
     // vertex
     glVertexPointer( 2, GL_FLOAT, 0, vertices );
 
     // if texture
     if( texture )
     {
-        // texture
-        glEnableClientState( GL_TEXTURE_COORD_ARRAY );
         // texture coordinate
         glTexCoordPointer( 2, GL_FLOAT, 0, g_texCoords );
     }
@@ -499,12 +504,8 @@ void YHistoBin::render()
     // triangle strip
     glDrawArrays( GL_TRIANGLE_STRIP, 0, 4 );
     
-    // if texture
-    if( texture )
-    {
-        // disable texture
-        glDisableClientState( GL_TEXTURE_COORD_ARRAY );
-    }
+    // outline is untextured
+    XGLState::clientArrays( XGL_VERTEX_ARRAY );
 
     // color
     glColor4f( .5, .5, .5, alpha );
@@ -514,20 +515,6 @@ void YHistoBin::render()
     glVertexPointer( 2, GL_FLOAT, 0, outline );
     // line strip
     glDrawArrays( GL_LINE_LOOP, 0, 4 );
-
-    // disable
-    glDisableClientState( GL_VERTEX_ARRAY );
-
-    // if texture
-    if( texture )
-    {
-        // disable
-        glDisable( GL_TEXTURE_2D );
-        glDisable( GL_BLEND );
-    }
-
-    // enable writing
-    glDepthMask( GL_TRUE );
 }
 
 
@@ -591,8 +578,12 @@ YLineChart::YLineChart()
 
     // zero out list
     m_line = NULL;
+    m_last = NULL;
     m_leftViewable = NULL;
     m_rightViewable = NULL;
+    m_free = NULL;
+    m_count = 0;
+    m_capacity = 0;
 
     // set view bounds
     m_leftBound.updateSet( 0, 1 );
@@ -611,6 +602,7 @@ YLineChart::YLineChart()
 YLineChart::~YLineChart()
 {
     // clean up
+    cleanup();
 }
 
 
@@ -636,22 +628,99 @@ void YLineChart::init( GLfloat width, GLfloat height )
 void YLineChart::cleanup()
 {
     // pointers
-    YLineNode * curr = m_line;
+    YLineNode * curr = NULL;
     YLineNode * next = NULL;
+    // both the list and the reusable nodes
+    YLineNode * lists[] = { m_line, m_free };
     
-    // iterate
-    while( curr != NULL )
+    for( int i = 0; i < 2; i++ )
     {
-        // get next
-        next = curr->next;
-        // delete current
-        SAFE_DELETE( curr );
-        // move to next
-        curr = next;
+        // iterate
+        curr = lists[i];
+        while( curr != NULL )
+        {
+            // get next
+            next = curr->next;
+            // delete current
+            SAFE_DELETE( curr );
+            // move to next
+            curr = next;
+        }
     }
     
     // zero out the list
     m_line = NULL;
+    m_last = NULL;
+    m_leftViewable = NULL;
+    m_rightViewable = NULL;
+    m_free = NULL;
+    m_count = 0;
+    m_vertices.clear();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: setCapacity()
+// desc: keep at most this many nodes (0 == no limit)
+//-----------------------------------------------------------------------------
+void YLineChart::setCapacity( unsigned long capacity )
+{
+    // set it
+    m_capacity = capacity;
+    // trim
+    while( m_capacity && m_count > m_capacity ) dropFirst();
+    // room for the line strip
+    m_vertices.reserve( 2 * ( m_capacity + 1 ) );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: newNode()
+// desc: a node, reused if possible
+//-----------------------------------------------------------------------------
+YLineNode * YLineChart::newNode( GLfloat x, GLfloat y )
+{
+    YLineNode * node = m_free;
+    // reuse
+    if( node ) m_free = node->next;
+    // or make a new one
+    else node = new YLineNode();
+    
+    // set
+    node->x = x;
+    node->y = y;
+    node->prev = node->next = NULL;
+    
+    return node;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: dropFirst()
+// desc: unlink the left most node, keeping it for reuse
+//-----------------------------------------------------------------------------
+void YLineChart::dropFirst()
+{
+    // the node
+    YLineNode * node = m_line;
+    if( !node ) return;
+    
+    // unlink
+    m_line = node->next;
+    if( m_line ) m_line->prev = NULL;
+    else m_last = NULL;
+    m_count--;
+    
+    // keep
+    node->prev = NULL;
+    node->next = m_free;
+    m_free = node;
 }
 
 
@@ -666,51 +735,73 @@ void YLineChart::addValue( GLfloat x, GLfloat y )
     // pointers
     YLineNode * curr = m_line;
     YLineNode * next = NULL;
+    YLineNode * node = NULL;
 
-    // find
-    while( curr != NULL )
+    // after the right most (the usual case: x is time)
+    if( m_last == NULL || m_last->x < x )
     {
-        // get next
-        next = curr->next;
-        
-        // check for duplicate
-        if( curr->x == x )
-        {
-            // update
-            curr->y = y;
-            // done
-            break;
-        }
-
-        // check
-        if( curr->x < x && ( !next || next->x > x ) )
+        // make new node
+        node = newNode( x, y );
+        // link
+        node->prev = m_last;
+        if( m_last ) m_last->next = node;
+        else m_line = node;
+        m_last = node;
+    }
+    // before the left most
+    else if( m_line->x > x )
+    {
+        // make new node
+        node = newNode( x, y );
+        // link
+        node->next = m_line;
+        m_line->prev = node;
+        m_line = node;
+    }
+    else
+    {
+        // find
+        while( curr != NULL )
         {
-            // make new node
-            YLineNode * node = new YLineNode();
-            // set
-            node->x = x;
-            node->y = y;
+            // get next
+            next = curr->next;
             
-            // link
-            node->prev = curr;
-            node->next = next;
+            // check for duplicate
+            if( curr->x == x )
+            {
+                // update
+                curr->y = y;
+                // done
+                return;
+            }
+
+            // check
+            if( curr->x < x && ( !next || next->x > x ) )
+            {
+                // make new node
+                node = newNode( x, y );
+                
+                // link
+                node->prev = curr;
+                node->next = next;
+                
+                // re-link
+                curr->next = node;
+                if( next ) next->prev = node;
+                
+                // done
+                break;
+            }
             
-            // re-link
-            curr->next = node;
-            if( next ) next->prev = node;
-            
-            // TODO: update left and right viewable
-            
-            // done
-            break;
+            // advance
+            curr = next;
         }
-        
-        // advance
-        curr = next;
     }
 
-    // zero out the list
-    m_line = NULL;
+    // count
+    if( node ) m_count++;
+    // keep to capacity
+    while( m_capacity && m_count > m_capacity ) dropFirst();
 }
 
 
@@ -720,11 +811,19 @@ void YLineChart::addValue( GLfloat x, GLfloat y )
 // name: viewX()
 // desc: set X range for viewing
 //-----------------------------------------------------------------------------
-void YLineChart::viewX( GLfloat min, GLfloat max )
+void YLineChart::viewX( GLfloat min, GLfloat max, GLfloat slew )
 {
-    // set it
-    m_leftBound.update( min );
-    m_rightBound.update( max );
+    // check slew; <= 0 means immediate
+    if( slew > 0 )
+    {
+        m_leftBound.update( min, slew );
+        m_rightBound.update( max, slew );
+    }
+    else
+    {
+        m_leftBound.updateSet( min );
+        m_rightBound.updateSet( max );
+    }
 }
 
 
@@ -734,11 +833,19 @@ void YLineChart::viewX( GLfloat min, GLfloat max )
 // name: viewY()
 // desc: set Y range for viewing
 //-----------------------------------------------------------------------------
-void YLineChart::viewY( GLfloat min, GLfloat max )
+void YLineChart::viewY( GLfloat min, GLfloat max, GLfloat slew )
 {
-    // set it
-    m_lowerBound.update( min );
-    m_upperBound.update( max );
+    // check slew; <= 0 means immediate
+    if( slew > 0 )
+    {
+        m_lowerBound.update( min, slew );
+        m_upperBound.update( max, slew );
+    }
+    else
+    {
+        m_lowerBound.updateSet( min );
+        m_upperBound.updateSet( max );
+    }
 }
 
 
@@ -755,6 +862,9 @@ void YLineChart::update( YTimeInterval dt )
     m_rightBound.interp( dt );
     m_lowerBound.interp( dt );
     m_upperBound.interp( dt );
+    
+    // the line for the new bounds
+    generate();
 }
 
 
@@ -766,6 +876,20 @@ void YLineChart::update( YTimeInterval dt )
 //-----------------------------------------------------------------------------
 void YLineChart::render()
 {
+    // check
+    if( m_vertices.size() < 4 ) return;
+    
+    // disable lighting
+    XGLState::disable( GL_LIGHTING );
+    // untextured
+    XGLState::disable( GL_TEXTURE_2D );
+    
+    // enable
+    XGLState::clientArrays( XGL_VERTEX_ARRAY );
+    // vertex
+    glVertexPointer( 2, GL_FLOAT, 0, &m_vertices[0] );
+    // line strip
+    glDrawArrays( GL_LINE_STRIP, 0, (GLsizei)( m_vertices.size() / 2 ) );
 }
 
 
@@ -773,9 +897,56 @@ void YLineChart::render()
 
 //-----------------------------------------------------------------------------
 // name: generate()
-// desc: generate stuff to render
+// desc: generate stuff to render: the nodes in the view, mapped to
+//       width x height (segments cut at the x bounds, y clamped)
 //-----------------------------------------------------------------------------
 void YLineChart::generate()
 {
+    // clear (keeps capacity)
+    m_vertices.clear();
+    m_leftViewable = m_rightViewable = NULL;
     
+    // view
+    GLfloat left = m_leftBound.value;
+    GLfloat right = m_rightBound.value;
+    GLfloat lower = m_lowerBound.value;
+    GLfloat upper = m_upperBound.value;
+    // sanity check
+    if( right <= left || upper <= lower ) return;
+    
+    // left most viewable: last node at or before the left bound
+    YLineNode * curr = m_line;
+    while( curr && curr->next && curr->next->x <= left ) curr = curr->next;
+    m_leftViewable = curr;
+    
+    // through the first node at or past the right bound
+    GLfloat xscale = m_width / ( right - left );
+    GLfloat yscale = m_height / ( upper - lower );
+    for( ; curr != NULL; curr = curr->next )
+    {
+        GLfloat x = curr->x;
+        GLfloat y = curr->y;
+        // partial segments: cut at the bound
+        if( x < left && curr->next && curr->next->x > x )
+        {
+            y += ( curr->next->y - y ) * ( left - x ) / ( curr->next->x - x );
+            x = left;
+        }
+        else if( x > right && curr->prev && curr->prev->x < x )
+        {
+            y = curr->prev->y + ( y - curr->prev->y ) * ( right - curr->prev->x ) / ( x - curr->prev->x );
+            x = right;
+        }
+        
+        // map
+        y = ( y - lower ) * yscale;
+        if( y < 0 ) y = 0;
+        if( y > m_height ) y = m_height;
+        m_vertices.push_back( ( x - left ) * xscale );
+        m_vertices.push_back( y );
+        
+        // last one
+        m_rightViewable = curr;
+        if( curr->x >= right ) break;
+    }
 }
@@ -183,14 +183,19 @@ public:
     void init( GLfloat width, GLfloat height );
     // clean up
     void cleanup();
+    // keep at most this many nodes, dropping the left most (0 == no limit);
+    // dropped nodes are reused, so a full chart adds without allocating
+    void setCapacity( unsigned long capacity );
+    // number of nodes
+    unsigned long count() const { return m_count; }
     
 public:
     // add a control node mapped to a X value
     void addValue( GLfloat x, GLfloat y );
-    // set X range for viewing
-    void viewX( GLfloat min, GLfloat max );
-    // set Y range for viewing
-    void viewY( GLfloat min, GLfloat max );
+    // set X range for viewing (slew <= 0 means immediate)
+    void viewX( GLfloat min, GLfloat max, GLfloat slew = 1 );
+    // set Y range for viewing (slew <= 0 means immediate)
+    void viewY( GLfloat min, GLfloat max, GLfloat slew = 1 );
     
 public:
     // update
@@ -201,6 +206,10 @@ public:
 protected:
     // generate stuff to render
     void generate();
+    // a node, reused if possible
+    YLineNode * newNode( GLfloat x, GLfloat y );
+    // unlink the left most node, keeping it for reuse
+    void dropFirst();
     
 protected:
     // width
@@ -210,16 +219,27 @@ protected:
     
     // the list
     YLineNode * m_line;
+    // right most node in the list
+    YLineNode * m_last;
     // left most node in viewable region (even if partial node)
     YLineNode * m_leftViewable;
     // right most node
     YLineNode * m_rightViewable;
+    // dropped nodes, for reuse
+    YLineNode * m_free;
+    // nodes in the list
+    unsigned long m_count;
+    // max nodes (0 == no limit)
+    unsigned long m_capacity;
     
     // boundaries
     Vector3D m_leftBound;
     Vector3D m_rightBound;
     Vector3D m_lowerBound;
     Vector3D m_upperBound;
+    
+    // line strip vertices (x, y)
+    std::vector<GLfloat> m_vertices;
 };
 
 
@@ -0,0 +1,295 @@
+/*----------------------------------------------------------------------------
+  MCD-Y: higher-level objects for audio/graphics/interaction programming
+         (sibling of MCD-X API)
+
+  Copyright (c) 2013 Ge Wang
+    All rights reserved.
+    http://ccrma.stanford.edu/~ge/
+
+  Music, Computing, Design Group @ CCRMA, Stanford University
+    http://ccrma.stanford.edu/groups/mcd/
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  U.S.A.
+-----------------------------------------------------------------------------*/
+
+//-----------------------------------------------------------------------------
+// name: y-drawlist.cpp
+// desc: flat draw list -- world matrices computed on the CPU, items sorted
+//       by draw key, submitted without walking the matrix stack
+//
+// name: Myles Borins
+// date: fall 2013
+//-----------------------------------------------------------------------------
+#include "y-drawlist.h"
+#include "y-profile.h"
+#include "x-fun.h"
+#include <algorithm>
+#include <math.h>
+using namespace std;
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: drawlist_merge()
+// desc: grow sphere (c, r) to enclose (c2, r2); radius 0 is empty
+//-----------------------------------------------------------------------------
+static void drawlist_merge( Vector3D & c, GLfloat & r, const Vector3D & c2, GLfloat r2 )
+{
+    if( r2 <= 0 ) return;
+    if( r <= 0 ) { c = c2; r = r2; return; }
+
+    Vector3D diff = c2 - c;
+    GLfloat d = diff.magnitude();
+    // one inside the other
+    if( d + r2 <= r ) return;
+    if( d + r <= r2 ) { c = c2; r = r2; return; }
+    // enclose both
+    GLfloat R = ( d + r + r2 ) / 2;
+    c += diff * ( ( R - r ) / d );
+    r = R;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: YDrawList()
+// desc: constructor
+//-----------------------------------------------------------------------------
+YDrawList::YDrawList()
+{
+    m_frustum = NULL;
+    m_profiler = NULL;
+    m_numNodes = 0;
+    m_numCulled = 0;
+    m_numCullTests = 0;
+    m_numTransforms = 0;
+    m_prepareTime = 0;
+    m_sortTime = 0;
+    m_submitTime = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: prepare()
+// desc: collect the active subtree under root
+//-----------------------------------------------------------------------------
+void YDrawList::prepare( YEntity * root, const XFrustum * frustum )
+{
+    double start = XFun::now();
+
+    // keeps capacity, no allocation in steady state
+    m_items.clear();
+    m_order.clear();
+    m_numNodes = 0;
+    m_numCulled = 0;
+    m_numCullTests = 0;
+    m_numTransforms = 0;
+    m_frustum = frustum;
+
+    if( root )
+    {
+        // bounds first, so a subtree can be rejected before visiting it
+        if( m_frustum ) refit( root );
+        prepare( root, NULL, m_frustum != NULL );
+    }
+
+    m_prepareTime = XFun::now() - start;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: refit()
+// desc: own geometry plus children's spheres (moved into this node's space)
+//-----------------------------------------------------------------------------
+void YDrawList::refit( YEntity * e )
+{
+    GLfloat radius = e->geometryRadius();
+    Vector3D center( 0, 0, 0 );
+    unsigned int nodes = 1;
+
+    const vector<YEntity *> & children = e->getChildren();
+    for( size_t i = 0; i < children.size(); i++ )
+    {
+        YEntity * child = children[i];
+        if( !child->active ) continue;
+        refit( child );
+        nodes += child->cullNodes;
+
+        // unbounded stays unbounded
+        if( radius < 0 ) continue;
+        if( child->cullRadius < 0 ) { radius = -1; continue; }
+        if( child->cullRadius == 0 ) continue;
+
+        // child's sphere in this space
+        const Vector3D & cc = child->cullCenter;
+        const Vector3D & sca = child->sca;
+        if( child->ori.x == 0 && child->ori.y == 0 && child->ori.z == 0 )
+        {
+            // no rotation (the common case)
+            GLfloat s = fabsf( sca.x ) > fabsf( sca.y ) ? fabsf( sca.x ) : fabsf( sca.y );
+            if( fabsf( sca.z ) > s ) s = fabsf( sca.z );
+            Vector3D c( child->loc.x + sca.x * cc.x, child->loc.y + sca.y * cc.y,
+                        child->loc.z + sca.z * cc.z );
+            drawlist_merge( center, radius, c, child->cullRadius * s );
+        }
+        else
+        {
+            XMatrix4 local;
+            local.setTransform( child->loc, child->ori, sca );
+            drawlist_merge( center, radius, local.transform( cc.x, cc.y, cc.z ),
+                            child->cullRadius * local.maxScale() );
+        }
+    }
+
+    e->cullCenter = center;
+    e->cullRadius = radius;
+    e->cullNodes = nodes;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: prepare()
+// desc: world = parent * local, cull, emit, recurse (mirrors drawAll())
+//-----------------------------------------------------------------------------
+void YDrawList::prepare( YEntity * e, const YEntity * parent, bool test )
+{
+    if( !e->active ) return;
+
+    // this node's world transform (cached in the node until it or a
+    // parent moves)
+    unsigned int version = e->getWorldVersion();
+    const XMatrix4 & world = e->updateWorld( parent );
+    if( e->getWorldVersion() != version ) m_numTransforms++;
+
+    // the whole subtree in one test
+    if( test && e->cullRadius >= 0 )
+    {
+        // nothing to draw down here
+        if( e->cullRadius == 0 ) return;
+
+        m_numCullTests++;
+        Vector3D c = world.transform( e->cullCenter.x, e->cullCenter.y, e->cullCenter.z );
+        int side = m_frustum->classify( c, e->cullRadius * world.maxScale() );
+        if( side < 0 )
+        {
+            m_numCulled += e->cullNodes;
+            return;
+        }
+        // entirely inside: no need to test below
+        if( side > 0 ) test = false;
+    }
+    m_numNodes++;
+
+    // emit
+    unsigned int key = e->drawKey();
+    if( !e->hidden && key != YDRAW_KEY_NONE )
+    {
+        m_order.push_back( ( (unsigned long long)key << 32 ) | m_items.size() );
+        m_items.push_back( YDrawItem() );
+        m_items.back().entity = e;
+        m_items.back().world = &world;
+    }
+
+    // children
+    const vector<YEntity *> & children = e->getChildren();
+    for( size_t i = 0; i < children.size(); i++ )
+        prepare( children[i], e, test );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: sort()
+// desc: by key; the index in the low bits keeps scene order within a key
+//-----------------------------------------------------------------------------
+void YDrawList::sort()
+{
+    double start = XFun::now();
+    std::sort( m_order.begin(), m_order.end() );
+    m_sortTime = XFun::now() - start;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: lowerBound()
+// desc: first sorted index with key >= k
+//-----------------------------------------------------------------------------
+size_t YDrawList::lowerBound( unsigned int k ) const
+{
+    return std::lower_bound( m_order.begin(), m_order.end(),
+                             (unsigned long long)k << 32 ) - m_order.begin();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: submit()
+// desc: one matrix load per item instead of a push/pop per node
+//-----------------------------------------------------------------------------
+void YDrawList::submit( size_t first, size_t last )
+{
+    double start = XFun::now();
+
+    // the camera
+    XMatrix4 view;
+    glGetFloatv( GL_MODELVIEW_MATRIX, view.m );
+
+    // profiling: consecutive items of one type are timed together
+    const type_info * runType = NULL;
+    double runStart = 0;
+    size_t runCount = 0;
+
+    glPushMatrix();
+    for( size_t i = first; i < last && i < m_order.size(); i++ )
+    {
+        const YDrawItem & it = item( i );
+        if( m_profiler )
+        {
+            const type_info & type = typeid( *it.entity );
+            if( !runType || type != *runType )
+            {
+                double now = XFun::now();
+                if( runType ) m_profiler->addRender( *runType, now - runStart, runCount );
+                runType = &type;
+                runStart = now;
+                runCount = 0;
+            }
+            runCount++;
+        }
+        XMatrix4 modelview;
+        modelview.mulAffine( view, *it.world );
+        glLoadMatrixf( modelview.m );
+        // color (as applyTransforms)
+        glColor4f( it.entity->col.x, it.entity->col.y, it.entity->col.z, it.entity->alpha );
+        it.entity->render();
+    }
+    glPopMatrix();
+    if( runType ) m_profiler->addRender( *runType, XFun::now() - runStart, runCount );
+
+    m_submitTime = XFun::now() - start;
+}
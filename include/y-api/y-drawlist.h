@@ -0,0 +1,135 @@
+/*----------------------------------------------------------------------------
+  MCD-Y: higher-level objects for audio/graphics/interaction programming
+         (sibling of MCD-X API)
+
+  Copyright (c) 2013 Ge Wang
+    All rights reserved.
+    http://ccrma.stanford.edu/~ge/
+
+  Music, Computing, Design Group @ CCRMA, Stanford University
+    http://ccrma.stanford.edu/groups/mcd/
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  U.S.A.
+-----------------------------------------------------------------------------*/
+
+//-----------------------------------------------------------------------------
+// name: y-drawlist.h
+// desc: flat draw list -- world matrices computed on the CPU, items sorted
+//       by draw key, submitted without walking the matrix stack
+//
+// name: Myles Borins
+// date: fall 2013
+//-----------------------------------------------------------------------------
+#ifndef __MCD_Y_DRAWLIST_H__
+#define __MCD_Y_DRAWLIST_H__
+
+#include "y-entity.h"
+#include <vector>
+
+class YSceneProfiler;
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: struct YDrawItem
+// desc: one entity to render and its world transform (the entity's cached
+//       one: valid until the next prepare)
+//-----------------------------------------------------------------------------
+struct YDrawItem
+{
+    YEntity * entity;
+    const XMatrix4 * world;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class YDrawList
+// desc: replaces drawAll() -- prepare() walks the tree once composing world
+//       matrices (each node from its parent's), optionally rejecting whole
+//       subtrees whose bounding sphere is outside the view frustum; sort()
+//       groups items by YEntity::drawKey() keeping scene order within a key,
+//       submit() loads view * world per item and renders it
+//-----------------------------------------------------------------------------
+class YDrawList
+{
+public:
+    YDrawList();
+
+public:
+    // collect the active subtree under root (no GL calls); with a frustum
+    // (in world space), skips subtrees entirely outside it
+    void prepare( YEntity * root, const XFrustum * frustum = NULL );
+    // order by draw key (stable)
+    void sort();
+    // render items [first, last) in sorted order (needs the view matrix on
+    // the modelview stack; leaves it there)
+    void submit( size_t first, size_t last );
+    // render everything
+    void submit() { submit( 0, size() ); }
+    // add render time per type to a profiler (NULL: don't)
+    void setProfiler( YSceneProfiler * profiler ) { m_profiler = profiler; }
+
+public:
+    // number of items
+    size_t size() const { return m_order.size(); }
+    // i-th item in sorted order
+    const YDrawItem & item( size_t i ) const { return m_items[(size_t)( m_order[i] & 0xffffffff )]; }
+    // draw key of the i-th item in sorted order
+    unsigned int key( size_t i ) const { return (unsigned int)( m_order[i] >> 32 ); }
+    // first sorted index with key >= k
+    size_t lowerBound( unsigned int k ) const;
+    // stats (last prepare / sort / submit, seconds)
+    size_t numNodes() const { return m_numNodes; }
+    // nodes rejected by the frustum, and sphere tests done, last prepare
+    size_t numCulled() const { return m_numCulled; }
+    size_t numCullTests() const { return m_numCullTests; }
+    // world transforms recomputed (the rest were cached), last prepare
+    size_t numTransforms() const { return m_numTransforms; }
+    double prepareTime() const { return m_prepareTime; }
+    double sortTime() const { return m_sortTime; }
+    double submitTime() const { return m_submitTime; }
+
+protected:
+    // bottom-up: bounding spheres in local space
+    void refit( YEntity * e );
+    // top-down: world matrices, culling, items
+    void prepare( YEntity * e, const YEntity * parent, bool test );
+
+protected:
+    // items in scene order
+    std::vector<YDrawItem> m_items;
+    // (key << 32 | item index), sorted
+    std::vector<unsigned long long> m_order;
+    // frustum for this prepare (NULL: no culling)
+    const XFrustum * m_frustum;
+    YSceneProfiler * m_profiler;
+    // stats
+    size_t m_numNodes;
+    size_t m_numCulled;
+    size_t m_numCullTests;
+    size_t m_numTransforms;
+    double m_prepareTime;
+    double m_sortTime;
+    double m_submitTime;
+};
+
+
+
+
+#endif
@@ -40,6 +40,22 @@ using namespace std;
 
 
 
+//-----------------------------------------------------------------------------
+// name: y_opaque()
+// desc: state for solid geometry -- renders leave their state set, so
+//       anything drawn after a blended / textured entity declares it off
+//-----------------------------------------------------------------------------
+static void y_opaque( unsigned int arrays )
+{
+    XGLState::disable( GL_BLEND );
+    XGLState::disable( GL_TEXTURE_2D );
+    XGLState::depthMask( GL_TRUE );
+    XGLState::clientArrays( arrays );
+}
+
+
+
+
 //-----------------------------------------------------------------------------
 // name: updateAll()
 // desc: updates with all children
@@ -158,7 +174,102 @@ void YEntity::drawAll()
 void YEntity::addChild( YEntity * child )
 {
     child->parent = this;
+    child->worldParentVersion = 0;
+    child->childIndex = (unsigned int)children.size();
     children.push_back( child ); 
+    treeChanged();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: treeChanged()
+// desc: a node was added or removed below; tell the root
+//-----------------------------------------------------------------------------
+void YEntity::treeChanged()
+{
+    YEntity * root = this;
+    while( root->parent ) root = root->parent;
+    root->treeVersion++;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: updateWorld()
+// desc: parent's world * local, unless nothing it depends on changed
+//-----------------------------------------------------------------------------
+const XMatrix4 & YEntity::updateWorld( const YEntity * above )
+{
+    // (a computed version is never 0; 1 stands for the root's identity)
+    unsigned int version = above ? above->worldVersion : 1;
+    if( worldParentVersion == version &&
+        loc.x == worldLoc.x && loc.y == worldLoc.y && loc.z == worldLoc.z &&
+        ori.x == worldOri.x && ori.y == worldOri.y && ori.z == worldOri.z &&
+        sca.x == worldSca.x && sca.y == worldSca.y && sca.z == worldSca.z )
+        return worldMatrix;
+
+    XMatrix4 local;
+    local.setTransform( loc, ori, sca );
+    if( above ) worldMatrix.mulAffine( above->worldMatrix, local );
+    else worldMatrix = local;
+
+    worldLoc = loc; worldOri = ori; worldSca = sca;
+    worldParentVersion = version;
+    if( ++worldVersion == 0 ) worldVersion = 1;
+    return worldMatrix;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: removeChild()
+// desc: remove a child (does not delete it)
+//-----------------------------------------------------------------------------
+void YEntity::removeChild( YEntity * child )
+{
+    // find
+    for( vector<YEntity *>::iterator itr = children.begin();
+         itr != children.end(); itr++ )
+    {
+        if( *itr == child )
+        {
+            // remove
+            itr = children.erase( itr );
+            child->parent = NULL;
+            child->worldParentVersion = 0;
+            // the ones after it moved up
+            for( ; itr != children.end(); itr++ )
+                (*itr)->childIndex--;
+            treeChanged();
+            return;
+        }
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: swapRemoveChild()
+// desc: remove a child; the last child takes its place
+//-----------------------------------------------------------------------------
+void YEntity::swapRemoveChild( YEntity * child )
+{
+    // check
+    if( child->parent != this ) return;
+
+    YEntity * last = children.back();
+    children[child->childIndex] = last;
+    last->childIndex = child->childIndex;
+    children.pop_back();
+
+    child->parent = NULL;
+    child->worldParentVersion = 0;
+    treeChanged();
 }
 
 
@@ -176,10 +287,34 @@ void YEntity::removeAllChildren()
     {
         // clear
         children[i]->parent = NULL;
+        children[i]->worldParentVersion = 0;
     }
     
     // clear
     children.clear();
+    treeChanged();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: deleteChildren()
+// desc: remove and delete all children; last first, so slab allocated
+//       children leave their slots to be reused in the order they were made
+//-----------------------------------------------------------------------------
+void YEntity::deleteChildren()
+{
+    // copy, since children must be removed before they are deleted
+    vector<YEntity *> doomed;
+    doomed.swap( children );
+    for( size_t i = 0; i < doomed.size(); i++ )
+        doomed[i]->parent = NULL;
+    treeChanged();
+    
+    // delete
+    for( size_t i = doomed.size(); i > 0; i-- )
+        delete doomed[i-1];
 }
 
 
@@ -212,14 +347,10 @@ void YEntity::applyTransforms()
 {
     // push
     glPushMatrix();
-    // translate
-    glTranslatef( loc.x, loc.y, loc.z );
-    // rotate
-    glRotatef( ori.z, 0.0f, 0.0f, 1.0f );
-    glRotatef( ori.y, 0.0f, 1.0f, 0.0f );
-    glRotatef( ori.x, 1.0f, 0.0f, 0.0f );
-    // scale
-    glScalef( sca.x, sca.y, sca.z );
+    // translate * rotate (z, y, x) * scale, as one matrix
+    XMatrix4 local;
+    local.setTransform( loc, ori, sca );
+    glMultMatrixf( local.m );
     // color
     glColor4f( col.x, col.y, col.z, alpha );
 }
@@ -420,10 +551,12 @@ void YText::update( YTimeInterval dt )
 void YText::render()
 {
     // blend
-    glEnable( GL_BLEND );
-    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    XGLState::enable( GL_BLEND );
+    XGLState::blendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
     // lighting
-    glDisable( GL_LIGHTING );
+    XGLState::disable( GL_LIGHTING );
+    // untextured
+    XGLState::disable( GL_TEXTURE_2D );
     
     // set the linewidth
     glLineWidth( m_width );
@@ -591,29 +724,27 @@ void YFlare::update( YTimeInterval dt )
 void YFlare::render()
 {
     // disable lighting
-    glDisable( GL_LIGHTING );
+    XGLState::disable( GL_LIGHTING );
     // depth
-    if( use_depth ) glEnable( GL_DEPTH_TEST );
-    else glDisable( GL_DEPTH_TEST );
+    if( use_depth ) XGLState::enable( GL_DEPTH_TEST );
+    else XGLState::disable( GL_DEPTH_TEST );
     // disable writing
-    glDepthMask( GL_FALSE );
+    XGLState::depthMask( GL_FALSE );
 
     // enable texture mapping
-    glEnable( GL_TEXTURE_2D );
+    XGLState::enable( GL_TEXTURE_2D );
     // enable blending
-    glEnable( GL_BLEND );
+    XGLState::enable( GL_BLEND );
     // blend function
-    // glBlendFunc( GL_ONE, GL_ONE );
-    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    // XGLState::blendFunc( GL_ONE, GL_ONE );
+    XGLState::blendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
     // bind the texture
-    glBindTexture( GL_TEXTURE_2D, texture );
+    XGLState::bindTexture( texture );
 
     glPushMatrix();
 
     // enable
-    glEnableClientState( GL_VERTEX_ARRAY );
-    // glEnableClientState( GL_NORMAL_ARRAY );
-    glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+    XGLState::clientArrays( XGL_VERTEX_ARRAY | XGL_TEXCOORD_ARRAY );
 
     // vertex
     glVertexPointer( 2, GL_FLOAT, 0, vertices );
@@ -627,18 +758,7 @@ void YFlare::render()
     // triangle strip
     glDrawArrays( GL_TRIANGLE_STRIP, 0, 4 );
 
-    // disable
-    glDisableClientState( GL_VERTEX_ARRAY );
-    // glDisableClientState( GL_NORMAL_ARRAY );
-    glDisableClientState( GL_TEXTURE_COORD_ARRAY );
-
     glPopMatrix();
-
-    // disable
-    glDisable( GL_TEXTURE_2D );
-    glDisable( GL_BLEND );
-    // enable writing
-    glDepthMask( GL_TRUE );
 }
 
 
@@ -717,27 +837,25 @@ void YBokeh::update( YTimeInterval dt )
 void YBokeh::render()
 {
     // disable lighting
-    glDisable( GL_LIGHTING );
+    XGLState::disable( GL_LIGHTING );
     // depth
-    glEnable( GL_DEPTH_TEST );
+    XGLState::enable( GL_DEPTH_TEST );
     // disable writing
-    glDepthMask( GL_FALSE );
+    XGLState::depthMask( GL_FALSE );
     
     // enable blending
-    glEnable( GL_BLEND );
+    XGLState::enable( GL_BLEND );
     // blend function
-    glBlendFunc( GL_ONE, GL_ONE );
+    XGLState::blendFunc( GL_ONE, GL_ONE );
     // enable texture mapping
-    glEnable( GL_TEXTURE_2D );
+    XGLState::enable( GL_TEXTURE_2D );
     // bind the texture
-    glBindTexture( GL_TEXTURE_2D, texture );
+    XGLState::bindTexture( texture );
     
     glPushMatrix();
     
     // enable
-    glEnableClientState( GL_VERTEX_ARRAY );
-    glEnableClientState( GL_NORMAL_ARRAY );
-    glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+    XGLState::clientArrays( XGL_VERTEX_ARRAY | XGL_NORMAL_ARRAY | XGL_TEXCOORD_ARRAY );
     
     // modulate the scale
     scale_actual = scale * (.7 + .25*::cos( t*2*M_PI*f ));
@@ -774,19 +892,7 @@ void YBokeh::render()
 		oscillate = false;
 	}
     
-    // disable
-    glDisableClientState( GL_VERTEX_ARRAY );
-    glDisableClientState( GL_NORMAL_ARRAY );
-    glDisableClientState( GL_TEXTURE_COORD_ARRAY );
-    
     glPopMatrix();
-    
-    // disable
-    glDisable( GL_TEXTURE_2D );
-    glDisable( GL_BLEND );
-    // enable writing
-    glDepthMask( GL_TRUE );
-    
 }
 
 
@@ -1017,31 +1123,29 @@ void YFlarePool::render()
 void YColumn::render()
 {
     // disable lighting
-    glDisable( GL_LIGHTING );
+    XGLState::disable( GL_LIGHTING );
     
     // disable depth
-    // glDisable( GL_DEPTH_TEST );
+    // XGLState::disable( GL_DEPTH_TEST );
     // enable depth
-    glEnable( GL_DEPTH_TEST );
+    XGLState::enable( GL_DEPTH_TEST );
     
     // disable writing
-    glDepthMask( GL_FALSE );
+    XGLState::depthMask( GL_FALSE );
     
     // enable blending
-    glEnable( GL_BLEND );
+    XGLState::enable( GL_BLEND );
     // blend function
-    glBlendFunc( GL_ONE, GL_ONE );
+    XGLState::blendFunc( GL_ONE, GL_ONE );
     // enable texture mapping
-    glEnable( GL_TEXTURE_2D );
+    XGLState::enable( GL_TEXTURE_2D );
     // bind the texture
-    glBindTexture( GL_TEXTURE_2D, texture );
+    XGLState::bindTexture( texture );
     
     glPushMatrix();
     
     // enable
-    glEnableClientState( GL_VERTEX_ARRAY );
-    glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-    glEnableClientState( GL_COLOR_ARRAY );
+    XGLState::clientArrays( XGL_VERTEX_ARRAY | XGL_TEXCOORD_ARRAY | XGL_COLOR_ARRAY );
     
     // HACK: fudge
     GLfloat fudge = 1.0f / numLayers;
@@ -1083,20 +1187,8 @@ void YColumn::render()
         // rotate
         glRotatef( 180.0f / numLayers, 0, 1, 0 );
     }
-
-    // disable
-    glDisableClientState( GL_VERTEX_ARRAY );
-    glDisableClientState( GL_TEXTURE_COORD_ARRAY );
-    glDisableClientState( GL_COLOR_ARRAY );
     
     glPopMatrix();
-    
-    // disable
-    glDisable( GL_TEXTURE_2D );
-    glDisable( GL_BLEND );
-    
-    // enable writing
-    glDepthMask( GL_TRUE );
 }
 
 
@@ -1279,9 +1371,8 @@ static const GLfloat g_squareNormals[] =
 //-----------------------------------------------------------------------------
 void YCube::render()
 {
-    // enable state
-    glEnableClientState( GL_VERTEX_ARRAY );
-    glEnableClientState( GL_NORMAL_ARRAY );
+    // state
+    y_opaque( XGL_VERTEX_ARRAY | XGL_NORMAL_ARRAY );
 
     // set vertex pointer
     glVertexPointer( 3, GL_FLOAT, 0, g_squareVertices );
@@ -1302,10 +1393,6 @@ void YCube::render()
     
     // pop
     glPopMatrix();
-    
-    // disable
-    glDisableClientState( GL_VERTEX_ARRAY );
-    glDisableClientState( GL_NORMAL_ARRAY );
 }
 
 
@@ -1331,9 +1418,8 @@ void YCube::update( YTimeInterval dt )
 void YCubeOutline::render()
 {
     
-    // enable state
-    glEnableClientState( GL_VERTEX_ARRAY );
-    glEnableClientState( GL_NORMAL_ARRAY );
+    // state
+    y_opaque( XGL_VERTEX_ARRAY | XGL_NORMAL_ARRAY );
     
     // set vertex pointer
     glVertexPointer( 3, GL_FLOAT, 0, g_squareVertices );
@@ -1354,15 +1440,14 @@ void YCubeOutline::render()
     
     // color
     glColor4f( outlineColor.x, outlineColor.y, outlineColor.z, 1.0f );
-    // draw outline
+    // draw outline (glut draws with arrays of its own, from none enabled)
+    XGLState::clientArrays( 0 );
     glutWireCube( 1.025f );
+    // (glut changes state behind the cache)
+    XGLState::invalidate();
     
     // pop
     glPopMatrix();
-    
-    // disable
-    glDisableClientState( GL_VERTEX_ARRAY );
-    glDisableClientState( GL_NORMAL_ARRAY );
 }
 
 
@@ -1425,8 +1510,12 @@ void YCubeOutline::update( YTimeInterval dt )
 //-----------------------------------------------------------------------------
 void YSphere::render()
 {
+    // state (glut draws with arrays of its own, from none enabled)
+    y_opaque( 0 );
     // render
     glutSolidSphere( size.value, slices, stacks );
+    // (glut changes state behind the cache)
+    XGLState::invalidate();
 }
 
 
@@ -1452,8 +1541,12 @@ void YSphere::update( YTimeInterval dt )
 //-----------------------------------------------------------------------------
 void YCone::render()
 {
+    // state (glut draws with arrays of its own, from none enabled)
+    y_opaque( 0 );
     // render
     glutSolidCone( base.value * size.value, height.value * size.value, slices, stacks );
+    // (glut changes state behind the cache)
+    XGLState::invalidate();
 }
 
 
@@ -1837,11 +1930,10 @@ void YIris::render()
     glPushMatrix();
     
     // enable
-    glEnable( GL_DEPTH_TEST );
+    XGLState::enable( GL_DEPTH_TEST );
     
     // enable
-    glEnableClientState( GL_VERTEX_ARRAY );
-    glEnableClientState( GL_NORMAL_ARRAY );
+    y_opaque( XGL_VERTEX_ARRAY | XGL_NORMAL_ARRAY );
     
     // vertex
     glVertexPointer( 3, GL_FLOAT, 0, g_irisVerts );
@@ -1864,7 +1956,7 @@ void YIris::render()
     // color
     glColor4f( col.x, col.y, col.z, 1 );
     // enable lighting
-    glEnable( GL_LIGHTING );
+    XGLState::enable( GL_LIGHTING );
     // loop overs
     for( int i = 0; i < m_numBlades; i++ )
     {
@@ -1889,9 +1981,9 @@ void YIris::render()
     // linewidth
     glLineWidth( m_outlineWidth );
     // no lighting
-    glDisable( GL_LIGHTING );
+    XGLState::disable( GL_LIGHTING );
     // no normal
-    glDisableClientState( GL_NORMAL_ARRAY );
+    XGLState::disableClientState( GL_NORMAL_ARRAY );
     // second pass for outline
     for( int i = 0; i < m_numBlades; i++ )
     {
@@ -1909,9 +2001,6 @@ void YIris::render()
         glPopMatrix();
     }
     
-    // disable
-    glDisableClientState( GL_VERTEX_ARRAY );
-    
     // pop
     glPopMatrix();
 }
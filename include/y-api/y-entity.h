@@ -49,6 +49,9 @@ typedef void (EntityBlock)( YEntity * );
 // the data type to use for elapsed time
 typedef double YTimeInterval;
 
+// draw key of entities that render nothing (see YEntity::drawKey)
+#define YDRAW_KEY_NONE 0xffffffff
+
 
 
 
@@ -62,16 +65,31 @@ class YEntity
 public:
     // constructor
     YEntity() : parent(NULL), sca(1, 1, 1), col(1, 1, 1), alpha(1), 
-            active(true), selected(false), hidden(false) { }
+            active(true), selected(false), hidden(false),
+            cullRadius(-1), cullNodes(1), childIndex(0), treeVersion(0),
+            worldVersion(0), worldParentVersion(0) { }
+    // destructor (virtual: nodes are deleted through YEntity pointers)
+    virtual ~YEntity() { }
 
 public:
-    // use this for anything that even remotely effects the world state.
+    // use this for anything that even remotely effects the world state
     virtual void update( YTimeInterval dt ) { }
     // renders entity (assumes transforms, etc have been applied)
     virtual void render() { }
+    // groups entities that share GL state in a YDrawList (lower draws first;
+    // YDRAW_KEY_NONE if render() draws nothing)
+    virtual unsigned int drawKey() const { return 0; }
+    // radius around the local origin of what render() draws (0 if nothing,
+    // < 0 if unknown -- never culled)
+    virtual GLfloat geometryRadius() const { return -1; }
     // updates you need to do after render; this is somewhat of a hack,
     // needed by FX to get GL state in render before it can update
     virtual void updatePostRender( YTimeInterval dt ) {}
+    // batch that updates this node in a YUpdateScheduler, as returned by
+    // YUpdateScheduler::registerBatch (-1: update() one node at a time);
+    // a batch only takes the type it was registered for, so a subclass that
+    // inherits this runs update() one node at a time
+    virtual int updateBatch() const { return -1; }
     
 public:
     // updates with all children
@@ -84,13 +102,34 @@ public:
 public:
     // add child
     void addChild( YEntity * child );
+    // remove a child (does not delete it)
+    void removeChild( YEntity * child );
+    // remove a child in constant time by moving the last child into its
+    // place (changes the order of the others; does not delete it)
+    void swapRemoveChild( YEntity * child );
     // remove all children (NOTE: this must be done BEFORE any child is deleted)
     void removeAllChildren();
+    // remove and delete all children -- tears down a subtree of nodes made
+    // with new (each child's destructor deletes what it owns below it)
+    void deleteChildren();
+    // child nodes (read only)
+    const std::vector<YEntity *> & getChildren() const { return children; }
+    // changes whenever a node is added to or removed from the tree below
+    // (meaningful on the root)
+    unsigned long getTreeVersion() const { return treeVersion; }
     // self or any parent selected?
     bool anyParentSelected();
 
     // apply a block to this entire subtree
     void apply( EntityBlock block );
+    // world transform from the parent's (NULL: this is the root), which
+    // must be current; recomputed only if loc / ori / sca or the parent's
+    // transform changed since the last call
+    const XMatrix4 & updateWorld( const YEntity * above );
+    // the last one computed, and a count that changes with it
+    const XMatrix4 & getWorld() const { return worldMatrix; }
+    unsigned int getWorldVersion() const { return worldVersion; }
+
     // print out a scene graph to the console for your amusement
     void dumpSceneGraph( int depth = 0 );
     // set the color of this and all children
@@ -100,6 +139,9 @@ public:
 
     // description
     virtual std::string desc() const;
+    // bytes this node takes: the object and what it allocates, not its
+    // children (types without their own report their base's)
+    virtual size_t footprint() const { return sizeof(YEntity) + heapBytes(); }
 
 public:
     // location
@@ -126,18 +168,40 @@ public:
     bool selected;
     // name
     std::string name;
+    
+public:
+    // bounding sphere of this subtree in local space (radius < 0: unbounded),
+    // and the number of nodes in it -- refit by YDrawList for culling
+    Vector3D cullCenter;
+    GLfloat cullRadius;
+    unsigned int cullNodes;
 
 protected:
     // applies translation, rotation, etc
     void applyTransforms();
     // pop
     void popTransforms();
+    // bump the root's tree version
+    void treeChanged();
+    // what every node allocates (the child list)
+    size_t heapBytes() const { return children.capacity() * sizeof(YEntity *); }
     
 protected: // never set these directly, always use addChild
     // parent in the scene graph
     YEntity * parent;
     // child nodes in the scene graph
     std::vector<YEntity *> children;
+    // where this node is in its parent's children
+    unsigned int childIndex;
+    // see getTreeVersion()
+    unsigned long treeVersion;
+    // cached world transform (see updateWorld), with the loc / ori / sca
+    // and parent version it was computed from (0: compute; reset when the
+    // node changes parents)
+    XMatrix4 worldMatrix;
+    unsigned int worldVersion;
+    unsigned int worldParentVersion;
+    Vector3D worldLoc, worldOri, worldSca;
     
 private:
     // make sure no subclasses are using the old
@@ -180,6 +244,8 @@ public:
 public:
     // static draw method
     static void drawString( const std::string & text );
+    // with the text
+    size_t footprint() const { return sizeof(YText) + heapBytes() + m_text.capacity(); }
 
 protected:
     // the text
@@ -23,284 +23,605 @@
   along with this program; if not, write to the Free Software
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
   U.S.A.
------------------------------------------------------------------------------*/
-
-//-----------------------------------------------------------------------------
-// name: yfft.cpp
-// desc: fft impl - based on CARL distribution and chuck_fft.*
-//
-// authors: code from San Diego CARL package
-//          Ge Wang (ge@ccrma.stanford.edu)
-// date: spring 2013
-//-----------------------------------------------------------------------------
-#include "y-fft.h"
-#include <stdlib.h>
-#include <math.h>
-
-
-
-
-//-----------------------------------------------------------------------------
-// name: hanning()
-// desc: make window
-//-----------------------------------------------------------------------------
-void hanning( SAMPLE * window, unsigned long length )
-{
-    unsigned long i;
-    double pi, phase = 0, delta;
-
-    pi = 4.*atan(1.0);
-    delta = 2 * pi / (double) length;
-
-    for( i = 0; i < length; i++ )
-    {
-        window[i] = (SAMPLE)(0.5 * (1.0 - cos(phase)));
-        phase += delta;
-    }
-}
-
-
-
-
-//-----------------------------------------------------------------------------
-// name: hamming()
-// desc: make window
-//-----------------------------------------------------------------------------
-void hamming( SAMPLE * window, unsigned long length )
-{
-    unsigned long i;
-    double pi, phase = 0, delta;
-
-    pi = 4.*atan(1.0);
-    delta = 2 * pi / (double) length;
-
-    for( i = 0; i < length; i++ )
-    {
-        window[i] = (SAMPLE)(0.54 - .46*cos(phase));
-        phase += delta;
-    }
-}
-
-
-
-//-----------------------------------------------------------------------------
-// name: blackman()
-// desc: make window
-//-----------------------------------------------------------------------------
-void blackman( SAMPLE * window, unsigned long length )
-{
-    unsigned long i;
-    double pi, phase = 0, delta;
-
-    pi = 4.*atan(1.0);
-    delta = 2 * pi / (double) length;
-
-    for( i = 0; i < length; i++ )
-    {
-        window[i] = (SAMPLE)(0.42 - .5*cos(phase) + .08*cos(2*phase));
-        phase += delta;
-    }
-}
-
-
-
-
-//-----------------------------------------------------------------------------
-// name: apply_window()
-// desc: apply a window to data
-//-----------------------------------------------------------------------------
-void apply_window( SAMPLE * data, SAMPLE * window, unsigned long length )
-{
-    unsigned long i;
-
-    for( i = 0; i < length; i++ )
-        data[i] *= window[i];
-}
-
-static SAMPLE PI ;
-static SAMPLE TWOPI ;
-void bit_reverse( SAMPLE * x, long N );
-
-//-----------------------------------------------------------------------------
-// name: rfft()
-// desc: real value fft
-//
-//   these routines from the CARL software, spect.c
-//   check out the CARL CMusic distribution for more source code
-//
-//   if forward is true, rfft replaces 2*N real data points in x with N complex 
-//   values representing the positive frequency half of their Fourier spectrum,
-//   with x[1] replaced with the real part of the Nyquist frequency value.
-//
-//   if forward is false, rfft expects x to contain a positive frequency 
-//   spectrum arranged as before, and replaces it with 2*N real values.
-//
-//   N MUST be a power of 2.
-//
-//-----------------------------------------------------------------------------
-void rfft( SAMPLE * x, long N, unsigned int forward )
-{
-    static int first = 1 ;
-    SAMPLE c1, c2, h1r, h1i, h2r, h2i, wr, wi, wpr, wpi, temp, theta ;
-    SAMPLE xr, xi ;
-    long i, i1, i2, i3, i4, N2p1 ;
-
-    if( first )
-    {
-        PI = (SAMPLE) (4.*atan( 1. )) ;
-        TWOPI = (SAMPLE) (8.*atan( 1. )) ;
-        first = 0 ;
-    }
-
-    theta = PI/N ;
-    wr = 1. ;
-    wi = 0. ;
-    c1 = 0.5 ;
-
-    if( forward )
-    {
-        c2 = -0.5 ;
-        cfft( x, N, forward ) ;
-        xr = x[0] ;
-        xi = x[1] ;
-    }
-    else
-    {
-        c2 = 0.5 ;
-        theta = -theta ;
-        xr = x[1] ;
-        xi = 0. ;
-        x[1] = 0. ;
-    }
-    
-    wpr = (SAMPLE) (-2.*pow( sin( 0.5*theta ), 2. )) ;
-    wpi = (SAMPLE) sin( theta ) ;
-    N2p1 = (N<<1) + 1 ;
-    
-    for( i = 0 ; i <= N>>1 ; i++ )
-    {
-        i1 = i<<1 ;
-        i2 = i1 + 1 ;
-        i3 = N2p1 - i2 ;
-        i4 = i3 + 1 ;
-        if( i == 0 )
-        {
-            h1r =  c1*(x[i1] + xr ) ;
-            h1i =  c1*(x[i2] - xi ) ;
-            h2r = -c2*(x[i2] + xi ) ;
-            h2i =  c2*(x[i1] - xr ) ;
-            x[i1] =  h1r + wr*h2r - wi*h2i ;
-            x[i2] =  h1i + wr*h2i + wi*h2r ;
-            xr =  h1r - wr*h2r + wi*h2i ;
-            xi = -h1i + wr*h2i + wi*h2r ;
-        }
-        else
-        {
-            h1r =  c1*(x[i1] + x[i3] ) ;
-            h1i =  c1*(x[i2] - x[i4] ) ;
-            h2r = -c2*(x[i2] + x[i4] ) ;
-            h2i =  c2*(x[i1] - x[i3] ) ;
-            x[i1] =  h1r + wr*h2r - wi*h2i ;
-            x[i2] =  h1i + wr*h2i + wi*h2r ;
-            x[i3] =  h1r - wr*h2r + wi*h2i ;
-            x[i4] = -h1i + wr*h2i + wi*h2r ;
-        }
-
-        wr = (temp = wr)*wpr - wi*wpi + wr ;
-        wi = wi*wpr + temp*wpi + wi ;
-    }
-
-    if( forward )
-        x[1] = xr ;
-    else
-        cfft( x, N, forward ) ;
-}
-
-
-
-
-//-----------------------------------------------------------------------------
-// name: cfft()
-// desc: complex value fft
-//
-//   these routines from CARL software, spect.c
-//   check out the CARL CMusic distribution for more software
-//
-//   cfft replaces float array x containing NC complex values (2*NC float 
-//   values alternating real, imagininary, etc.) by its Fourier transform 
-//   if forward is true, or by its inverse Fourier transform ifforward is 
-//   false, using a recursive Fast Fourier transform method due to 
-//   Danielson and Lanczos.
-//
-//   NC MUST be a power of 2.
-//
-//-----------------------------------------------------------------------------
-void cfft( SAMPLE * x, long NC, unsigned int forward )
-{
-    SAMPLE wr, wi, wpr, wpi, theta, scale ;
-    long mmax, ND, m, i, j, delta ;
-    ND = NC<<1 ;
-    bit_reverse( x, ND ) ;
-    
-    for( mmax = 2 ; mmax < ND ; mmax = delta )
-    {
-        delta = mmax<<1 ;
-        theta = TWOPI/( forward? mmax : -mmax ) ;
-        wpr = (SAMPLE) (-2.*pow( sin( 0.5*theta ), 2. )) ;
-        wpi = (SAMPLE) sin( theta ) ;
-        wr = 1. ;
-        wi = 0. ;
-
-        for( m = 0 ; m < mmax ; m += 2 )
-        {
-            register SAMPLE rtemp, itemp ;
-            for( i = m ; i < ND ; i += delta )
-            {
-                j = i + mmax ;
-                rtemp = wr*x[j] - wi*x[j+1] ;
-                itemp = wr*x[j+1] + wi*x[j] ;
-                x[j] = x[i] - rtemp ;
-                x[j+1] = x[i+1] - itemp ;
-                x[i] += rtemp ;
-                x[i+1] += itemp ;
-            }
-
-            wr = (rtemp = wr)*wpr - wi*wpi + wr ;
-            wi = wi*wpr + rtemp*wpi + wi ;
-        }
-    }
-
-    // scale output
-    scale = (SAMPLE)(forward ? 1./ND : 2.) ;
-    {
-        register SAMPLE *xi=x, *xe=x+ND ;
-        while( xi < xe )
-            *xi++ *= scale ;
-    }
-}
-
-
-
-
-//-----------------------------------------------------------------------------
-// name: bit_reverse()
-// desc: bitreverse places float array x containing N/2 complex values
-//       into bit-reversed order
-//-----------------------------------------------------------------------------
-void bit_reverse( SAMPLE * x, long N )
-{
-    SAMPLE rtemp, itemp ;
-    long i, j, m ;
-    for( i = j = 0 ; i < N ; i += 2, j += m )
-    {
-        if( j > i )
-        {
-            rtemp = x[j] ; itemp = x[j+1] ; /* complex exchange */
-            x[j] = x[i] ; x[j+1] = x[i+1] ;
-            x[i] = rtemp ; x[i+1] = itemp ;
-        }
-
-        for( m = N>>1 ; m >= 2 && j >= m ; m >>= 1 )
-            j -= m ;
-    }
-}
+-----------------------------------------------------------------------------*/
+
+//-----------------------------------------------------------------------------
+// name: yfft.cpp
+// desc: fft impl - based on CARL distribution and chuck_fft.*
+//
+// authors: code from San Diego CARL package
+//          Ge Wang (ge@ccrma.stanford.edu)
+// date: spring 2013
+//-----------------------------------------------------------------------------
+#include "y-fft.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const double FFT_PI = 3.14159265358979323846;
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: hanning()
+// desc: make window
+//-----------------------------------------------------------------------------
+void hanning( SAMPLE * window, unsigned long length )
+{
+    unsigned long i;
+    double pi, phase = 0, delta;
+
+    pi = 4.*atan(1.0);
+    delta = 2 * pi / (double) length;
+
+    for( i = 0; i < length; i++ )
+    {
+        window[i] = (SAMPLE)(0.5 * (1.0 - cos(phase)));
+        phase += delta;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: hamming()
+// desc: make window
+//-----------------------------------------------------------------------------
+void hamming( SAMPLE * window, unsigned long length )
+{
+    unsigned long i;
+    double pi, phase = 0, delta;
+
+    pi = 4.*atan(1.0);
+    delta = 2 * pi / (double) length;
+
+    for( i = 0; i < length; i++ )
+    {
+        window[i] = (SAMPLE)(0.54 - .46*cos(phase));
+        phase += delta;
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// name: blackman()
+// desc: make window
+//-----------------------------------------------------------------------------
+void blackman( SAMPLE * window, unsigned long length )
+{
+    unsigned long i;
+    double pi, phase = 0, delta;
+
+    pi = 4.*atan(1.0);
+    delta = 2 * pi / (double) length;
+
+    for( i = 0; i < length; i++ )
+    {
+        window[i] = (SAMPLE)(0.42 - .5*cos(phase) + .08*cos(2*phase));
+        phase += delta;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: apply_window()
+// desc: apply a window to data
+//-----------------------------------------------------------------------------
+void apply_window( SAMPLE * data, SAMPLE * window, unsigned long length )
+{
+    unsigned long i;
+
+    for( i = 0; i < length; i++ )
+        data[i] *= window[i];
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: rfft()
+// desc: real value fft
+//
+//   originally from the CARL software, spect.c; now runs through the
+//   shared YFFTPlan for the size
+//
+//   if forward is true, rfft replaces 2*N real data points in x with N complex 
+//   values representing the positive frequency half of their Fourier spectrum,
+//   with x[1] replaced with the real part of the Nyquist frequency value.
+//
+//   if forward is false, rfft expects x to contain a positive frequency 
+//   spectrum arranged as before, and replaces it with 2*N real values.
+//
+//   N MUST be a power of 2.
+//
+//-----------------------------------------------------------------------------
+void rfft( SAMPLE * x, long N, unsigned int forward )
+{
+    YFFTPlan * plan = N > 0 ? YFFTPlan::get( (unsigned long)N << 1 ) : NULL;
+    if( !plan )
+    {
+        fprintf( stderr, "[y-fft]: rfft: N = %ld is not a power of 2\n", N );
+        assert( plan != NULL );
+        return;
+    }
+
+    if( forward )
+        plan->forward( x );
+    else
+        plan->inverse( x );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: cfft()
+// desc: complex value fft
+//
+//   originally from the CARL software, spect.c; now runs through the
+//   shared YFFTPlan for the size
+//
+//   cfft replaces float array x containing NC complex values (2*NC float 
+//   values alternating real, imagininary, etc.) by its Fourier transform 
+//   if forward is true, or by its inverse Fourier transform ifforward is 
+//   false. The forward transform is scaled by 1/(2*NC), the inverse by 2.
+//
+//   NC MUST be a power of 2.
+//
+//-----------------------------------------------------------------------------
+void cfft( SAMPLE * x, long NC, unsigned int forward )
+{
+    YFFTPlan * plan = NC > 0 ? YFFTPlan::get( (unsigned long)NC << 1 ) : NULL;
+    if( !plan )
+    {
+        fprintf( stderr, "[y-fft]: cfft: NC = %ld is not a power of 2\n", NC );
+        assert( plan != NULL );
+        return;
+    }
+
+    plan->transform( x, forward != 0 );
+}
+
+
+
+
+// shared plans
+YFFTPlan * volatile YFFTPlan::ourPlans[32];
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: fft_twiddle()
+// desc: append the twiddles exp(i a0), exp(i a1) for two neighbouring
+//       points: real parts doubled up, then imaginary parts as (-im, im),
+//       ready to multiply two interleaved complex points at once
+//-----------------------------------------------------------------------------
+static void fft_twiddle( std::vector<SAMPLE> & table, double a0, double a1 )
+{
+    SAMPLE r0 = (SAMPLE)cos( a0 ), i0 = (SAMPLE)sin( a0 );
+    SAMPLE r1 = (SAMPLE)cos( a1 ), i1 = (SAMPLE)sin( a1 );
+    table.push_back( r0 ); table.push_back( r0 );
+    table.push_back( r1 ); table.push_back( r1 );
+    table.push_back( -i0 ); table.push_back( i0 );
+    table.push_back( -i1 ); table.push_back( i1 );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: YFFTPlan()
+// desc: constructor; every table for the size
+//-----------------------------------------------------------------------------
+YFFTPlan::YFFTPlan( unsigned long size )
+{
+    m_size = size;
+    m_points = size / 2;
+    m_bits = 0;
+    while( ( 1UL << m_bits ) < m_points ) m_bits++;
+
+    // bit reversal
+    for( unsigned long i = 0; i < m_points; i++ )
+    {
+        unsigned long j = 0;
+        for( int b = 0; b < m_bits; b++ )
+            if( i & ( 1UL << b ) ) j |= 1UL << ( m_bits - 1 - b );
+        if( i < j )
+        {
+            m_swaps.push_back( (unsigned int)i );
+            m_swaps.push_back( (unsigned int)j );
+        }
+    }
+
+    // a forward transform turns by exp(+i...), an inverse by exp(-i...)
+    unsigned long half = m_points / 2;
+    for( int dir = 0; dir < 2; dir++ )
+    {
+        double sign = dir == 0 ? 1 : -1;
+        std::vector<SAMPLE> & t = m_twiddles[dir];
+
+        // passes as butterflies() makes them (the first needs none)
+        unsigned long L = m_points >= 4 ? 4 : 1;
+        for( ; L * 4 <= m_points; L *= 4 )
+        {
+            // v^2, v, v^3 with v = exp(+-i pi k / 2L)
+            for( unsigned long k = 0; k < L; k += 2 )
+            {
+                double v = sign * FFT_PI / ( 2 * L );
+                fft_twiddle( t, 2 * v * k, 2 * v * ( k + 1 ) );
+                fft_twiddle( t, v * k, v * ( k + 1 ) );
+                fft_twiddle( t, 3 * v * k, 3 * v * ( k + 1 ) );
+            }
+        }
+        // a last single stage
+        if( L * 2 == m_points && L >= 2 )
+        {
+            for( unsigned long k = 0; k < L; k += 2 )
+                fft_twiddle( t, sign * FFT_PI / L * k, sign * FFT_PI / L * ( k + 1 ) );
+        }
+
+        // split constants: bin i pairs with bin m_points - i; with cfft's
+        // scaling folded in (1 / size forward, 2 inverse), forward is
+        // -i/(2 size) exp(+i pi i / points), inverse i exp(-i pi i / points)
+        std::vector<SAMPLE> & q = m_split[dir];
+        q.resize( 4 * ( half + 1 ) );
+        for( unsigned long i = 0; i <= half; i++ )
+        {
+            double a = sign * FFT_PI * i / m_points + FFT_PI / 2;
+            double g = dir == 0 ? -0.5 / m_size : 1;
+            SAMPLE re = (SAMPLE)( g * cos( a ) ), im = (SAMPLE)( g * sin( a ) );
+            q[2 * i] = q[2 * i + 1] = re;
+            q[2 * ( half + 1 ) + 2 * i] = -im;
+            q[2 * ( half + 1 ) + 2 * i + 1] = im;
+        }
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: ~YFFTPlan()
+// desc: destructor
+//-----------------------------------------------------------------------------
+YFFTPlan::~YFFTPlan()
+{
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: get()
+// desc: the shared plan for a size; two threads asking at once may both
+//       make one, and the second made is thrown away
+//-----------------------------------------------------------------------------
+YFFTPlan * YFFTPlan::get( unsigned long size )
+{
+    if( size < 2 || ( size & ( size - 1 ) ) ) return NULL;
+    int bits = 0;
+    while( ( 1UL << bits ) < size ) bits++;
+    if( bits >= 32 ) return NULL;
+
+    YFFTPlan * plan = ourPlans[bits];
+    if( plan ) return plan;
+
+    plan = new YFFTPlan( size );
+    YFFTPlan * had = __sync_val_compare_and_swap( &ourPlans[bits], (YFFTPlan *)NULL, plan );
+    if( had )
+    {
+        delete plan;
+        return had;
+    }
+
+    return plan;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: forward()
+// desc: real to complex (packed as rfft: x[1] is nyquist)
+//-----------------------------------------------------------------------------
+void YFFTPlan::forward( SAMPLE * x ) const
+{
+    butterflies( x, 0 );
+    split( x, 0 );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: inverse()
+// desc: complex (packed as rfft) to real
+//-----------------------------------------------------------------------------
+void YFFTPlan::inverse( SAMPLE * x ) const
+{
+    split( x, 1 );
+    butterflies( x, 1 );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: transform()
+// desc: complex transform, scaled as cfft
+//-----------------------------------------------------------------------------
+void YFFTPlan::transform( SAMPLE * x, bool forward ) const
+{
+    butterflies( x, forward ? 0 : 1 );
+
+    SAMPLE scale = forward ? (SAMPLE)( 1.0 / m_size ) : 2;
+    unsigned long i = 0;
+#if defined(__SSE2__)
+    __m128 s = _mm_set1_ps( scale );
+    for( ; i + 4 <= m_size; i += 4 )
+        _mm_storeu_ps( x + i, _mm_mul_ps( _mm_loadu_ps( x + i ), s ) );
+#endif
+    for( ; i < m_size; i++ )
+        x[i] *= scale;
+}
+
+
+
+
+#if defined(__SSE2__)
+//-----------------------------------------------------------------------------
+// name: fft_mul()
+// desc: two interleaved complex points times their twiddles (real and
+//       imaginary parts as laid out by fft_twiddle)
+//-----------------------------------------------------------------------------
+static inline __m128 fft_mul( __m128 a, __m128 re, __m128 im )
+{
+    __m128 swapped = _mm_shuffle_ps( a, a, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+    return _mm_add_ps( _mm_mul_ps( a, re ), _mm_mul_ps( swapped, im ) );
+}
+#else
+//-----------------------------------------------------------------------------
+// name: fft_mul()
+// desc: complex point k of a pair times its twiddle (as laid out by
+//       fft_twiddle)
+//-----------------------------------------------------------------------------
+static inline void fft_mul( SAMPLE & re, SAMPLE & im, const SAMPLE * w, int k )
+{
+    SAMPLE wr = w[2 * k], wi = w[4 + 2 * k + 1];
+    SAMPLE r = re * wr - im * wi;
+    im = re * wi + im * wr;
+    re = r;
+}
+#endif
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: butterflies()
+// desc: decimation in time after a bit reversal: the first two stages
+//       together (their twiddles are 1 and +-i), then two stages a pass
+//       (stage L, then stage 2L, over each run of 4L points), and a last
+//       single stage when the stages are odd in number
+//-----------------------------------------------------------------------------
+void YFFTPlan::butterflies( SAMPLE * x, int dir ) const
+{
+    unsigned long n = m_points;
+
+    // bit reversal (a complex point is two floats, moved together)
+    for( size_t s = 0; s < m_swaps.size(); s += 2 )
+    {
+        SAMPLE * a = x + 2 * m_swaps[s];
+        SAMPLE * b = x + 2 * m_swaps[s + 1];
+        SAMPLE r = a[0], i = a[1];
+        a[0] = b[0]; a[1] = b[1];
+        b[0] = r; b[1] = i;
+    }
+
+    if( n == 2 )
+    {
+        SAMPLE r = x[0], i = x[1];
+        x[0] = r + x[2]; x[1] = i + x[3];
+        x[2] = r - x[2]; x[3] = i - x[3];
+        return;
+    }
+    if( n < 4 ) return;
+
+    // stages 1 and 2, four points at a time
+#if defined(__SSE2__)
+    const __m128 pairSign = _mm_castsi128_ps( _mm_set_epi32( (int)0x80000000, (int)0x80000000, 0, 0 ) );
+    // turning by +i (forward) negates the real part of a swapped point,
+    // by -i the imaginary
+    const __m128 turnSign = dir == 0
+        ? _mm_castsi128_ps( _mm_set_epi32( 0, (int)0x80000000, 0, (int)0x80000000 ) )
+        : _mm_castsi128_ps( _mm_set_epi32( (int)0x80000000, 0, (int)0x80000000, 0 ) );
+    const __m128 highTurn = _mm_castsi128_ps( _mm_and_si128( _mm_castps_si128( turnSign ),
+                                              _mm_set_epi32( -1, -1, 0, 0 ) ) );
+    for( unsigned long g = 0; g < n; g += 4 )
+    {
+        SAMPLE * p = x + 2 * g;
+        __m128 a = _mm_loadu_ps( p );
+        __m128 b = _mm_loadu_ps( p + 4 );
+        // (a0 + a1, a0 - a1), (a2 + a3, a2 - a3)
+        __m128 lo = _mm_add_ps( _mm_movelh_ps( a, a ), _mm_xor_ps( _mm_movehl_ps( a, a ), pairSign ) );
+        __m128 hi = _mm_add_ps( _mm_movelh_ps( b, b ), _mm_xor_ps( _mm_movehl_ps( b, b ), pairSign ) );
+        // (b2, +-i b3)
+        __m128 t = _mm_xor_ps( _mm_shuffle_ps( hi, hi, _MM_SHUFFLE( 2, 3, 1, 0 ) ), highTurn );
+        _mm_storeu_ps( p, _mm_add_ps( lo, t ) );
+        _mm_storeu_ps( p + 4, _mm_sub_ps( lo, t ) );
+    }
+#else
+    SAMPLE turn = dir == 0 ? 1 : -1;
+    for( unsigned long g = 0; g < n; g += 4 )
+    {
+        SAMPLE * p = x + 2 * g;
+        SAMPLE b0r = p[0] + p[2], b0i = p[1] + p[3];
+        SAMPLE b1r = p[0] - p[2], b1i = p[1] - p[3];
+        SAMPLE b2r = p[4] + p[6], b2i = p[5] + p[7];
+        SAMPLE b3r = p[4] - p[6], b3i = p[5] - p[7];
+        // b3 turned by +-i
+        SAMPLE tr = -turn * b3i, ti = turn * b3r;
+        p[0] = b0r + b2r; p[1] = b0i + b2i;
+        p[2] = b1r + tr;  p[3] = b1i + ti;
+        p[4] = b0r - b2r; p[5] = b0i - b2i;
+        p[6] = b1r - tr;  p[7] = b1i - ti;
+    }
+#endif
+
+    // two stages a pass, as one radix 4 butterfly: with v the stage 2L
+    // twiddle (v^2 is stage L's), points 0, L, 2L, 3L of a run are
+    //   a0 + a1' + (a2' + a3'),  a0 - a1' +- i (a2' - a3'),
+    //   a0 + a1' - (a2' + a3'),  a0 - a1' -+ i (a2' - a3')
+    // for a1' = v^2 a1, a2' = v a2, a3' = v^3 a3; the twiddles for a k
+    // serve the same k of every run
+    const SAMPLE * w = &m_twiddles[dir][0];
+    unsigned long L = 4;
+    for( ; L * 4 <= n; L *= 4 )
+    {
+        const SAMPLE * t = w;
+        for( unsigned long k = 0; k < L; k += 2, t += 24 )
+        {
+#if defined(__SSE2__)
+            __m128 w2r = _mm_loadu_ps( t ), w2i = _mm_loadu_ps( t + 4 );
+            __m128 w1r = _mm_loadu_ps( t + 8 ), w1i = _mm_loadu_ps( t + 12 );
+            __m128 w3r = _mm_loadu_ps( t + 16 ), w3i = _mm_loadu_ps( t + 20 );
+#endif
+            for( unsigned long g = 0; g < n; g += 4 * L )
+            {
+                SAMPLE * p0 = x + 2 * ( g + k );
+                SAMPLE * p1 = p0 + 2 * L;
+                SAMPLE * p2 = p0 + 4 * L;
+                SAMPLE * p3 = p0 + 6 * L;
+#if defined(__SSE2__)
+                __m128 a0 = _mm_loadu_ps( p0 );
+                __m128 a1 = fft_mul( _mm_loadu_ps( p1 ), w2r, w2i );
+                __m128 a2 = fft_mul( _mm_loadu_ps( p2 ), w1r, w1i );
+                __m128 a3 = fft_mul( _mm_loadu_ps( p3 ), w3r, w3i );
+                __m128 s01 = _mm_add_ps( a0, a1 ), d01 = _mm_sub_ps( a0, a1 );
+                __m128 s23 = _mm_add_ps( a2, a3 ), d23 = _mm_sub_ps( a2, a3 );
+                d23 = _mm_xor_ps( _mm_shuffle_ps( d23, d23, _MM_SHUFFLE( 2, 3, 0, 1 ) ), turnSign );
+                _mm_storeu_ps( p0, _mm_add_ps( s01, s23 ) );
+                _mm_storeu_ps( p2, _mm_sub_ps( s01, s23 ) );
+                _mm_storeu_ps( p1, _mm_add_ps( d01, d23 ) );
+                _mm_storeu_ps( p3, _mm_sub_ps( d01, d23 ) );
+#else
+                for( int j = 0; j < 2; j++ )
+                {
+                    SAMPLE * q0 = p0 + 2 * j, * q1 = p1 + 2 * j, * q2 = p2 + 2 * j, * q3 = p3 + 2 * j;
+                    SAMPLE a1r = q1[0], a1i = q1[1], a2r = q2[0], a2i = q2[1], a3r = q3[0], a3i = q3[1];
+                    fft_mul( a1r, a1i, t, j );
+                    fft_mul( a2r, a2i, t + 8, j );
+                    fft_mul( a3r, a3i, t + 16, j );
+                    SAMPLE s01r = q0[0] + a1r, s01i = q0[1] + a1i;
+                    SAMPLE d01r = q0[0] - a1r, d01i = q0[1] - a1i;
+                    SAMPLE s23r = a2r + a3r, s23i = a2i + a3i;
+                    // (a2' - a3') turned by +-i
+                    SAMPLE d23r = -turn * ( a2i - a3i ), d23i = turn * ( a2r - a3r );
+                    q0[0] = s01r + s23r; q0[1] = s01i + s23i;
+                    q2[0] = s01r - s23r; q2[1] = s01i - s23i;
+                    q1[0] = d01r + d23r; q1[1] = d01i + d23i;
+                    q3[0] = d01r - d23r; q3[1] = d01i - d23i;
+                }
+#endif
+            }
+        }
+        w += 12 * L;
+    }
+
+    // a last single stage
+    if( L * 2 == n )
+    {
+        for( unsigned long k = 0; k < L; k += 2, w += 8 )
+        {
+            SAMPLE * p0 = x + 2 * k;
+            SAMPLE * p1 = p0 + 2 * L;
+#if defined(__SSE2__)
+            __m128 a0 = _mm_loadu_ps( p0 );
+            __m128 a1 = fft_mul( _mm_loadu_ps( p1 ), _mm_loadu_ps( w ), _mm_loadu_ps( w + 4 ) );
+            _mm_storeu_ps( p0, _mm_add_ps( a0, a1 ) );
+            _mm_storeu_ps( p1, _mm_sub_ps( a0, a1 ) );
+#else
+            for( int j = 0; j < 2; j++ )
+            {
+                SAMPLE * q0 = p0 + 2 * j, * q1 = p1 + 2 * j;
+                SAMPLE a1r = q1[0], a1i = q1[1];
+                fft_mul( a1r, a1i, w, j );
+                q1[0] = q0[0] - a1r; q1[1] = q0[1] - a1i;
+                q0[0] += a1r; q0[1] += a1i;
+            }
+#endif
+        }
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: split()
+// desc: bins i and points - i of the complex transform make bins i and
+//       points - i of the real one (and back): with B' = conj(B),
+//       h = (A + B') / 2, t = q_i (A - B'), then A = h + t, B = conj(h - t),
+//       scaling folded into h and q_i
+//-----------------------------------------------------------------------------
+void YFFTPlan::split( SAMPLE * x, int dir ) const
+{
+    unsigned long n = m_points;
+    unsigned long half = n / 2;
+    const SAMPLE * qr = &m_split[dir][0];
+    const SAMPLE * qi = qr + 2 * ( half + 1 );
+    SAMPLE h = dir == 0 ? (SAMPLE)( 0.5 / m_size ) : 1;
+
+    // dc and nyquist (packed in bin 0)
+    SAMPLE g = dir == 0 ? (SAMPLE)( 1.0 / m_size ) : 1;
+    SAMPLE x0 = x[0], x1 = x[1];
+    x[0] = g * ( x0 + x1 );
+    x[1] = g * ( x0 - x1 );
+    if( half == 0 ) return;
+
+    unsigned long i = 1;
+#if defined(__SSE2__)
+    // bins i, i + 1 against points - i, points - i - 1
+    const __m128 conj = _mm_castsi128_ps( _mm_set_epi32( (int)0x80000000, 0, (int)0x80000000, 0 ) );
+    const __m128 hh = _mm_set1_ps( h );
+    for( ; i + 1 < half; i += 2 )
+    {
+        SAMPLE * pa = x + 2 * i;
+        SAMPLE * pb = x + 2 * ( n - i - 1 );
+        __m128 a = _mm_loadu_ps( pa );
+        __m128 b = _mm_loadu_ps( pb );
+        b = _mm_xor_ps( _mm_shuffle_ps( b, b, _MM_SHUFFLE( 1, 0, 3, 2 ) ), conj );
+        __m128 d = _mm_sub_ps( a, b );
+        __m128 sum = _mm_mul_ps( _mm_add_ps( a, b ), hh );
+        __m128 t = _mm_add_ps( _mm_mul_ps( d, _mm_loadu_ps( qr + 2 * i ) ),
+                               _mm_mul_ps( _mm_shuffle_ps( d, d, _MM_SHUFFLE( 2, 3, 0, 1 ) ),
+                                           _mm_loadu_ps( qi + 2 * i ) ) );
+        _mm_storeu_ps( pa, _mm_add_ps( sum, t ) );
+        __m128 back = _mm_xor_ps( _mm_sub_ps( sum, t ), conj );
+        _mm_storeu_ps( pb, _mm_shuffle_ps( back, back, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+    }
+#endif
+    // the rest, and bin half (its own pair: written twice, the second stays)
+    for( ; i <= half; i++ )
+    {
+        SAMPLE * pa = x + 2 * i;
+        SAMPLE * pb = x + 2 * ( n - i );
+        SAMPLE ar = pa[0], ai = pa[1], br = pb[0], bi = -pb[1];
+        SAMPLE sr = h * ( ar + br ), si = h * ( ai + bi );
+        SAMPLE dr = ar - br, di = ai - bi;
+        SAMPLE wr = qr[2 * i], wi = qi[2 * i + 1];
+        SAMPLE tr = dr * wr - di * wi, ti = dr * wi + di * wr;
+        pa[0] = sr + tr; pa[1] = si + ti;
+        pb[0] = sr - tr; pb[1] = -( si - ti );
+    }
+}
@@ -60,9 +60,9 @@ void blackman( SAMPLE * window, unsigned long length );
 // apply the window
 void apply_window( SAMPLE * data, SAMPLE * window, unsigned long length );
 
-// real fft, N must be power of 2
+// real fft, N must be power of 2 (else an error, and x is left as is)
 void rfft( SAMPLE * x, long N, unsigned int forward );
-// complex fft, NC must be power of 2
+// complex fft, NC must be power of 2 (else an error, and x is left as is)
 void cfft( SAMPLE * x, long NC, unsigned int forward );
 
 // c linkage
@@ -71,4 +71,67 @@ void cfft( SAMPLE * x, long NC, unsigned int forward );
 #endif
 
 
+
+
+#if ( defined( __cplusplus ) || defined( _cplusplus ) )
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// name: class YFFTPlan
+// desc: the transforms above for one size, with everything that depends
+//       only on the size worked out up front: bit reversal swaps, twiddles
+//       per pass and direction, and the real split constants.
+//       Butterflies go two stages a pass (radix 2^2), two complex points
+//       at a time with SSE2. Same layout and scaling as rfft / cfft, which
+//       now run through the shared plans. A plan is read only once made:
+//       any number of threads may use one
+//-----------------------------------------------------------------------------
+class YFFTPlan
+{
+public:
+    // size real points (power of 2, at least 2); size / 2 complex points
+    YFFTPlan( unsigned long size );
+    ~YFFTPlan();
+
+public:
+    // the shared plan for size, made on first use and kept (NULL: not a
+    // power of 2); safe from any thread
+    static YFFTPlan * get( unsigned long size );
+
+public:
+    // real to complex, in place: as rfft( x, size / 2, FFT_FORWARD )
+    void forward( SAMPLE * x ) const;
+    // complex to real, in place: as rfft( x, size / 2, FFT_INVERSE )
+    void inverse( SAMPLE * x ) const;
+    // size / 2 complex points, in place: as cfft( x, size / 2, forward )
+    void transform( SAMPLE * x, bool forward ) const;
+
+public:
+    unsigned long size() const { return m_size; }
+
+protected:
+    // unscaled complex transform; dir 0 forward, 1 inverse
+    void butterflies( SAMPLE * x, int dir ) const;
+    // the split between a complex transform of size / 2 and a real one
+    void split( SAMPLE * x, int dir ) const;
+
+protected:
+    unsigned long m_size;
+    // complex points, and log2 of that
+    unsigned long m_points;
+    int m_bits;
+    // bit reversal as (i, j) pairs to swap, i < j
+    std::vector<unsigned int> m_swaps;
+    // per direction: each pass's twiddles in the order butterflies() goes
+    std::vector<SAMPLE> m_twiddles[2];
+    // per direction: split constant for bins [0, m_points / 2]
+    std::vector<SAMPLE> m_split[2];
+
+protected:
+    // shared plans by log2 size
+    static YFFTPlan * volatile ourPlans[32];
+};
+#endif
+
+
 #endif
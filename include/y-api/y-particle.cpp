@@ -36,32 +36,75 @@
 #include "y-particle.h"
 #include "x-fun.h"
 #include <iostream>
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 using namespace std;
 
 
 
 
+//-----------------------------------------------------------------------------
+// name: push()
+// desc: add a slot as a new YParticle starts out
+//-----------------------------------------------------------------------------
+void YParticleData::push()
+{
+    // value, goal, slew
+    static const GLfloat start[Y_PARTICLE_NUM_CHANNELS][3] = {
+        { 0, 0, 1 }, { 0, 0, 1 }, { 0, 0, 1 },  // X Y Z
+        { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 },  // DX DY DZ
+        { 1, 1, 1 },                            // ALPHA
+        { 0, 0, 1 }, { 0, 0, 1 }, { 0, 0, 1 },  // ORI
+        { 1, 1, 1 }                             // MULTIPLIER
+    };
+    for( int c = 0; c < Y_PARTICLE_NUM_CHANNELS; c++ )
+    {
+        lanes[c].value.push_back( start[c][0] );
+        lanes[c].goal.push_back( start[c][1] );
+        lanes[c].slew.push_back( start[c][2] );
+    }
+    vx.push_back( 0 ); vy.push_back( 0 ); vz.push_back( 0 );
+    px.push_back( 0 ); py.push_back( 0 ); pz.push_back( 0 );
+    // never 0 (xorshift stays there)
+    seed.push_back( ( ( (unsigned int)seed.size() * 2654435761u ) ^ 0x9e3779b9u ) | 1 );
+    life.push_back( Y_PARTICLE_FOREVER );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: swap()
+// desc: exchange two slots
+//-----------------------------------------------------------------------------
+void YParticleData::swap( size_t a, size_t b )
+{
+    for( int c = 0; c < Y_PARTICLE_NUM_CHANNELS; c++ )
+    {
+        std::swap( lanes[c].value[a], lanes[c].value[b] );
+        std::swap( lanes[c].goal[a], lanes[c].goal[b] );
+        std::swap( lanes[c].slew[a], lanes[c].slew[b] );
+    }
+    std::swap( vx[a], vx[b] ); std::swap( vy[a], vy[b] ); std::swap( vz[a], vz[b] );
+    std::swap( px[a], px[b] ); std::swap( py[a], py[b] ); std::swap( pz[a], pz[b] );
+    std::swap( seed[a], seed[b] );
+    std::swap( life[a], life[b] );
+}
+
+
+
+
 //-----------------------------------------------------------------------------
 // name: YPartcile()
 // desc: ...
 //-----------------------------------------------------------------------------
 YParticle::YParticle( GLfloat width )
-: YFlare(width), m_isFree(false)
+: YFlare(width), m_system(NULL), m_slot(0), m_isFree(false)
 {
-    X.slew = 1;
-    Y.slew = 1;
-    Z.slew = 1;
-    ALPHA.set( 1, 1, 1 );
-    oriX.slew = 1;
-    oriY.slew = 1;
-    oriZ.slew = 1;
     origLoc.slew = 1;
     origOri.slew = 1;
-    multiplier.set( 1, 1, 1 );
-
-//    velX.slew = 1;
-//    velY.slew = 1;
-//    velZ.slew = 1;
 }
 
 
@@ -78,54 +121,12 @@ void YParticle::setLocAsOrig( const Vector3D & v )
     // set ori
     origLoc = v;
     // set slew X
-    X.updateSet( v.x );
-    Y.updateSet( v.y );
-    X.slew = 1;
-    Y.slew = 1;
-}
-
-
-
-
-//-----------------------------------------------------------------------------
-// name: update()
-// desc: update the quantities associated with the frag
-//-----------------------------------------------------------------------------
-void YParticle::update( YTimeInterval dt )
-{
-    // update super
-    // YFlare::update( dt );
-    
-    // update
-    X.interp( dt );
-    Y.interp( dt );
-    Z.interp( dt );
-    dX.interp( dt );
-    dY.interp( dt );
-    dZ.interp( dt );
-    ALPHA.interp( dt );
-    oriX.interp( dt);
-    oriY.interp( dt );
-    oriZ.interp( dt );
-    multiplier.interp( dt );
-
-//    velX.interp( dt );
-//    velY.interp( dt );
-//    velZ.interp( dt );
-//    radius.interp( dt );
-
-    // update
-    loc.x = X.value * multiplier.value + dX.value;
-    loc.y = Y.value * multiplier.value + dY.value;
-    loc.z = Z.value * multiplier.value + dZ.value;
-    alpha = ALPHA.value;
-    ori.x = oriX.value;
-    ori.y = oriY.value;
-    ori.z = oriZ.value;
-
-//    velocity.x = velX.value;
-//    velocity.y = velY.value;
-//    velocity.z = velZ.value;
+    if( !m_system ) return;
+    YParticleData & data = m_system->data();
+    data.lanes[Y_PARTICLE_X].updateSet( m_slot, v.x );
+    data.lanes[Y_PARTICLE_Y].updateSet( m_slot, v.y );
+    data.lanes[Y_PARTICLE_X].slew[m_slot] = 1;
+    data.lanes[Y_PARTICLE_Y].slew[m_slot] = 1;
 }
 
 
@@ -150,8 +151,14 @@ void YParticle::render()
 //-----------------------------------------------------------------------------
 void YParticleSystem::addParticle( YParticle * particle )
 {
+    // its slot
+    particle->m_system = this;
+    particle->m_slot = m_particles.size();
+    m_data.push();
     // particle
     m_particles.push_back( particle );
+    // live from the start if active (as a YFlare starts out)
+    if( particle->active ) swapSlots( m_numActive++, particle->m_slot );
     // activate
     // particle->activate();
 }
@@ -161,16 +168,18 @@ void YParticleSystem::addParticle( YParticle * particle )
 
 //-----------------------------------------------------------------------------
 // name: spawn()
-// desc: ...
+// desc: the first free slot
 //-----------------------------------------------------------------------------
-YParticle * YParticleSystem::spawn()
+YParticle * YParticleSystem::spawn( GLfloat lifetime )
 {
     // check
     if( m_numActive >= m_particles.size() )
         return NULL;
 
     // get it
+    m_data.life[m_numActive] = lifetime;
     YParticle * particle = m_particles[m_numActive++];
+    m_numSpawned++;
     
 //    // reset an children fx
 //    for( int i = 0; i < particle->children.size(); i++ )
@@ -193,6 +202,55 @@ YParticle * YParticleSystem::spawn()
 
 
 
+//-----------------------------------------------------------------------------
+// name: kill()
+// desc: end a live particle now
+//-----------------------------------------------------------------------------
+void YParticleSystem::kill( YParticle * particle )
+{
+    // check
+    if( particle->m_system != this || particle->m_slot >= m_numActive )
+        return;
+
+    killSlot( particle->m_slot );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: killSlot()
+// desc: the last live particle takes the slot; the dead one goes just past
+//       the live span, first in line to spawn again
+//-----------------------------------------------------------------------------
+void YParticleSystem::killSlot( size_t i )
+{
+    size_t last = --m_numActive;
+    m_particles[i]->active = false;
+    if( i != last ) swapSlots( i, last );
+    m_numKilled++;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: swapSlots()
+// desc: exchange two slots (particles and state)
+//-----------------------------------------------------------------------------
+void YParticleSystem::swapSlots( size_t a, size_t b )
+{
+    if( a == b ) return;
+
+    std::swap( m_particles[a], m_particles[b] );
+    m_data.swap( a, b );
+    m_particles[a]->m_slot = a;
+    m_particles[b]->m_slot = b;
+}
+
+
+
+
 //-----------------------------------------------------------------------------
 // name: addInfluence()
 // desc: ...
@@ -208,43 +266,324 @@ void YParticleSystem::addInfluence( YParticleInfluence * influence )
 
 //-----------------------------------------------------------------------------
 // name: update()
-// desc: ...
+// desc: each influence, then the slews, over the live particles
 //-----------------------------------------------------------------------------
 void YParticleSystem::update( YTimeInterval dt )
 {    
     // update super
     // YFlare::update( dt );
 
+    // the live span
+    size_t count = m_numActive;
+
     // go through influences
-    for( int i = 0; i < m_influences.size(); i++ )
+    for( size_t i = 0; i < m_influences.size(); i++ )
+        m_influences[i]->apply( m_data, count, dt );
+
+    // slew
+    integrate( count, dt );
+
+    // cerr << "numActive: " << m_numActive << endl;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: particle_slew()
+// desc: one lane of Vector3D::interp( dt ) over n slots
+//-----------------------------------------------------------------------------
+static void particle_slew( YParticleLane & lane, size_t n, GLfloat dt )
+{
+    GLfloat * value = &lane.value[0];
+    const GLfloat * goal = &lane.goal[0];
+    const GLfloat * slew = &lane.slew[0];
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128 d = _mm_set1_ps( dt );
+    for( ; i + 4 <= n; i += 4 )
+    {
+        __m128 v = _mm_loadu_ps( value + i );
+        __m128 step = _mm_mul_ps( _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( goal + i ), v ),
+                                              _mm_loadu_ps( slew + i ) ), d );
+        _mm_storeu_ps( value + i, _mm_add_ps( step, v ) );
+    }
+#endif
+    for( ; i < n; i++ )
+        value[i] = ( goal[i] - value[i] ) * slew[i] * dt + value[i];
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: particle_move()
+// desc: velocity into an offset lane (value and goal, so the slew keeps it)
+//-----------------------------------------------------------------------------
+static void particle_move( YParticleLane & lane, const vector<GLfloat> & v, size_t n, GLfloat dt )
+{
+    GLfloat * value = &lane.value[0];
+    GLfloat * goal = &lane.goal[0];
+    const GLfloat * vel = &v[0];
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128 d = _mm_set1_ps( dt );
+    for( ; i + 4 <= n; i += 4 )
+    {
+        __m128 step = _mm_mul_ps( _mm_loadu_ps( vel + i ), d );
+        _mm_storeu_ps( value + i, _mm_add_ps( _mm_loadu_ps( value + i ), step ) );
+        _mm_storeu_ps( goal + i, _mm_add_ps( _mm_loadu_ps( goal + i ), step ) );
+    }
+#endif
+    for( ; i < n; i++ )
+    {
+        value[i] += vel[i] * dt;
+        goal[i] += vel[i] * dt;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: particle_age()
+// desc: life -= dt
+//-----------------------------------------------------------------------------
+static void particle_age( vector<GLfloat> & life, size_t n, GLfloat dt )
+{
+    GLfloat * l = &life[0];
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128 d = _mm_set1_ps( dt );
+    for( ; i + 4 <= n; i += 4 )
+        _mm_storeu_ps( l + i, _mm_sub_ps( _mm_loadu_ps( l + i ), d ) );
+#endif
+    for( ; i < n; i++ )
+        l[i] -= dt;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: particle_place()
+// desc: location along one axis: channel * multiplier + offset
+//-----------------------------------------------------------------------------
+static void particle_place( vector<GLfloat> & out, const YParticleLane & base,
+                            const YParticleLane & mult, const YParticleLane & offset, size_t n )
+{
+    GLfloat * p = &out[0];
+    const GLfloat * b = &base.value[0];
+    const GLfloat * m = &mult.value[0];
+    const GLfloat * o = &offset.value[0];
+    size_t i = 0;
+#if defined(__SSE2__)
+    for( ; i + 4 <= n; i += 4 )
+        _mm_storeu_ps( p + i, _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( b + i ), _mm_loadu_ps( m + i ) ),
+                                          _mm_loadu_ps( o + i ) ) );
+#endif
+    for( ; i < n; i++ )
+        p[i] = b[i] * m[i] + o[i];
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: integrate()
+// desc: slews, velocity into the offsets and life, results out to the
+//       entities; kills the inactive and those out of life
+//-----------------------------------------------------------------------------
+void YParticleSystem::integrate( size_t count, YTimeInterval dt )
+{
+    if( count == 0 ) return;
+    GLfloat delta = dt;
+    YParticleLane * lanes = m_data.lanes;
+
+    // velocity
+    particle_move( lanes[Y_PARTICLE_DX], m_data.vx, count, delta );
+    particle_move( lanes[Y_PARTICLE_DY], m_data.vy, count, delta );
+    particle_move( lanes[Y_PARTICLE_DZ], m_data.vz, count, delta );
+    // every channel, a lane at a time
+    for( int c = 0; c < Y_PARTICLE_NUM_CHANNELS; c++ )
+        particle_slew( lanes[c], count, delta );
+    // location
+    const YParticleLane & mult = lanes[Y_PARTICLE_MULTIPLIER];
+    particle_place( m_data.px, lanes[Y_PARTICLE_X], mult, lanes[Y_PARTICLE_DX], count );
+    particle_place( m_data.py, lanes[Y_PARTICLE_Y], mult, lanes[Y_PARTICLE_DY], count );
+    particle_place( m_data.pz, lanes[Y_PARTICLE_Z], mult, lanes[Y_PARTICLE_DZ], count );
+    particle_age( m_data.life, count, delta );
+
+    // out to the entities
+    size_t i = 0;
+    while( i < m_numActive )
     {
-        // go through particles
-        for( int j = 0; j < m_particles.size(); j++ )
+        YParticle * e = m_particles[i];
+        // (the last live one, already integrated, comes into slot i)
+        if( !e->active || m_data.life[i] <= 0 )
         {
-            // check
-            if( m_particles[j]->active )
-            {
-                // apply influence
-                m_influences[i]->update( m_particles[j], dt );
-            }
+            killSlot( i );
+            continue;
         }
+        e->loc.set( m_data.px[i], m_data.py[i], m_data.pz[i] );
+        e->alpha = lanes[Y_PARTICLE_ALPHA].value[i];
+        e->ori.set( lanes[Y_PARTICLE_ORI_X].value[i], lanes[Y_PARTICLE_ORI_Y].value[i],
+                    lanes[Y_PARTICLE_ORI_Z].value[i] );
+        // anything hung off it
+        if( e->getChildren().size() ) e->updateAll( dt );
+        i++;
     }
+}
 
-    // go through particles
-    for( int i = 0; i < m_particles.size(); i++ )
+
+
+
+//-----------------------------------------------------------------------------
+// name: apply()
+// desc: gravity
+//-----------------------------------------------------------------------------
+void YParticleGravity::apply( YParticleData & data, size_t count, YTimeInterval dt )
+{
+    GLfloat gx = gravity.x * dt, gy = gravity.y * dt, gz = gravity.z * dt;
+    GLfloat * vx = &data.vx[0], * vy = &data.vy[0], * vz = &data.vz[0];
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128 x = _mm_set1_ps( gx ), y = _mm_set1_ps( gy ), z = _mm_set1_ps( gz );
+    for( ; i + 4 <= count; i += 4 )
     {
-        // check
-        if( m_particles[i]->active )
+        _mm_storeu_ps( vx + i, _mm_add_ps( _mm_loadu_ps( vx + i ), x ) );
+        _mm_storeu_ps( vy + i, _mm_add_ps( _mm_loadu_ps( vy + i ), y ) );
+        _mm_storeu_ps( vz + i, _mm_add_ps( _mm_loadu_ps( vz + i ), z ) );
+    }
+#endif
+    for( ; i < count; i++ )
+    {
+        vx[i] += gx;
+        vy[i] += gy;
+        vz[i] += gz;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: apply()
+// desc: drag
+//-----------------------------------------------------------------------------
+void YParticleDrag::apply( YParticleData & data, size_t count, YTimeInterval dt )
+{
+    GLfloat keep = 1 - amount * dt;
+    if( keep < 0 ) keep = 0;
+    GLfloat * vx = &data.vx[0], * vy = &data.vy[0], * vz = &data.vz[0];
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128 k = _mm_set1_ps( keep );
+    for( ; i + 4 <= count; i += 4 )
+    {
+        _mm_storeu_ps( vx + i, _mm_mul_ps( _mm_loadu_ps( vx + i ), k ) );
+        _mm_storeu_ps( vy + i, _mm_mul_ps( _mm_loadu_ps( vy + i ), k ) );
+        _mm_storeu_ps( vz + i, _mm_mul_ps( _mm_loadu_ps( vz + i ), k ) );
+    }
+#endif
+    for( ; i < count; i++ )
+    {
+        vx[i] *= keep;
+        vy[i] *= keep;
+        vz[i] *= keep;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: apply()
+// desc: spring toward the point (from last update's locations)
+//-----------------------------------------------------------------------------
+void YParticleAttractor::apply( YParticleData & data, size_t count, YTimeInterval dt )
+{
+    GLfloat k = strength * dt;
+    GLfloat x = point.x, y = point.y, z = point.z;
+    GLfloat * vx = &data.vx[0], * vy = &data.vy[0], * vz = &data.vz[0];
+    const GLfloat * px = &data.px[0], * py = &data.py[0], * pz = &data.pz[0];
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128 kk = _mm_set1_ps( k );
+    __m128 cx = _mm_set1_ps( x ), cy = _mm_set1_ps( y ), cz = _mm_set1_ps( z );
+    for( ; i + 4 <= count; i += 4 )
+    {
+        _mm_storeu_ps( vx + i, _mm_add_ps( _mm_loadu_ps( vx + i ),
+                       _mm_mul_ps( _mm_sub_ps( cx, _mm_loadu_ps( px + i ) ), kk ) ) );
+        _mm_storeu_ps( vy + i, _mm_add_ps( _mm_loadu_ps( vy + i ),
+                       _mm_mul_ps( _mm_sub_ps( cy, _mm_loadu_ps( py + i ) ), kk ) ) );
+        _mm_storeu_ps( vz + i, _mm_add_ps( _mm_loadu_ps( vz + i ),
+                       _mm_mul_ps( _mm_sub_ps( cz, _mm_loadu_ps( pz + i ) ), kk ) ) );
+    }
+#endif
+    for( ; i < count; i++ )
+    {
+        vx[i] += ( x - px[i] ) * k;
+        vy[i] += ( y - py[i] ) * k;
+        vz[i] += ( z - pz[i] ) * k;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: particle_random()
+// desc: xorshift step; returns [-1, 1]
+//-----------------------------------------------------------------------------
+static inline GLfloat particle_random( unsigned int & s )
+{
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return (GLfloat)(int)( s >> 8 ) * ( 2.0f / 16777215.0f ) - 1.0f;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: apply()
+// desc: noise
+//-----------------------------------------------------------------------------
+void YParticleNoise::apply( YParticleData & data, size_t count, YTimeInterval dt )
+{
+    GLfloat k = amount * dt;
+    GLfloat * vx = &data.vx[0], * vy = &data.vy[0], * vz = &data.vz[0];
+    unsigned int * seed = &data.seed[0];
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128 kk = _mm_set1_ps( k );
+    __m128 scale = _mm_set1_ps( 2.0f / 16777215.0f ), one = _mm_set1_ps( 1.0f );
+    GLfloat * v[3] = { vx, vy, vz };
+    for( ; i + 4 <= count; i += 4 )
+    {
+        __m128i s = _mm_loadu_si128( (const __m128i *)( seed + i ) );
+        for( int a = 0; a < 3; a++ )
         {
-            // update
-            m_particles[i]->updateAll( dt );
+            // as particle_random, four at a time
+            s = _mm_xor_si128( s, _mm_slli_epi32( s, 13 ) );
+            s = _mm_xor_si128( s, _mm_srli_epi32( s, 17 ) );
+            s = _mm_xor_si128( s, _mm_slli_epi32( s, 5 ) );
+            __m128 r = _mm_sub_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_srli_epi32( s, 8 ) ), scale ), one );
+            _mm_storeu_ps( v[a] + i, _mm_add_ps( _mm_loadu_ps( v[a] + i ), _mm_mul_ps( r, kk ) ) );
         }
+        _mm_storeu_si128( (__m128i *)( seed + i ), s );
+    }
+#endif
+    for( ; i < count; i++ )
+    {
+        unsigned int s = seed[i];
+        vx[i] += particle_random( s ) * k;
+        vy[i] += particle_random( s ) * k;
+        vz[i] += particle_random( s ) * k;
+        seed[i] = s;
     }
-    
-    // pack active
-    packActiveParticles();
-
-    // cerr << "numActive: " << m_numActive << endl;
 }
 
 
@@ -259,8 +598,8 @@ void YParticleSystem::render()
     // the particle
     YParticle * e = NULL;
 
-    // go through particles
-    for( int i = 0; i < m_particles.size(); i++ )
+    // go through live particles
+    for( size_t i = 0; i < m_numActive; i++ )
     {
         // current
         e = m_particles[i];
@@ -299,21 +638,19 @@ void YParticleSystem::explode(
     GLfloat xUpBound, GLfloat yzBound, GLfloat oBound,
     GLfloat slewLoc, GLfloat slewOri )
 {
-    // the particle
-    YParticle * e = NULL;
+    // the state
+    YParticleLane * lanes = m_data.lanes;
 
     // go through particles
     for( int i = 0; i < m_particles.size(); i++ )
     {
-        // current
-        e = m_particles[i];
         // set goal
-        e->X.update( XFun::rand2f(-yzBound, yzBound), slewLoc );
-        e->Y.update( XFun::rand2f(-yzBound, yzBound), slewLoc );
-        e->Z.update( XFun::rand2f(0, xUpBound), slewLoc );
-        e->oriX.update( XFun::rand2f(-oBound, oBound), slewOri );
-        e->oriY.update( XFun::rand2f(-oBound, oBound), slewOri );
-        e->oriZ.update( XFun::rand2f(-oBound, oBound), slewOri );
+        lanes[Y_PARTICLE_X].update( i, XFun::rand2f(-yzBound, yzBound), slewLoc );
+        lanes[Y_PARTICLE_Y].update( i, XFun::rand2f(-yzBound, yzBound), slewLoc );
+        lanes[Y_PARTICLE_Z].update( i, XFun::rand2f(0, xUpBound), slewLoc );
+        lanes[Y_PARTICLE_ORI_X].update( i, XFun::rand2f(-oBound, oBound), slewOri );
+        lanes[Y_PARTICLE_ORI_Y].update( i, XFun::rand2f(-oBound, oBound), slewOri );
+        lanes[Y_PARTICLE_ORI_Z].update( i, XFun::rand2f(-oBound, oBound), slewOri );
     }
 }
 
@@ -328,6 +665,7 @@ void YParticleSystem::converge( GLfloat slewLoc, GLfloat slewOri )
 {
     // the particle
     YParticle * e = NULL;
+    YParticleLane * lanes = m_data.lanes;
     
     // go through particles
     for( int i = 0; i < m_particles.size(); i++ )
@@ -335,12 +673,12 @@ void YParticleSystem::converge( GLfloat slewLoc, GLfloat slewOri )
         // current
         e = m_particles[i];
         // set goal
-        e->X.update( e->origLoc.x, slewLoc );
-        e->Y.update( e->origLoc.y, slewLoc );
-        e->Z.update( e->origLoc.z, slewLoc );
-        e->oriX.update( e->origOri.x, slewOri );
-        e->oriY.update( e->origOri.y, slewOri );
-        e->oriZ.update( e->origOri.z, slewOri );
+        lanes[Y_PARTICLE_X].update( i, e->origLoc.x, slewLoc );
+        lanes[Y_PARTICLE_Y].update( i, e->origLoc.y, slewLoc );
+        lanes[Y_PARTICLE_Z].update( i, e->origLoc.z, slewLoc );
+        lanes[Y_PARTICLE_ORI_X].update( i, e->origOri.x, slewOri );
+        lanes[Y_PARTICLE_ORI_Y].update( i, e->origOri.y, slewOri );
+        lanes[Y_PARTICLE_ORI_Z].update( i, e->origOri.z, slewOri );
     }
 }
 
@@ -366,35 +704,3 @@ void YParticleSystem::converge( GLfloat slewLoc, GLfloat slewOri )
 //        m_particles[i]->updateAllPostRender( dt );
 //    }    
 //}
-
-
-
-
-//-----------------------------------------------------------------------------
-// name: update()
-// desc: ...
-//-----------------------------------------------------------------------------
-void YParticleSystem::packActiveParticles()
-{    
-    // pack
-    int count = 0;
-    for( int i = 0; i < m_particles.size(); i++ )
-    {
-        // check
-        if( m_particles[i]->active == true )
-        {
-            if( i != count )
-            {
-                // swap
-                YParticle * swap = m_particles[i];
-                m_particles[i] = m_particles[count];
-                m_particles[count] = swap;
-            }
-            // increment count
-            count++;
-        }
-    }
-    
-    // update
-    m_numActive = count;
-}
@@ -39,6 +39,9 @@
 #include <vector>
 #include "y-entity.h"
 
+// spawn() lifetime that never runs out
+#define Y_PARTICLE_FOREVER 1e30f
+
 // forward reference
 class YParticleRenderer;
 class YParticleInfluence;
@@ -47,9 +50,83 @@ class YParticleSystem;
 
 
 
+//-----------------------------------------------------------------------------
+// name: enum YParticleChannel
+// desc: slewed quantities of a particle (a lane each in YParticleData)
+//-----------------------------------------------------------------------------
+enum YParticleChannel
+{
+    Y_PARTICLE_X = 0,
+    Y_PARTICLE_Y,
+    Y_PARTICLE_Z,
+    // offsets added after the multiplier (velocity moves these)
+    Y_PARTICLE_DX,
+    Y_PARTICLE_DY,
+    Y_PARTICLE_DZ,
+    Y_PARTICLE_ALPHA,
+    Y_PARTICLE_ORI_X,
+    Y_PARTICLE_ORI_Y,
+    Y_PARTICLE_ORI_Z,
+    Y_PARTICLE_MULTIPLIER,
+    Y_PARTICLE_NUM_CHANNELS
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: struct YParticleLane
+// desc: one channel of every particle; value moves toward goal by slew per
+//       second (as Vector3D::interp)
+//-----------------------------------------------------------------------------
+struct YParticleLane
+{
+    std::vector<GLfloat> value;
+    std::vector<GLfloat> goal;
+    std::vector<GLfloat> slew;
+
+    // set slot i's goal and slew
+    void update( size_t i, GLfloat _goal, GLfloat _slew ) { goal[i] = _goal; slew[i] = _slew; }
+    // set slot i's goal and value
+    void updateSet( size_t i, GLfloat v ) { goal[i] = value[i] = v; }
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: struct YParticleData
+// desc: particle state by field (structure of arrays) -- slot i is the i-th
+//       particle of the system, the live ones first
+//-----------------------------------------------------------------------------
+struct YParticleData
+{
+    // slewed channels
+    YParticleLane lanes[Y_PARTICLE_NUM_CHANNELS];
+    // velocity (per second, moves the offsets)
+    std::vector<GLfloat> vx, vy, vz;
+    // location after the last update (X * multiplier + DX, ...)
+    std::vector<GLfloat> px, py, pz;
+    // random state per particle (for noise)
+    std::vector<unsigned int> seed;
+    // seconds to live (killed at 0)
+    std::vector<GLfloat> life;
+
+    // number of slots
+    size_t size() const { return vx.size(); }
+    // add a slot as a new YParticle starts out
+    void push();
+    // exchange two slots
+    void swap( size_t a, size_t b );
+};
+
+
+
+
 //-----------------------------------------------------------------------------
 // name: class YParticle
-// desc: ...
+// desc: a particle's entity (what is drawn); its state lives in the system's
+//       YParticleData, which writes loc / ori / alpha here each update
 //-----------------------------------------------------------------------------
 class YParticle : public YFlare
 {
@@ -58,38 +135,27 @@ public:
     virtual ~YParticle() { }
 
 public:
+    // set location (and the X / Y channels) as the origin
     void setLocAsOrig( const Vector3D & v );
+    // the system it belongs to (NULL: none yet), and its slot there (changes
+    // as the system packs its live particles)
+    YParticleSystem * system() const { return m_system; }
+    size_t slot() const { return m_slot; }
 
 public:
-    virtual void update( YTimeInterval dt );
+    // nothing to do (the system moves its particles); children are updated
+    virtual void update( YTimeInterval dt ) { }
     virtual void render();
 
 public:
-    // radius
-    // Vector3D radius;
-    // multiplier
-    Vector3D multiplier;
-
-public:
-    Vector3D X;
-    Vector3D Y;
-    Vector3D Z;
-    Vector3D dX;
-    Vector3D dY;
-    Vector3D dZ;
-    Vector3D ALPHA;
-    Vector3D oriX;
-    Vector3D oriY;
-    Vector3D oriZ;
-
-//    Vector3D velX;
-//    Vector3D velY;
-//    Vector3D velZ;
-
+    // where converge() goes back to
     Vector3D origLoc;
     Vector3D origOri;
 
 protected:
+    friend class YParticleSystem;
+    YParticleSystem * m_system;
+    size_t m_slot;
     bool m_isFree;
 };
 
@@ -98,12 +164,85 @@ protected:
 
 //-----------------------------------------------------------------------------
 // name: class YParticleInfluence
-// desc: ...
+// desc: a kernel over the live particles -- slots [0, count) of data, which
+//       are contiguous, so straight loops over the lanes vectorize
 //-----------------------------------------------------------------------------
 class YParticleInfluence
 {
 public:
-    virtual void update( YParticle * frag, YTimeInterval dt ) { }
+    virtual ~YParticleInfluence() { }
+    virtual void apply( YParticleData & data, size_t count, YTimeInterval dt ) = 0;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class YParticleGravity
+// desc: constant acceleration
+//-----------------------------------------------------------------------------
+class YParticleGravity : public YParticleInfluence
+{
+public:
+    YParticleGravity( const Vector3D & g ) : gravity( g ) { }
+    void apply( YParticleData & data, size_t count, YTimeInterval dt );
+
+public:
+    Vector3D gravity;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class YParticleDrag
+// desc: velocity loses amount of itself per second
+//-----------------------------------------------------------------------------
+class YParticleDrag : public YParticleInfluence
+{
+public:
+    YParticleDrag( GLfloat _amount ) : amount( _amount ) { }
+    void apply( YParticleData & data, size_t count, YTimeInterval dt );
+
+public:
+    GLfloat amount;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class YParticleAttractor
+// desc: pulls toward a point, harder the farther away (a spring)
+//-----------------------------------------------------------------------------
+class YParticleAttractor : public YParticleInfluence
+{
+public:
+    YParticleAttractor( const Vector3D & _point, GLfloat _strength )
+        : point( _point ), strength( _strength ) { }
+    void apply( YParticleData & data, size_t count, YTimeInterval dt );
+
+public:
+    Vector3D point;
+    GLfloat strength;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class YParticleNoise
+// desc: random acceleration in [-amount, amount] per axis, each particle
+//       with its own generator
+//-----------------------------------------------------------------------------
+class YParticleNoise : public YParticleInfluence
+{
+public:
+    YParticleNoise( GLfloat _amount ) : amount( _amount ) { }
+    void apply( YParticleData & data, size_t count, YTimeInterval dt );
+
+public:
+    GLfloat amount;
 };
 
 
@@ -124,12 +263,16 @@ public:
 
 //-----------------------------------------------------------------------------
 // name: class YParticleSystem
-// desc: ...
+// desc: particles and the influences on them. The live particles are always
+//       the first numActive() slots: spawn() takes the next slot and a kill
+//       moves the last live particle into the dead one's, both O(1), so
+//       update() runs each influence and then the slews over exactly the
+//       live span however large the system is
 //-----------------------------------------------------------------------------
 class YParticleSystem : public YFlare
 {
 public:
-    YParticleSystem() : m_numActive(0) { this->active = true; }
+    YParticleSystem() : m_numActive(0), m_numSpawned(0), m_numKilled(0) { this->active = true; }
 
 public:
     virtual void addParticle( YParticle * particle );
@@ -140,10 +283,21 @@ public:
 //    void buildAll( YFXRender * fx );
 
 public:
-    // get and activate the next particle (if available)
-    YParticle * spawn();
+    // get and activate the next particle (if available), to live for
+    // lifetime seconds
+    YParticle * spawn( GLfloat lifetime = Y_PARTICLE_FOREVER );
+    // end a live particle now (one made inactive, or out of life, is killed
+    // by the next update)
+    void kill( YParticle * particle );
     // get all particles in system
     std::vector<YParticle *> & getParticles() { return m_particles; }
+    // their state, by slot
+    YParticleData & data() { return m_data; }
+    // live particles (the first numActive() of getParticles() / data())
+    size_t numActive() const { return m_numActive; }
+    // spawned / killed since the system was made
+    unsigned long numSpawned() const { return m_numSpawned; }
+    unsigned long numKilled() const { return m_numKilled; }
 
 public:
     void explode( GLfloat xUpBound, GLfloat yzBound, GLfloat oBound,
@@ -155,11 +309,20 @@ public:
     virtual void render();
 
 protected:
-    void packActiveParticles();
+    // exchange two slots (particles and state)
+    void swapSlots( size_t a, size_t b );
+    // kill the particle in a live slot (the last live one moves there)
+    void killSlot( size_t i );
+    // slews, velocity into the offsets and life, results out to the
+    // entities (killing the dead)
+    void integrate( size_t count, YTimeInterval dt );
     std::vector<YParticle *> m_particles;
     std::vector<YParticleInfluence *> m_influences;
+    YParticleData m_data;
     // num active
     unsigned long m_numActive;
+    unsigned long m_numSpawned;
+    unsigned long m_numKilled;
 };
 
 
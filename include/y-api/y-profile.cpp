@@ -0,0 +1,453 @@
+/*----------------------------------------------------------------------------
+  MCD-Y: higher-level objects for audio/graphics/interaction programming
+         (sibling of MCD-X API)
+
+  Copyright (c) 2013 Ge Wang
+    All rights reserved.
+    http://ccrma.stanford.edu/~ge/
+
+  Music, Computing, Design Group @ CCRMA, Stanford University
+    http://ccrma.stanford.edu/groups/mcd/
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  U.S.A.
+-----------------------------------------------------------------------------*/
+
+//-----------------------------------------------------------------------------
+// name: y-profile.cpp
+// desc: scene graph profiler -- node counts, bytes, update and render time
+//       per entity type, and deep / wide spots in the tree
+//
+// name: Myles Borins
+// date: fall 2013
+//-----------------------------------------------------------------------------
+#include "y-profile.h"
+#include "x-fun.h"
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
+using namespace std;
+
+
+// default hotspot limits
+#define Y_PROFILE_WIDE 256
+#define Y_PROFILE_DEEP 32
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: YSceneProfiler()
+// desc: constructor
+//-----------------------------------------------------------------------------
+YSceneProfiler::YSceneProfiler()
+{
+    m_numTypes = 0;
+    m_numHotspots = 0;
+    m_wide = Y_PROFILE_WIDE;
+    m_deep = Y_PROFILE_DEEP;
+    m_budget = 1.0 / 60;
+    m_updateFrames = 0;
+    m_renderFrames = 0;
+    m_censusTime = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: typeName()
+// desc: demangled where the compiler mangles
+//-----------------------------------------------------------------------------
+string YSceneProfiler::typeName( const type_info & type )
+{
+#if defined(__GNUC__)
+    int status = 0;
+    char * demangled = abi::__cxa_demangle( type.name(), NULL, NULL, &status );
+    if( demangled && status == 0 )
+    {
+        string s = demangled;
+        free( demangled );
+        return s;
+    }
+    free( demangled );
+#endif
+    // msvc: "class YText"
+    const char * name = type.name();
+    if( strncmp( name, "class ", 6 ) == 0 ) name += 6;
+    return name;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: entry()
+// desc: the entry for a type (made on first use; once all but the last slot
+//       are taken, new types share that last one, "(other)"); the caller
+//       holds m_mutex
+//-----------------------------------------------------------------------------
+YProfileType & YSceneProfiler::entry( const type_info & type )
+{
+    size_t i = 0;
+    for( ; i < m_numTypes; i++ )
+        if( m_types[i].type && *m_types[i].type == type ) return m_types[i];
+
+    // the overflow slot (no type: nothing else matches it)
+    if( m_numTypes >= Y_PROFILE_MAX_TYPES - 1 )
+    {
+        i = Y_PROFILE_MAX_TYPES - 1;
+        if( m_numTypes == Y_PROFILE_MAX_TYPES ) return m_types[i];
+    }
+    else i = m_numTypes;
+
+    YProfileType & t = m_types[i];
+    t.name = i == Y_PROFILE_MAX_TYPES - 1 ? "(other)" : typeName( type );
+    t.type = i == Y_PROFILE_MAX_TYPES - 1 ? NULL : &type;
+    t.nodes = t.bytes = t.maxChildren = 0;
+    t.maxDepth = 0;
+    t.updated = t.rendered = 0;
+    t.updateTime = t.renderTime = 0;
+    m_numTypes++;
+    return t;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: addUpdate()
+// desc: time spent updating count nodes of one type
+//-----------------------------------------------------------------------------
+void YSceneProfiler::addUpdate( const type_info & type, double seconds, size_t count )
+{
+    // (publish on the update thread and render on the GL thread add to the
+    // same entries)
+    m_mutex.acquire();
+    YProfileType & t = entry( type );
+    t.updated += count;
+    t.updateTime += seconds;
+    m_mutex.release();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: addRender()
+// desc: time spent rendering count nodes of one type
+//-----------------------------------------------------------------------------
+void YSceneProfiler::addRender( const type_info & type, double seconds, size_t count )
+{
+    m_mutex.acquire();
+    YProfileType & t = entry( type );
+    t.rendered += count;
+    t.renderTime += seconds;
+    m_mutex.release();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: reset()
+// desc: zero the times and frames
+//-----------------------------------------------------------------------------
+void YSceneProfiler::reset()
+{
+    m_mutex.acquire();
+    for( size_t i = 0; i < m_numTypes; i++ )
+    {
+        m_types[i].updated = m_types[i].rendered = 0;
+        m_types[i].updateTime = m_types[i].renderTime = 0;
+    }
+    m_updateFrames = 0;
+    m_renderFrames = 0;
+    m_mutex.release();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: census()
+// desc: count nodes, bytes and hotspots under root
+//-----------------------------------------------------------------------------
+void YSceneProfiler::census( YEntity & root )
+{
+    double start = XFun::now();
+
+    // (entries can be made or added to from another thread meanwhile)
+    m_mutex.acquire();
+    for( size_t i = 0; i < m_numTypes; i++ )
+    {
+        m_types[i].nodes = m_types[i].bytes = m_types[i].maxChildren = 0;
+        m_types[i].maxDepth = 0;
+    }
+    m_hotspots.clear();
+    m_numHotspots = 0;
+    census( &root, 0 );
+    m_mutex.release();
+
+    m_censusTime = XFun::now() - start;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: census()
+// desc: e and everything below it; hotspots are kept once their subtree is
+//       counted
+//-----------------------------------------------------------------------------
+size_t YSceneProfiler::census( YEntity * e, int depth )
+{
+    const vector<YEntity *> & children = e->getChildren();
+    YProfileType & t = entry( typeid( *e ) );
+    t.nodes++;
+    t.bytes += e->footprint();
+    t.maxChildren = std::max( t.maxChildren, children.size() );
+    t.maxDepth = std::max( t.maxDepth, depth );
+
+    size_t subtree = 1;
+    for( size_t i = 0; i < children.size(); i++ )
+        subtree += census( children[i], depth + 1 );
+
+    // too wide, or the first node past the depth limit on its path
+    bool wide = children.size() > m_wide;
+    if( wide || depth == m_deep + 1 )
+    {
+        if( m_hotspots.size() < Y_PROFILE_MAX_HOTSPOTS )
+        {
+            YProfileHotspot h;
+            h.wide = wide;
+            h.type = t.name;
+            h.name = e->name;
+            h.depth = depth;
+            h.children = children.size();
+            h.subtree = subtree;
+            m_hotspots.push_back( h );
+        }
+        m_numHotspots++;
+    }
+
+    return subtree;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: profile_heavier()
+// desc: more update + render time per frame first, then more bytes
+//-----------------------------------------------------------------------------
+struct profile_heavier
+{
+    double updateFrames, renderFrames;
+    double cost( const YProfileType * t ) const
+    { return t->updateTime / updateFrames + t->renderTime / renderFrames; }
+    bool operator()( const YProfileType * a, const YProfileType * b ) const
+    {
+        double ca = cost( a ), cb = cost( b );
+        if( ca != cb ) return ca > cb;
+        return a->bytes > b->bytes;
+    }
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: sorted()
+// desc: entries by time per frame, heaviest first
+//-----------------------------------------------------------------------------
+void YSceneProfiler::sorted( vector<const YProfileType *> & out ) const
+{
+    out.clear();
+    for( size_t i = 0; i < m_numTypes; i++ )
+        out.push_back( &m_types[i] );
+
+    profile_heavier heavier;
+    heavier.updateFrames = m_updateFrames ? m_updateFrames : 1;
+    heavier.renderFrames = m_renderFrames ? m_renderFrames : 1;
+    std::stable_sort( out.begin(), out.end(), heavier );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: report()
+// desc: print the table, heaviest first
+//-----------------------------------------------------------------------------
+void YSceneProfiler::report() const
+{
+    vector<const YProfileType *> types;
+    sorted( types );
+    double uf = m_updateFrames ? m_updateFrames : 1;
+    double rf = m_renderFrames ? m_renderFrames : 1;
+
+    fprintf( stderr, "[y-profile]: %lu update frames, %lu render frames, census %.3f ms, "
+             "budget %.2f ms\n", m_updateFrames, m_renderFrames, m_censusTime * 1000,
+             m_budget * 1000 );
+    fprintf( stderr, "[y-profile]: %-24s %8s %10s %6s %5s %10s %10s %7s\n", "type", "nodes",
+             "KB", "width", "depth", "update ms", "render ms", "budget" );
+
+    double totalUpdate = 0, totalRender = 0;
+    size_t totalNodes = 0, totalBytes = 0;
+    for( size_t i = 0; i < types.size(); i++ )
+    {
+        const YProfileType & t = *types[i];
+        double update = t.updateTime / uf, render = t.renderTime / rf;
+        fprintf( stderr, "[y-profile]: %-24s %8lu %10.1f %6lu %5d %10.3f %10.3f %6.1f%%\n",
+                 t.name.c_str(), (unsigned long)t.nodes, t.bytes / 1024.0,
+                 (unsigned long)t.maxChildren, t.maxDepth, update * 1000, render * 1000,
+                 ( update + render ) / m_budget * 100 );
+        totalUpdate += update;
+        totalRender += render;
+        totalNodes += t.nodes;
+        totalBytes += t.bytes;
+    }
+    fprintf( stderr, "[y-profile]: %-24s %8lu %10.1f %6s %5s %10.3f %10.3f %6.1f%%\n", "(total)",
+             (unsigned long)totalNodes, totalBytes / 1024.0, "", "", totalUpdate * 1000,
+             totalRender * 1000, ( totalUpdate + totalRender ) / m_budget * 100 );
+
+    for( size_t i = 0; i < m_hotspots.size(); i++ )
+    {
+        const YProfileHotspot & h = m_hotspots[i];
+        fprintf( stderr, "[y-profile]: %s %s '%s' at depth %d, %lu children, %lu nodes below\n",
+                 h.wide ? "wide" : "deep", h.type.c_str(), h.name.c_str(), h.depth,
+                 (unsigned long)h.children, (unsigned long)( h.subtree - 1 ) );
+    }
+    if( m_numHotspots > m_hotspots.size() )
+        fprintf( stderr, "[y-profile]: (%lu more hotspots)\n",
+                 (unsigned long)( m_numHotspots - m_hotspots.size() ) );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: writeCSV()
+// desc: one row per type (times per frame, in ms)
+//-----------------------------------------------------------------------------
+void YSceneProfiler::writeCSV( FILE * out ) const
+{
+    vector<const YProfileType *> types;
+    sorted( types );
+    double uf = m_updateFrames ? m_updateFrames : 1;
+    double rf = m_renderFrames ? m_renderFrames : 1;
+
+    fprintf( out, "type,nodes,bytes,max_children,max_depth,updated,update_ms,rendered,render_ms\n" );
+    for( size_t i = 0; i < types.size(); i++ )
+    {
+        const YProfileType & t = *types[i];
+        fprintf( out, "%s,%lu,%lu,%lu,%d,%.1f,%.6f,%.1f,%.6f\n", t.name.c_str(),
+                 (unsigned long)t.nodes, (unsigned long)t.bytes,
+                 (unsigned long)t.maxChildren, t.maxDepth, t.updated / uf,
+                 t.updateTime / uf * 1000, t.rendered / rf, t.renderTime / rf * 1000 );
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: profile_json_string()
+// desc: s as a JSON string
+//-----------------------------------------------------------------------------
+static void profile_json_string( FILE * out, const string & s )
+{
+    fputc( '"', out );
+    for( size_t i = 0; i < s.size(); i++ )
+    {
+        unsigned char c = (unsigned char)s[i];
+        if( c == '"' || c == '\\' ) fprintf( out, "\\%c", c );
+        else if( c < 0x20 ) fprintf( out, "\\u%04x", c );
+        else fputc( c, out );
+    }
+    fputc( '"', out );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: writeJSON()
+// desc: frames, types (times per frame, in ms) and hotspots
+//-----------------------------------------------------------------------------
+void YSceneProfiler::writeJSON( FILE * out ) const
+{
+    vector<const YProfileType *> types;
+    sorted( types );
+    double uf = m_updateFrames ? m_updateFrames : 1;
+    double rf = m_renderFrames ? m_renderFrames : 1;
+
+    fprintf( out, "{\n  \"update_frames\": %lu,\n  \"render_frames\": %lu,\n"
+             "  \"budget_ms\": %.3f,\n  \"census_ms\": %.3f,\n  \"types\": [",
+             m_updateFrames, m_renderFrames, m_budget * 1000, m_censusTime * 1000 );
+    for( size_t i = 0; i < types.size(); i++ )
+    {
+        const YProfileType & t = *types[i];
+        fprintf( out, "%s\n    { \"type\": ", i ? "," : "" );
+        profile_json_string( out, t.name );
+        fprintf( out, ", \"nodes\": %lu, \"bytes\": %lu, \"max_children\": %lu, "
+                 "\"max_depth\": %d, \"updated\": %.1f, \"update_ms\": %.6f, "
+                 "\"rendered\": %.1f, \"render_ms\": %.6f }",
+                 (unsigned long)t.nodes, (unsigned long)t.bytes,
+                 (unsigned long)t.maxChildren, t.maxDepth, t.updated / uf,
+                 t.updateTime / uf * 1000, t.rendered / rf, t.renderTime / rf * 1000 );
+    }
+    fprintf( out, "\n  ],\n  \"hotspots\": [" );
+    for( size_t i = 0; i < m_hotspots.size(); i++ )
+    {
+        const YProfileHotspot & h = m_hotspots[i];
+        fprintf( out, "%s\n    { \"kind\": \"%s\", \"type\": ", i ? "," : "",
+                 h.wide ? "wide" : "deep" );
+        profile_json_string( out, h.type );
+        fprintf( out, ", \"name\": " );
+        profile_json_string( out, h.name );
+        fprintf( out, ", \"depth\": %d, \"children\": %lu, \"subtree\": %lu }", h.depth,
+                 (unsigned long)h.children, (unsigned long)h.subtree );
+    }
+    fprintf( out, "\n  ],\n  \"hotspots_found\": %lu\n}\n", (unsigned long)m_numHotspots );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: save()
+// desc: JSON if path ends in .json, else CSV
+//-----------------------------------------------------------------------------
+bool YSceneProfiler::save( const char * path ) const
+{
+    FILE * out = fopen( path, "w" );
+    if( !out )
+    {
+        fprintf( stderr, "[y-profile]: cannot write '%s'\n", path );
+        return false;
+    }
+
+    size_t len = strlen( path );
+    if( len >= 5 && strcmp( path + len - 5, ".json" ) == 0 ) writeJSON( out );
+    else writeCSV( out );
+
+    fclose( out );
+    return true;
+}
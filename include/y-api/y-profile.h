@@ -0,0 +1,181 @@
+/*----------------------------------------------------------------------------
+  MCD-Y: higher-level objects for audio/graphics/interaction programming
+         (sibling of MCD-X API)
+
+  Copyright (c) 2013 Ge Wang
+    All rights reserved.
+    http://ccrma.stanford.edu/~ge/
+
+  Music, Computing, Design Group @ CCRMA, Stanford University
+    http://ccrma.stanford.edu/groups/mcd/
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  U.S.A.
+-----------------------------------------------------------------------------*/
+
+//-----------------------------------------------------------------------------
+// name: y-profile.h
+// desc: scene graph profiler -- node counts, bytes, update and render time
+//       per entity type, and deep / wide spots in the tree
+//
+// name: Myles Borins
+// date: fall 2013
+//-----------------------------------------------------------------------------
+#ifndef __MCD_Y_PROFILE_H__
+#define __MCD_Y_PROFILE_H__
+
+#include "y-entity.h"
+#include "x-thread.h"
+#include <stdio.h>
+#include <typeinfo>
+#include <vector>
+#include <string>
+
+// types tracked (the last slot is "(other)": the types that didn't fit)
+#define Y_PROFILE_MAX_TYPES 64
+// hotspots kept per census
+#define Y_PROFILE_MAX_HOTSPOTS 16
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: struct YProfileType
+// desc: what one entity type costs
+//-----------------------------------------------------------------------------
+struct YProfileType
+{
+    // class name
+    std::string name;
+    const std::type_info * type;
+    // last census: nodes, their YEntity::footprint(), most children of one
+    // node, deepest node (root: 0)
+    size_t nodes;
+    size_t bytes;
+    size_t maxChildren;
+    int maxDepth;
+    // since reset: nodes updated / rendered and the time it took (seconds)
+    unsigned long updated;
+    double updateTime;
+    unsigned long rendered;
+    double renderTime;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: struct YProfileHotspot
+// desc: a node with too many children, or the first one too deep
+//-----------------------------------------------------------------------------
+struct YProfileHotspot
+{
+    // wide or deep
+    bool wide;
+    std::string type;
+    std::string name;
+    int depth;
+    size_t children;
+    // nodes in its subtree (itself included)
+    size_t subtree;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class YSceneProfiler
+// desc: census() counts the tree on demand; YUpdateScheduler and YDrawList
+//       given the profiler add their time per type as they go (runs of
+//       nodes of one type are timed together), and updateFrame() /
+//       renderFrame() count frames for per-frame averages. Time may be added
+//       from the update and the render thread at once; census() and the
+//       readers need the tree to hold still
+//-----------------------------------------------------------------------------
+class YSceneProfiler
+{
+public:
+    YSceneProfiler();
+
+public:
+    // hotspots: more than wide children, or deeper than deep
+    void setLimits( size_t wide, int deep ) { m_wide = wide; m_deep = deep; }
+    // frame time the report measures against (seconds)
+    void setBudget( double seconds ) { m_budget = seconds; }
+    // count nodes, bytes and hotspots under root (inactive ones too)
+    void census( YEntity & root );
+    // zero the times and frames (keeps the census)
+    void reset();
+
+public:
+    // time spent updating / rendering count nodes of one type (seconds)
+    void addUpdate( const std::type_info & type, double seconds, size_t count );
+    void addRender( const std::type_info & type, double seconds, size_t count );
+    // a frame's update / render is done
+    void updateFrame() { m_updateFrames++; }
+    void renderFrame() { m_renderFrames++; }
+
+public:
+    size_t numTypes() const { return m_numTypes; }
+    const YProfileType & type( size_t i ) const { return m_types[i]; }
+    // kept hotspots, and how many the census found
+    const std::vector<YProfileHotspot> & hotspots() const { return m_hotspots; }
+    size_t numHotspots() const { return m_numHotspots; }
+    unsigned long updateFrames() const { return m_updateFrames; }
+    unsigned long renderFrames() const { return m_renderFrames; }
+    // last census (seconds)
+    double censusTime() const { return m_censusTime; }
+
+public:
+    // print the table, heaviest first
+    void report() const;
+    // one row per type
+    void writeCSV( FILE * out ) const;
+    // types and hotspots
+    void writeJSON( FILE * out ) const;
+    // JSON if path ends in .json, else CSV
+    bool save( const char * path ) const;
+
+public:
+    // readable class name
+    static std::string typeName( const std::type_info & type );
+
+protected:
+    // the entry for a type (made on first use; caller holds m_mutex)
+    YProfileType & entry( const std::type_info & type );
+    // census of e at depth; returns its subtree size
+    size_t census( YEntity * e, int depth );
+    // entries by time per frame, heaviest first
+    void sorted( std::vector<const YProfileType *> & out ) const;
+
+protected:
+    YProfileType m_types[Y_PROFILE_MAX_TYPES];
+    size_t m_numTypes;
+    // guards the entries (making them and adding to them)
+    XMutex m_mutex;
+    std::vector<YProfileHotspot> m_hotspots;
+    size_t m_numHotspots;
+    size_t m_wide;
+    int m_deep;
+    double m_budget;
+    unsigned long m_updateFrames;
+    unsigned long m_renderFrames;
+    double m_censusTime;
+};
+
+
+
+
+#endif
@@ -0,0 +1,200 @@
+/*----------------------------------------------------------------------------
+  MCD-Y: higher-level objects for audio/graphics/interaction programming
+         (sibling of MCD-X API)
+
+  Copyright (c) 2013 Ge Wang
+    All rights reserved.
+    http://ccrma.stanford.edu/~ge/
+
+  Music, Computing, Design Group @ CCRMA, Stanford University
+    http://ccrma.stanford.edu/groups/mcd/
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  U.S.A.
+-----------------------------------------------------------------------------*/
+
+//-----------------------------------------------------------------------------
+// name: y-slab.cpp
+// desc: slab allocation for scene nodes -- objects of one type handed out
+//       back to back from large chunks, so nodes created together (siblings,
+//       in traversal order) sit together in memory
+//
+// name: Myles Borins
+// date: fall 2013
+//-----------------------------------------------------------------------------
+#include "y-slab.h"
+#include <stdio.h>
+#include <new>
+#include <algorithm>
+using namespace std;
+
+
+
+
+// slot alignment (what malloc guarantees)
+#define Y_SLAB_ALIGN 16
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: y_slab_registry()
+// desc: every slab (constructed on first use, before any slab registers)
+//-----------------------------------------------------------------------------
+static vector<YSlab *> & y_slab_registry()
+{
+    static vector<YSlab *> slabs;
+    return slabs;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: YSlab()
+// desc: constructor
+//-----------------------------------------------------------------------------
+YSlab::YSlab( const char * name, size_t size, size_t perChunk )
+{
+    m_name = name;
+    // room for the free list link, rounded to the alignment
+    if( size < sizeof(void *) ) size = sizeof(void *);
+    m_size = ( size + Y_SLAB_ALIGN - 1 ) / Y_SLAB_ALIGN * Y_SLAB_ALIGN;
+    m_perChunk = perChunk > 0 ? perChunk : 1;
+    m_free = NULL;
+    m_next = m_end = NULL;
+    m_count = 0;
+
+    y_slab_registry().push_back( this );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: ~YSlab()
+// desc: destructor (objects still alive at exit keep their chunks)
+//-----------------------------------------------------------------------------
+YSlab::~YSlab()
+{
+    if( m_count == 0 ) releaseChunks();
+
+    vector<YSlab *> & slabs = y_slab_registry();
+    slabs.erase( std::remove( slabs.begin(), slabs.end(), this ), slabs.end() );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: allocate()
+// desc: a released slot if there is one, else the next in the newest chunk
+//-----------------------------------------------------------------------------
+void * YSlab::allocate()
+{
+    void * p = m_free;
+    if( p )
+    {
+        m_free = *(void **)p;
+    }
+    else
+    {
+        if( m_next == m_end ) grow();
+        p = m_next;
+        m_next += m_size;
+    }
+
+    m_count++;
+    return p;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: release()
+// desc: give a slot back; the last one out returns the chunks
+//-----------------------------------------------------------------------------
+void YSlab::release( void * p )
+{
+    if( !p ) return;
+
+    *(void **)p = m_free;
+    m_free = p;
+    if( --m_count == 0 ) releaseChunks();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: grow()
+// desc: another chunk to hand out from
+//-----------------------------------------------------------------------------
+void YSlab::grow()
+{
+    char * chunk = (char *)::operator new( m_perChunk * m_size );
+    m_chunks.push_back( chunk );
+    m_next = chunk;
+    m_end = chunk + m_perChunk * m_size;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: releaseChunks()
+// desc: all chunks back to the heap (nothing may be live)
+//-----------------------------------------------------------------------------
+void YSlab::releaseChunks()
+{
+    for( size_t i = 0; i < m_chunks.size(); i++ )
+        ::operator delete( m_chunks[i] );
+    m_chunks.clear();
+    m_free = NULL;
+    m_next = m_end = NULL;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: slabs()
+// desc: every slab, for reporting
+//-----------------------------------------------------------------------------
+const vector<YSlab *> & YSlab::slabs()
+{
+    return y_slab_registry();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: report()
+// desc: print objects and bytes per type
+//-----------------------------------------------------------------------------
+void YSlab::report()
+{
+    const vector<YSlab *> & slabs = y_slab_registry();
+    for( size_t i = 0; i < slabs.size(); i++ )
+    {
+        const YSlab * s = slabs[i];
+        fprintf( stderr, "[y-slab]: %-16s %8lu objects x %4lu bytes, %8.1f KB used of %8.1f KB in %lu chunks\n",
+                 s->name(), (unsigned long)s->numObjects(), (unsigned long)s->slotSize(),
+                 s->bytesUsed() / 1024.0, s->bytesReserved() / 1024.0,
+                 (unsigned long)s->numChunks() );
+    }
+}
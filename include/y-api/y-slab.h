@@ -0,0 +1,131 @@
+/*----------------------------------------------------------------------------
+  MCD-Y: higher-level objects for audio/graphics/interaction programming
+         (sibling of MCD-X API)
+
+  Copyright (c) 2013 Ge Wang
+    All rights reserved.
+    http://ccrma.stanford.edu/~ge/
+
+  Music, Computing, Design Group @ CCRMA, Stanford University
+    http://ccrma.stanford.edu/groups/mcd/
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  U.S.A.
+-----------------------------------------------------------------------------*/
+
+//-----------------------------------------------------------------------------
+// name: y-slab.h
+// desc: slab allocation for scene nodes -- objects of one type handed out
+//       back to back from large chunks, so nodes created together (siblings,
+//       in traversal order) sit together in memory
+//
+// name: Myles Borins
+// date: fall 2013
+//-----------------------------------------------------------------------------
+#ifndef __MCD_Y_SLAB_H__
+#define __MCD_Y_SLAB_H__
+
+#include <stddef.h>
+#include <vector>
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class YSlab
+// desc: fixed size objects from chunks of perChunk; freed slots are reused
+//       first, and the chunks go back to the heap once every object is
+//       released. Not thread safe: create and delete a type's objects on
+//       one thread (the one updating the scene)
+//-----------------------------------------------------------------------------
+class YSlab
+{
+public:
+    YSlab( const char * name, size_t size, size_t perChunk );
+    ~YSlab();
+
+public:
+    // an uninitialized slot
+    void * allocate();
+    // give a slot back
+    void release( void * p );
+
+public:
+    const char * name() const { return m_name; }
+    // object size, rounded up to the slot alignment
+    size_t slotSize() const { return m_size; }
+    // live objects
+    size_t numObjects() const { return m_count; }
+    size_t numChunks() const { return m_chunks.size(); }
+    // bytes in live objects / held in chunks
+    size_t bytesUsed() const { return m_count * m_size; }
+    size_t bytesReserved() const { return m_chunks.size() * m_perChunk * m_size; }
+
+public:
+    // every slab, for reporting
+    static const std::vector<YSlab *> & slabs();
+    // print objects and bytes per type
+    static void report();
+
+protected:
+    // another chunk to hand out from
+    void grow();
+    // all chunks back to the heap
+    void releaseChunks();
+
+protected:
+    const char * m_name;
+    size_t m_size;
+    size_t m_perChunk;
+    std::vector<char *> m_chunks;
+    // released slots (linked through their first word)
+    void * m_free;
+    // rest of the newest chunk
+    char * m_next;
+    char * m_end;
+    size_t m_count;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// Y_SLAB_ALLOCATED goes in the class declaration, Y_SLAB_DEFINE in its .cpp:
+// new / delete of exactly that class use its slab (subclasses, being
+// bigger, fall back to the heap). Deleting through a base pointer passes
+// the right size as long as the destructor is virtual (it is for YEntity)
+//-----------------------------------------------------------------------------
+#define Y_SLAB_ALLOCATED \
+public: \
+    static void * operator new( size_t size ); \
+    static void operator delete( void * p, size_t size ); \
+    static YSlab ourSlab;
+
+#define Y_SLAB_DEFINE( type, perChunk ) \
+    YSlab type::ourSlab( #type, sizeof(type), perChunk ); \
+    void * type::operator new( size_t size ) \
+    { \
+        return size == sizeof(type) ? ourSlab.allocate() : ::operator new( size ); \
+    } \
+    void type::operator delete( void * p, size_t size ) \
+    { \
+        if( size == sizeof(type) ) ourSlab.release( p ); \
+        else ::operator delete( p ); \
+    }
+
+
+
+
+#endif
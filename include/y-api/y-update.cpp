@@ -0,0 +1,347 @@
+/*----------------------------------------------------------------------------
+  MCD-Y: higher-level objects for audio/graphics/interaction programming
+         (sibling of MCD-X API)
+
+  Copyright (c) 2013 Ge Wang
+    All rights reserved.
+    http://ccrma.stanford.edu/~ge/
+
+  Music, Computing, Design Group @ CCRMA, Stanford University
+    http://ccrma.stanford.edu/groups/mcd/
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  U.S.A.
+-----------------------------------------------------------------------------*/
+
+//-----------------------------------------------------------------------------
+// name: y-update.cpp
+// desc: type-batched update pass -- replaces updateAll() with one loop per
+//       entity type over nodes gathered from the scene graph
+//
+// name: Myles Borins
+// date: fall 2013
+//-----------------------------------------------------------------------------
+#include "y-update.h"
+#include "y-profile.h"
+#include "x-fun.h"
+#include <stdio.h>
+#include <algorithm>
+using namespace std;
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: struct YUpdateBatch
+// desc: a registered batch
+//-----------------------------------------------------------------------------
+struct YUpdateBatch
+{
+    const std::type_info * type;
+    const char * name;
+    YUpdateBatchFunc * func;
+    int stage;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: update_batches()
+// desc: every registered batch, by id (constructed on first use, before any
+//       type registers)
+//-----------------------------------------------------------------------------
+static vector<YUpdateBatch> & update_batches()
+{
+    static vector<YUpdateBatch> batches;
+    return batches;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: update_by_stage()
+// desc: orders batch ids by stage (ties by id)
+//-----------------------------------------------------------------------------
+static bool update_by_stage( int a, int b )
+{
+    const vector<YUpdateBatch> & batches = update_batches();
+    if( batches[a].stage != batches[b].stage )
+        return batches[a].stage < batches[b].stage;
+    return a < b;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: YUpdateScheduler()
+// desc: constructor
+//-----------------------------------------------------------------------------
+YUpdateScheduler::YUpdateScheduler()
+{
+    m_root = NULL;
+    m_version = 0;
+    m_profiler = NULL;
+    m_numGathers = 0;
+    m_gatherTime = 0;
+    m_updateTime = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: registerBatch()
+// desc: add a batch for a type; returns its id
+//-----------------------------------------------------------------------------
+int YUpdateScheduler::registerBatch( const std::type_info & type, const char * name,
+                                     YUpdateBatchFunc * func, int stage )
+{
+    YUpdateBatch batch;
+    batch.type = &type;
+    batch.name = name;
+    batch.func = func;
+    batch.stage = stage;
+    update_batches().push_back( batch );
+    return (int)update_batches().size() - 1;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: update()
+// desc: gather if the tree changed, then run the batches by stage
+//-----------------------------------------------------------------------------
+void YUpdateScheduler::update( YEntity & root, YTimeInterval dt )
+{
+    // gather
+    if( m_root != &root || m_version != root.getTreeVersion() )
+    {
+        double start = XFun::now();
+        const vector<YUpdateBatch> & batches = update_batches();
+
+        m_nodes.resize( batches.size() );
+        m_index.resize( batches.size() );
+        for( size_t i = 0; i < m_nodes.size(); i++ )
+        {
+            m_nodes[i].clear();
+            m_index[i].clear();
+        }
+        m_unbatched.clear();
+        m_unbatchedIndex.clear();
+        m_all.clear();
+        m_end.clear();
+        gather( &root );
+        m_live.resize( m_all.size() );
+
+        // stage order
+        m_order.clear();
+        for( size_t i = 0; i < batches.size(); i++ )
+            m_order.push_back( (int)i );
+        std::sort( m_order.begin(), m_order.end(), update_by_stage );
+
+        m_root = &root;
+        m_version = root.getTreeVersion();
+        m_numGathers++;
+        m_gatherTime = XFun::now() - start;
+    }
+
+    double start = XFun::now();
+    // who runs (flags may have changed since the gather)
+    bool all = markLive();
+
+    if( m_profiler )
+    {
+        updateProfiled( dt, all );
+        m_updateTime = XFun::now() - start;
+        return;
+    }
+
+    // one at a time, scene graph order
+    for( size_t i = 0; i < m_unbatched.size(); i++ )
+        if( all || m_live[m_unbatchedIndex[i]] )
+            m_unbatched[i]->update( dt );
+
+    // by stage
+    const vector<YUpdateBatch> & batches = update_batches();
+    for( size_t i = 0; i < m_order.size(); i++ )
+    {
+        vector<YEntity *> & nodes = live( m_order[i], all );
+        if( nodes.size() )
+            batches[m_order[i]].func( &nodes[0], nodes.size(), dt );
+    }
+
+    m_updateTime = XFun::now() - start;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: updateProfiled()
+// desc: as update, timing consecutive unbatched nodes of one type together
+//       and each batch as its first node's type
+//-----------------------------------------------------------------------------
+void YUpdateScheduler::updateProfiled( YTimeInterval dt, bool all )
+{
+    size_t i = 0;
+    while( i < m_unbatched.size() )
+    {
+        const type_info & type = typeid( *m_unbatched[i] );
+        double start = XFun::now();
+        size_t end = i, count = 0;
+        for( ; end < m_unbatched.size() && typeid( *m_unbatched[end] ) == type; end++ )
+        {
+            if( !all && !m_live[m_unbatchedIndex[end]] ) continue;
+            m_unbatched[end]->update( dt );
+            count++;
+        }
+        m_profiler->addUpdate( type, XFun::now() - start, count );
+        i = end;
+    }
+
+    const vector<YUpdateBatch> & batches = update_batches();
+    for( size_t i = 0; i < m_order.size(); i++ )
+    {
+        vector<YEntity *> & nodes = live( m_order[i], all );
+        if( nodes.empty() ) continue;
+        double start = XFun::now();
+        batches[m_order[i]].func( &nodes[0], nodes.size(), dt );
+        m_profiler->addUpdate( typeid( *nodes[0] ), XFun::now() - start, nodes.size() );
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: gather()
+// desc: e, then its children (as updateAll visits them)
+//-----------------------------------------------------------------------------
+void YUpdateScheduler::gather( YEntity * e )
+{
+    size_t index = m_all.size();
+    m_all.push_back( e );
+    m_end.push_back( 0 );
+
+    // a subclass that inherits its base's batch would run the base's update
+    int batch = e->updateBatch();
+    if( batch >= 0 && typeid( *e ) != *update_batches()[batch].type )
+        batch = -1;
+    if( batch >= 0 )
+    {
+        m_nodes[batch].push_back( e );
+        m_index[batch].push_back( index );
+    }
+    else
+    {
+        m_unbatched.push_back( e );
+        m_unbatchedIndex.push_back( index );
+    }
+
+    const vector<YEntity *> & children = e->getChildren();
+    for( size_t i = 0; i < children.size(); i++ )
+        gather( children[i] );
+    m_end[index] = m_all.size();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: markLive()
+// desc: marks the nodes updateAll would visit now; false if any is left out
+//-----------------------------------------------------------------------------
+bool YUpdateScheduler::markLive()
+{
+    // usually every node is on: just look
+    size_t i = 0;
+    while( i < m_all.size() && m_all[i]->active )
+        i++;
+    if( i == m_all.size() ) return true;
+
+    // some are off, and so is everything under them
+    i = 0;
+    while( i < m_all.size() )
+    {
+        if( m_all[i]->active )
+        {
+            m_live[i++] = 1;
+            continue;
+        }
+        for( size_t end = m_end[i]; i < end; i++ )
+            m_live[i] = 0;
+    }
+
+    return false;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: live()
+// desc: nodes of batch b to run -- the whole list, or its live nodes
+//-----------------------------------------------------------------------------
+vector<YEntity *> & YUpdateScheduler::live( int b, bool all )
+{
+    if( all ) return m_nodes[b];
+
+    m_run.clear();
+    const vector<YEntity *> & nodes = m_nodes[b];
+    const vector<size_t> & index = m_index[b];
+    for( size_t i = 0; i < nodes.size(); i++ )
+        if( m_live[index[i]] ) m_run.push_back( nodes[i] );
+    return m_run;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: numBatches()
+// desc: batches with nodes
+//-----------------------------------------------------------------------------
+size_t YUpdateScheduler::numBatches() const
+{
+    size_t count = 0;
+    for( size_t i = 0; i < m_nodes.size(); i++ )
+        if( m_nodes[i].size() ) count++;
+    return count;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: report()
+// desc: print nodes per batch
+//-----------------------------------------------------------------------------
+void YUpdateScheduler::report() const
+{
+    const vector<YUpdateBatch> & batches = update_batches();
+    fprintf( stderr, "[y-update]: %lu nodes, %lu unbatched, gathered %lu times (last %.3f ms), "
+             "update %.3f ms\n", (unsigned long)m_all.size(), (unsigned long)m_unbatched.size(),
+             m_numGathers, m_gatherTime * 1000, m_updateTime * 1000 );
+    for( size_t i = 0; i < m_order.size(); i++ )
+    {
+        const YUpdateBatch & b = batches[m_order[i]];
+        fprintf( stderr, "[y-update]:   stage %d %-16s %8lu nodes\n", b.stage, b.name,
+                 (unsigned long)m_nodes[m_order[i]].size() );
+    }
+}
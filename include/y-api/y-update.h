@@ -0,0 +1,133 @@
+/*----------------------------------------------------------------------------
+  MCD-Y: higher-level objects for audio/graphics/interaction programming
+         (sibling of MCD-X API)
+
+  Copyright (c) 2013 Ge Wang
+    All rights reserved.
+    http://ccrma.stanford.edu/~ge/
+
+  Music, Computing, Design Group @ CCRMA, Stanford University
+    http://ccrma.stanford.edu/groups/mcd/
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  U.S.A.
+-----------------------------------------------------------------------------*/
+
+//-----------------------------------------------------------------------------
+// name: y-update.h
+// desc: type-batched update pass -- replaces updateAll() with one loop per
+//       entity type over nodes gathered from the scene graph
+//
+// name: Myles Borins
+// date: fall 2013
+//-----------------------------------------------------------------------------
+#ifndef __MCD_Y_UPDATE_H__
+#define __MCD_Y_UPDATE_H__
+
+#include "y-entity.h"
+#include <vector>
+#include <typeinfo>
+
+class YSceneProfiler;
+
+
+// updates count nodes of one type (in scene graph order)
+typedef void (YUpdateBatchFunc)( YEntity ** nodes, size_t count, YTimeInterval dt );
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class YUpdateScheduler
+// desc: update( root ) gathers the tree into one list per batch (see
+//       YEntity::updateBatch) and runs the batches by stage, lowest first;
+//       nodes without a batch run update() first, in scene graph order.
+//       Parents come before children only across stages, so a type must
+//       register at a later stage than the types it reads from above it.
+//       The lists are kept until the tree's structure changes; active flags
+//       are read on every update, and nodes that are off (or under one that
+//       is) are left out as updateAll leaves them out
+//-----------------------------------------------------------------------------
+class YUpdateScheduler
+{
+public:
+    YUpdateScheduler();
+
+public:
+    // add a batch for nodes of exactly this type (at static init); returns
+    // its id. A subclass that inherits the id runs update() one at a time
+    static int registerBatch( const std::type_info & type, const char * name,
+                              YUpdateBatchFunc * func, int stage );
+
+public:
+    // update the active tree under root (root included)
+    void update( YEntity & root, YTimeInterval dt );
+    // gather again on the next update
+    void invalidate() { m_root = NULL; }
+    // add update time per type to a profiler (NULL: don't)
+    void setProfiler( YSceneProfiler * profiler ) { m_profiler = profiler; }
+
+public:
+    // nodes gathered (on or off), and those that run update() one at a time
+    size_t numNodes() const { return m_all.size(); }
+    size_t numUnbatched() const { return m_unbatched.size(); }
+    // batches with nodes
+    size_t numBatches() const;
+    // times gathered, and the last gather / update (seconds)
+    unsigned long numGathers() const { return m_numGathers; }
+    double gatherTime() const { return m_gatherTime; }
+    double updateTime() const { return m_updateTime; }
+    // print nodes per batch
+    void report() const;
+
+protected:
+    // collect e and its subtree
+    void gather( YEntity * e );
+    // read the active flags; false if any node is left out
+    bool markLive();
+    // nodes of batch b to run (all of them, or those marked live)
+    std::vector<YEntity *> & live( int b, bool all );
+    // run the lists, timing each batch and run of unbatched nodes
+    void updateProfiled( YTimeInterval dt, bool all );
+
+protected:
+    // tree the lists were gathered from, and its version then
+    YEntity * m_root;
+    unsigned long m_version;
+    // the tree in scene graph order, where each node's subtree ends, and
+    // whether it runs this update
+    std::vector<YEntity *> m_all;
+    std::vector<size_t> m_end;
+    std::vector<char> m_live;
+    // nodes per batch id, and nodes without one (with their index in m_all)
+    std::vector< std::vector<YEntity *> > m_nodes;
+    std::vector< std::vector<size_t> > m_index;
+    std::vector<YEntity *> m_unbatched;
+    std::vector<size_t> m_unbatchedIndex;
+    // live nodes of a batch, when some are off
+    std::vector<YEntity *> m_run;
+    // batch ids by stage
+    std::vector<int> m_order;
+    YSceneProfiler * m_profiler;
+    // stats
+    unsigned long m_numGathers;
+    double m_gatherTime;
+    double m_updateTime;
+};
+
+
+
+
+#endif
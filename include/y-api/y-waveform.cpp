@@ -179,14 +179,16 @@ void YWaveform::update( YTimeInterval dt )
 void YWaveform::render()
 {
     // disable light
-    glDisable( GL_LIGHTING );
+    XGLState::disable( GL_LIGHTING );
+    // untextured
+    XGLState::disable( GL_TEXTURE_2D );
     // set blend function
-    glBlendFunc( GL_ONE, GL_ONE );
+    XGLState::blendFunc( GL_ONE, GL_ONE );
     // enable blend
-    glEnable( GL_BLEND );
+    XGLState::enable( GL_BLEND );
 	
     // enable
-    glEnableClientState( GL_VERTEX_ARRAY );
+    XGLState::clientArrays( XGL_VERTEX_ARRAY );
 
     // set color
     glColor4f( col.x, col.y, col.z, alpha );
@@ -194,11 +196,6 @@ void YWaveform::render()
     glVertexPointer( 2, GL_FLOAT, 0, m_vertices );
     // draw it
     glDrawArrays( GL_LINE_STRIP, 0, m_numFrames );
-    
-    // disable client state
-    glDisableClientState( GL_VERTEX_ARRAY );
-    // disable blend
-    glDisable( GL_BLEND );
 }
 
 
@@ -81,6 +81,9 @@ public:
     void update( YTimeInterval dt );
     // render
     void render();
+    // with the sample and vertex buffers
+    size_t footprint() const
+    { return sizeof(YWaveform) + heapBytes() + m_numFrames * ( sizeof(SAMPLE) + sizeof(XPoint2D) ); }
 
 protected:
     // generate vertices
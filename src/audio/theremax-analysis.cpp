@@ -0,0 +1,364 @@
+//-----------------------------------------------------------------------------
+// name: theremax-analysis.cpp
+// desc: band energies of the live output -- the audio callback queues a
+//       snapshot of each buffer, a thread of its own slides them through
+//       an fft window and publishes levels per band (Globals::audioBands)
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-analysis.h"
+#include "y-fft.h"
+#include "x-fun.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+using namespace std;
+
+// peaks fall this fast (dB per second)
+#define ANALYSIS_PEAK_DECAY 6.0f
+// quieter than this (dB) is silence
+#define ANALYSIS_FLOOR      -90.0f
+// level attack / release (seconds)
+#define ANALYSIS_ATTACK     0.01f
+#define ANALYSIS_RELEASE    0.2f
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXAudioAnalysis()
+// desc: constructor
+//-----------------------------------------------------------------------------
+THEREMAXAudioAnalysis::THEREMAXAudioAnalysis()
+{
+    m_srate = THEREMAX_SRATE;
+    m_frames = 0;
+    m_window = 0;
+    m_head = 0;
+    m_tail = 0;
+    m_numDropped = 0;
+    m_numAnalyzed = 0;
+    m_plan = NULL;
+    m_thread = NULL;
+    m_quit = false;
+    m_done = false;
+    for( int b = 0; b < THEREMAX_AUDIO_BANDS; b++ )
+    {
+        m_db[b] = ANALYSIS_FLOOR;
+        m_peak[b] = ANALYSIS_FLOOR;
+        m_levels[b] = 0;
+    }
+    for( int b = 0; b <= THEREMAX_AUDIO_BANDS; b++ )
+        m_bins[b] = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: ~THEREMAXAudioAnalysis()
+// desc: destructor
+//-----------------------------------------------------------------------------
+THEREMAXAudioAnalysis::~THEREMAXAudioAnalysis()
+{
+    stop();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: init()
+// desc: queue, window and band edges
+//-----------------------------------------------------------------------------
+bool THEREMAXAudioAnalysis::init( unsigned int srate, unsigned int frames, unsigned int window )
+{
+    // the fft plan needs a power of 2
+    YFFTPlan * plan = window >= 4 ? YFFTPlan::get( window ) : NULL;
+    if( srate == 0 || frames == 0 || !plan )
+    {
+        fprintf( stderr, "[theremax]: audio analysis: bad window %u\n", window );
+        return false;
+    }
+
+    m_srate = srate;
+    m_frames = frames;
+    m_window = window;
+    m_plan = plan;
+    // one slot stays empty to tell full from empty
+    m_ring.assign( ( THEREMAX_ANALYSIS_SNAPSHOTS + 1 ) * frames, 0 );
+    m_head = m_tail = 0;
+    m_history.assign( window, 0 );
+    m_scratch.assign( window, 0 );
+    m_taper.assign( window, 0 );
+    hanning( &m_taper[0], window );
+
+    // log spaced edges, at least a bin each, below nyquist
+    GLfloat low = THEREMAX_ANALYSIS_LOW;
+    GLfloat high = THEREMAX_ANALYSIS_HIGH;
+    if( high > srate / 2.0f ) high = srate / 2.0f;
+    int last = (int)window / 2;
+    for( int b = 0; b <= THEREMAX_AUDIO_BANDS; b++ )
+    {
+        GLfloat f = low * pow( high / low, (GLfloat)b / THEREMAX_AUDIO_BANDS );
+        int bin = (int)( f * window / srate + 0.5f );
+        if( b == 0 && bin < 1 ) bin = 1;
+        if( b > 0 && bin <= m_bins[b - 1] ) bin = m_bins[b - 1] + 1;
+        m_bins[b] = bin < last ? bin : last;
+    }
+
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: start()
+// desc: analyse on a thread of its own
+//-----------------------------------------------------------------------------
+bool THEREMAXAudioAnalysis::start()
+{
+    if( m_thread ) return true;
+    if( !m_window ) return false;
+
+    m_quit = false;
+    m_done = false;
+    m_thread = new XThread();
+    if( !m_thread->start( run, this ) )
+    {
+        SAFE_DELETE( m_thread );
+        fprintf( stderr, "[theremax]: cannot start audio analysis thread\n" );
+        return false;
+    }
+
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: stop()
+// desc: let the thread finish its pass, then join
+//-----------------------------------------------------------------------------
+void THEREMAXAudioAnalysis::stop()
+{
+    if( !m_thread ) return;
+
+    m_mutex.acquire();
+    m_quit = true;
+    m_mutex.release();
+
+    // XThread::wait cancels first; only join once the worker is through
+    bool done = false;
+    while( !done )
+    {
+        m_mutex.acquire();
+        done = m_done;
+        m_mutex.release();
+        if( !done ) usleep( 1000 );
+    }
+    m_thread->wait();
+    SAFE_DELETE( m_thread );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: run()
+// desc: analysis thread: whatever has been queued, then a short sleep
+//-----------------------------------------------------------------------------
+THREAD_RETURN THREAD_TYPE THEREMAXAudioAnalysis::run( void * data )
+{
+    THEREMAXAudioAnalysis * analysis = (THEREMAXAudioAnalysis *)data;
+
+    bool quit = false;
+    while( !quit )
+    {
+        // (a buffer is ~23ms; a millisecond late is nothing)
+        if( analysis->process() == 0 ) usleep( 1000 );
+
+        analysis->m_mutex.acquire();
+        quit = analysis->m_quit;
+        analysis->m_mutex.release();
+    }
+
+    analysis->m_mutex.acquire();
+    analysis->m_done = true;
+    analysis->m_mutex.release();
+
+    return 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: push()
+// desc: producer side; the snapshot is written before the head moves past it
+//-----------------------------------------------------------------------------
+void THEREMAXAudioAnalysis::push( const SAMPLE * buffer, unsigned int frames, unsigned int channels )
+{
+    if( !m_frames || !channels ) return;
+
+    size_t slots = THEREMAX_ANALYSIS_SNAPSHOTS + 1;
+    size_t head = m_head;
+    size_t next = ( head + 1 ) % slots;
+    if( next == m_tail )
+    {
+        m_numDropped++;
+        return;
+    }
+
+    // mono sum (a short buffer is padded with silence)
+    SAMPLE * out = &m_ring[head * m_frames];
+    if( frames > m_frames ) frames = m_frames;
+    for( unsigned int i = 0; i < frames; i++ )
+    {
+        SAMPLE sum = 0;
+        for( unsigned int j = 0; j < channels; j++ )
+            sum += buffer[i * channels + j];
+        out[i] = sum / channels;
+    }
+    if( frames < m_frames )
+        memset( out + frames, 0, sizeof(SAMPLE) * ( m_frames - frames ) );
+
+    __sync_synchronize();
+    m_head = next;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: process()
+// desc: consumer side; each snapshot is analysed once, then its slot is
+//       released; the levels go out once all are in
+//-----------------------------------------------------------------------------
+int THEREMAXAudioAnalysis::process()
+{
+    size_t slots = THEREMAX_ANALYSIS_SNAPSHOTS + 1;
+    size_t tail = m_tail;
+    size_t head = m_head;
+    __sync_synchronize();
+
+    int count = 0;
+    while( tail != head )
+    {
+        double start = XFun::now();
+        analyze( &m_ring[tail * m_frames] );
+        m_times.add( XFun::now() - start );
+        tail = ( tail + 1 ) % slots;
+        count++;
+
+        __sync_synchronize();
+        m_tail = tail;
+    }
+    if( count == 0 ) return 0;
+
+    // publish (readers may see a mix of this and the last pass; both are
+    // current to within a buffer)
+    for( int b = 0; b < THEREMAX_AUDIO_BANDS; b++ )
+        Globals::audioBands[b] = m_levels[b];
+    __sync_synchronize();
+    Globals::audioBandSequence = Globals::audioBandSequence + 1;
+
+    return count;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: analyze()
+// desc: shift a snapshot into the window, one fft, dB per band, levels
+//-----------------------------------------------------------------------------
+void THEREMAXAudioAnalysis::analyze( const SAMPLE * snapshot )
+{
+    // slide (a snapshot longer than the window keeps its end)
+    unsigned int n = m_frames < m_window ? m_frames : m_window;
+    const SAMPLE * in = snapshot + ( m_frames - n );
+    memmove( &m_history[0], &m_history[n], sizeof(SAMPLE) * ( m_window - n ) );
+    memcpy( &m_history[m_window - n], in, sizeof(SAMPLE) * n );
+
+    // windowed copy, in place to the positive half spectrum
+    SAMPLE * x = &m_scratch[0];
+    for( unsigned int i = 0; i < m_window; i++ )
+        x[i] = m_history[i] * m_taper[i];
+    m_plan->forward( x );
+
+    // (the transform scales by 1 / window; hanning halves the peak) a full scale
+    // sine reads ~0 dB
+    GLfloat norm = 4.0f;
+    // seconds this snapshot advances
+    GLfloat hop = (GLfloat)m_frames / m_srate;
+    GLfloat attack = 1 - exp( -hop / ANALYSIS_ATTACK );
+    GLfloat release = 1 - exp( -hop / ANALYSIS_RELEASE );
+
+    for( int b = 0; b < THEREMAX_AUDIO_BANDS; b++ )
+    {
+        // bin k is x[2k], x[2k+1] (x[1] is nyquist, never in a band)
+        GLfloat energy = 0;
+        for( int k = m_bins[b]; k < m_bins[b + 1]; k++ )
+            energy += x[2 * k] * x[2 * k] + x[2 * k + 1] * x[2 * k + 1];
+        energy *= norm;
+
+        GLfloat db = energy > 0 ? 10 * log10( energy ) : ANALYSIS_FLOOR;
+        if( db < ANALYSIS_FLOOR ) db = ANALYSIS_FLOOR;
+        m_db[b] = db;
+
+        // relative to a slowly falling peak (so levels use the range the
+        // music has, loud or quiet)
+        m_peak[b] -= ANALYSIS_PEAK_DECAY * hop;
+        if( db > m_peak[b] ) m_peak[b] = db;
+        GLfloat target = 0;
+        if( db > ANALYSIS_FLOOR )
+        {
+            target = 1 - ( m_peak[b] - db ) / THEREMAX_ANALYSIS_RANGE;
+            if( target < 0 ) target = 0;
+        }
+
+        m_levels[b] += ( target - m_levels[b] ) * ( target > m_levels[b] ? attack : release );
+    }
+
+    m_numAnalyzed++;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bandLow() / bandHigh()
+// desc: band b's range (Hz)
+//-----------------------------------------------------------------------------
+GLfloat THEREMAXAudioAnalysis::bandLow( int b ) const
+{
+    return m_window ? (GLfloat)m_bins[b] * m_srate / m_window : 0;
+}
+
+GLfloat THEREMAXAudioAnalysis::bandHigh( int b ) const
+{
+    return m_window ? (GLfloat)m_bins[b + 1] * m_srate / m_window : 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: report()
+// desc: print the bands and costs
+//-----------------------------------------------------------------------------
+void THEREMAXAudioAnalysis::report() const
+{
+    fprintf( stderr, "[theremax]: audio analysis: %lu snapshots analysed, %lu dropped, "
+             "window %u, mean %.3fms max %.3fms\n",
+             m_numAnalyzed, m_numDropped, m_window,
+             m_times.mean() * 1000, m_times.max() * 1000 );
+    for( int b = 0; b < THEREMAX_AUDIO_BANDS; b++ )
+        fprintf( stderr, "[theremax]:   band %d %6.0f-%6.0fHz %6.1fdB (peak %6.1fdB) level %.2f\n",
+                 b, bandLow( b ), bandHigh( b ), m_db[b], m_peak[b], m_levels[b] );
+}
@@ -0,0 +1,115 @@
+//-----------------------------------------------------------------------------
+// name: theremax-analysis.h
+// desc: band energies of the live output -- the audio callback queues a
+//       snapshot of each buffer, a thread of its own slides them through
+//       an fft window and publishes levels per band (Globals::audioBands)
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_ANALYSIS_H__
+#define __THEREMAX_ANALYSIS_H__
+
+#include "theremax-globals.h"
+#include "x-thread.h"
+#include "y-fft.h"
+#include <vector>
+
+// audio buffers queued for the analysis (more are dropped)
+#define THEREMAX_ANALYSIS_SNAPSHOTS 16
+// fft window (samples, power of 2)
+#define THEREMAX_ANALYSIS_WINDOW    2048
+// band edges (Hz, log spaced between)
+#define THEREMAX_ANALYSIS_LOW       40
+#define THEREMAX_ANALYSIS_HIGH      16000
+// dB below a band's recent peak that reads as level 0
+#define THEREMAX_ANALYSIS_RANGE     48
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class THEREMAXAudioAnalysis
+// desc: one producer (the audio callback: push()), one consumer (the
+//       analysis thread, or process() when there is none). Each snapshot
+//       is analysed once as it arrives: shifted into the window, windowed,
+//       transformed (YFFTPlan) and summed into bands; a level per band
+//       follows the band's energy in dB relative to its recent peak, in
+//       [0, 1]
+//-----------------------------------------------------------------------------
+class THEREMAXAudioAnalysis
+{
+public:
+    THEREMAXAudioAnalysis();
+    ~THEREMAXAudioAnalysis();
+
+public:
+    // buffer size in frames (any), window as THEREMAX_ANALYSIS_WINDOW
+    bool init( unsigned int srate, unsigned int frames,
+               unsigned int window = THEREMAX_ANALYSIS_WINDOW );
+    // analyse on a thread of its own (else call process())
+    bool start();
+    void stop();
+
+public:
+    // audio thread: mono copy of an interleaved buffer into the queue
+    // (never blocks; dropped if the analysis is behind)
+    void push( const SAMPLE * buffer, unsigned int frames, unsigned int channels );
+    // analyse every queued snapshot, publish the levels; returns how many
+    int process();
+
+public:
+    // band b's range (Hz)
+    GLfloat bandLow( int b ) const;
+    GLfloat bandHigh( int b ) const;
+    // last levels, [0, 1] (as published)
+    GLfloat level( int b ) const { return m_levels[b]; }
+    // snapshots analysed / dropped
+    unsigned long numAnalyzed() const { return m_numAnalyzed; }
+    unsigned long numDropped() const { return m_numDropped; }
+    // seconds per snapshot analysed
+    const THEREMAXStats & times() const { return m_times; }
+    // print the bands and costs
+    void report() const;
+
+protected:
+    // thread
+    static THREAD_RETURN THREAD_TYPE run( void * data );
+    // one snapshot through the window
+    void analyze( const SAMPLE * snapshot );
+
+protected:
+    unsigned int m_srate;
+    unsigned int m_frames;
+    unsigned int m_window;
+    // queue of snapshots, m_frames each
+    std::vector<SAMPLE> m_ring;
+    // next write (producer only writes), next read (consumer only writes)
+    volatile size_t m_head;
+    volatile size_t m_tail;
+    unsigned long m_numDropped;
+    // the shared fft plan for m_window
+    YFFTPlan * m_plan;
+    // the last m_window samples, the window, and fft scratch
+    std::vector<SAMPLE> m_history;
+    std::vector<SAMPLE> m_taper;
+    std::vector<SAMPLE> m_scratch;
+    // fft bins of band b: [m_bins[b], m_bins[b+1])
+    int m_bins[THEREMAX_AUDIO_BANDS + 1];
+    // dB per band, its decaying peak, and the level
+    GLfloat m_db[THEREMAX_AUDIO_BANDS];
+    GLfloat m_peak[THEREMAX_AUDIO_BANDS];
+    GLfloat m_levels[THEREMAX_AUDIO_BANDS];
+    unsigned long m_numAnalyzed;
+    THEREMAXStats m_times;
+    // thread, and its stop handshake (under m_mutex)
+    XThread * m_thread;
+    XMutex m_mutex;
+    bool m_quit;
+    bool m_done;
+};
+
+
+
+
+#endif
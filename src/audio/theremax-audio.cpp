@@ -7,10 +7,12 @@
 //-----------------------------------------------------------------------------
 #include "theremax-audio.h"
 #include "theremax-globals.h"
+#include "theremax-analysis.h"
 #include "x-thread.h"
 #include "y-fft.h"
 #include "Reverb.h"
 #include "RtAudio.h"
+#include "x-fun.h"
 #include <iostream>
 using namespace std;
 
@@ -21,12 +23,29 @@ int g_prog = 0;
 
 XMutex g_mutex;
 
+// last cv update heard
+unsigned long g_cvSequence = 0;
+
+
+
+
 //-----------------------------------------------------------------------------
 // name: audio_callback
 // desc: audio callback
 //-----------------------------------------------------------------------------
 static void audio_callback( SAMPLE * buffer, unsigned int numFrames, void * userData )
 {
+    // for the hud
+    double start = XFun::now();
+    double duration = (double)numFrames / THEREMAX_SRATE;
+    
+    // new reverb settings from cv: heard at the end of this buffer
+    unsigned long cvSequence = Globals::cvSequence;
+    if( cvSequence != g_cvSequence )
+    {
+        g_cvSequence = cvSequence;
+        Globals::perfCvLatency.push( ( start - Globals::cvStamp + duration ) * 1000 );
+    }
     
     // keep track of current time in samples
     g_now += numFrames;
@@ -59,6 +78,10 @@ static void audio_callback( SAMPLE * buffer, unsigned int numFrames, void * user
     memcpy( Globals::lastAudioBuffer, buffer,
            sizeof(SAMPLE)*numFrames*channels );
     
+    // queue it for band analysis (done on its own thread)
+    if( Globals::analysis )
+        Globals::analysis->push( Globals::lastAudioBuffer, numFrames, channels );
+    
     // copy to mono buffer
     for( int i = 0; i < numFrames; i++ )
     {
@@ -80,7 +103,9 @@ static void audio_callback( SAMPLE * buffer, unsigned int numFrames, void * user
         // multiply
         Globals::lastAudioBufferMono[i] *= Globals::audioBufferWindow[i];
     }
-
+    
+    // load: share of the buffer's duration spent computing it
+    Globals::perfAudioLoad.push( ( XFun::now() - start ) / duration * 100 );
 }
 
 
@@ -113,6 +138,11 @@ bool theremax_audio_init( unsigned int srate, unsigned int frameSize, unsigned c
     // compute the window
     hanning( Globals::audioBufferWindow, frameSize );
     
+    // band energies for the visuals
+    Globals::analysis = new THEREMAXAudioAnalysis();
+    if( !Globals::analysis->init( srate, frameSize ) )
+        SAFE_DELETE( Globals::analysis );
+    
     // create Reverb
     Globals::reverb = new Reverb();
     Globals::reverb->init(THEREMAX_SRATE);
@@ -187,6 +217,9 @@ bool theremax_audio_start()
         return false;
     }
     
+    // analyse what it plays
+    if( Globals::analysis ) Globals::analysis->start();
+    
     return true;
 }
 
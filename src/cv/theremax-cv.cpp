@@ -6,9 +6,12 @@
 //   date: 2013
 //-----------------------------------------------------------------------------
 #include "theremax-cv.h"
+#include "x-fun.h"
 
 // set alpha to 0.5 for low pass filter
 double alpha = 0.5f;
+// when the last camera frame was processed (for the hud)
+double g_lastFrame = 0;
 
 void _getBrightness(const Mat& frame, double& brightness)
 {
@@ -91,6 +94,15 @@ void TheremaxCV::process()
         // Now some of the upper edges
         Globals::reverb->fhslider6 = tuning;
         Globals::reverb->fhslider5 = tuning - 200;
+        
+        // tell the audio callback (for the hud) once the settings are out
+        double now = XFun::now();
+        Globals::cvStamp = now;
+        __sync_synchronize();
+        Globals::cvSequence = Globals::cvSequence + 1;
+        if( g_lastFrame > 0 && now > g_lastFrame )
+            Globals::perfCvRate.push( 1.0 / ( now - g_lastFrame ) );
+        g_lastFrame = now;
     }
 }
 
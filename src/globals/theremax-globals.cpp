@@ -17,6 +17,7 @@
 #define DEFAULT_VERSION       "2.0.0"
 
 THEREMAXSim * Globals::sim = NULL;
+THEREMAXFramePacer * Globals::pacer = NULL;
 
 GLsizei Globals::windowWidth = DEFAULT_WINDOW_WIDTH;
 GLsizei Globals::windowHeight = DEFAULT_WINDOW_HEIGHT;
@@ -30,8 +31,13 @@ SAMPLE * Globals::lastAudioBufferMono = NULL;
 SAMPLE * Globals::audioBufferWindow = NULL;
 unsigned int Globals::lastAudioBufferFrames = 0;
 unsigned int Globals::lastAudioBufferChannels = 0;
+THEREMAXAudioAnalysis * Globals::analysis = NULL;
+SAMPLE Globals::audioBands[THEREMAX_AUDIO_BANDS];
+volatile unsigned long Globals::audioBandSequence = 0;
 
 SAMPLE Globals::cvIntensity = 0.5;
+volatile double Globals::cvStamp = 0;
+volatile unsigned long Globals::cvSequence = 0;
 
 Reverb * Globals::reverb = NULL;
 
@@ -42,6 +48,17 @@ stk::BiQuad * Globals::biquad = NULL;
 
 GLboolean Globals::fullscreen = DEFAULT_FULLSCREEN;
 GLboolean Globals::blendScreen = DEFAULT_BLENDSCREEN;
+GLboolean Globals::sparkBatch = GL_TRUE;
+GLboolean Globals::sparkSort = GL_FALSE;
+GLboolean Globals::frustumCull = GL_TRUE;
+GLboolean Globals::simThread = GL_TRUE;
+GLboolean Globals::showHud = GL_FALSE;
+THEREMAXHud * Globals::hud = NULL;
+THEREMAXDynamicResolution * Globals::resolution = NULL;
+
+THEREMAXStatsFeed Globals::perfAudioLoad;
+THEREMAXStatsFeed Globals::perfCvRate;
+THEREMAXStatsFeed Globals::perfCvLatency;
 
 Vector3D Globals::blendAlpha( 1, 1, .5f );
 GLfloat Globals::blendRed = 0.0f;
@@ -52,6 +69,7 @@ Vector3D Globals::viewEyeY( 2, 0, 1.5f );
 Vector3D Globals::fov( 80, 100, .2f );
 
 GLuint Globals::textures[THEREMAX_MAX_TEXTURES];
+THEREMAXSpriteAtlas * Globals::atlas = NULL;
 
 GLfloat Globals::light0_pos[4] = { 2.0f, 1.2f, 4.0f, 1.0f };
 GLfloat Globals::light1_ambient[4] = { .2f, .2f, .2f, 1.0f };
@@ -79,3 +97,6 @@ std::string Globals::path = "";
 std::string Globals::relpath = "data/texture/";
 std::string Globals::datapath = "data/";
 std::string Globals::version = DEFAULT_VERSION;
+std::string Globals::snapshotPath = "theremax.snapshot";
+bool Globals::snapshotRestore = false;
+std::string Globals::profilePath = "theremax-profile.csv";
@@ -15,6 +15,7 @@
 #include "x-vector3d.h"
 #include "Reverb.h"
 #include "BiQuad.h"
+#include "theremax-stats.h"
 
 // c++
 #include <string>
@@ -27,9 +28,15 @@
 #define THEREMAX_FRAMESIZE    1024
 #define THEREMAX_NUMCHANNELS  2
 #define THEREMAX_MAX_TEXTURES 32
+#define THEREMAX_AUDIO_BANDS  8
 
 // forward reference
 class THEREMAXSim;
+class THEREMAXFramePacer;
+class THEREMAXSpriteAtlas;
+class THEREMAXHud;
+class THEREMAXDynamicResolution;
+class THEREMAXAudioAnalysis;
 
 //-----------------------------------------------------------------------------
 // name: class Globals
@@ -42,6 +49,8 @@ public:
     static bool dead;
     // top level root simulation
     static THEREMAXSim * sim;
+    // paces the GL thread's frames
+    static THEREMAXFramePacer * pacer;
     
     // path
     static std::string path;
@@ -51,9 +60,18 @@ public:
     static std::string datapath;
     // version
     static std::string version;
+    // where 'w' writes the simulation snapshot
+    static std::string snapshotPath;
+    // restore snapshotPath at startup
+    static bool snapshotRestore;
+    // where 'o' writes the entity type profile (.json: JSON, else CSV)
+    static std::string profilePath;
     
     // cv data
     static SAMPLE cvIntensity;
+    // when cv last set the audio parameters (seconds), and a count of sets
+    static volatile double cvStamp;
+    static volatile unsigned long cvSequence;
     
     static FAUSTFLOAT ** finputs;
     static FAUSTFLOAT ** foutputs;
@@ -69,6 +87,11 @@ public:
     static SAMPLE * audioBufferWindow;
     static unsigned int lastAudioBufferFrames;
     static unsigned int lastAudioBufferChannels;
+    // band energies of the output, levels in [0, 1] low to high (written
+    // by the analysis thread, then the sequence moves on)
+    static THEREMAXAudioAnalysis * analysis;
+    static SAMPLE audioBands[THEREMAX_AUDIO_BANDS];
+    static volatile unsigned long audioBandSequence;
     
     // width and height of the window
     static GLsizei windowWidth;
@@ -85,6 +108,25 @@ public:
     static GLfloat blendRed;
     // fill mode
     static GLenum fillmode;
+    // draw sparks in one batch (else one draw call per spark)
+    static GLboolean sparkBatch;
+    // draw batched sparks back to front (depth sorted each frame)
+    static GLboolean sparkSort;
+    // skip subtrees outside the view frustum
+    static GLboolean frustumCull;
+    // update the simulation on its own thread (windowed only)
+    static GLboolean simThread;
+    // performance overlay
+    static GLboolean showHud;
+    static THEREMAXHud * hud;
+    // scene at a scale of the window that holds the frame rate
+    static THEREMAXDynamicResolution * resolution;
+    
+    // audio / cv threads -> hud (audio load in % of the buffer duration,
+    // camera frames per second, cv -> audio latency in ms)
+    static THEREMAXStatsFeed perfAudioLoad;
+    static THEREMAXStatsFeed perfCvRate;
+    static THEREMAXStatsFeed perfCvLatency;
     
     static GLboolean ChangeColor;
     
@@ -97,6 +139,8 @@ public:
     
     // textures
     static GLuint textures[];
+    // bokeh sprites, all in one texture
+    static THEREMAXSpriteAtlas * atlas;
     
     // light 0 position
     static GLfloat light0_pos[4];
@@ -0,0 +1,182 @@
+//-----------------------------------------------------------------------------
+// name: theremax-stats.cpp
+// desc: rolling window of timing samples with min/mean/max/percentiles
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-stats.h"
+#include <algorithm>
+#include <math.h>
+using namespace std;
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXStats()
+// desc: constructor
+//-----------------------------------------------------------------------------
+THEREMAXStats::THEREMAXStats( size_t capacity )
+{
+    m_samples.resize( capacity > 0 ? capacity : 1 );
+    m_scratch.reserve( m_samples.size() );
+    clear();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: add()
+// desc: add a sample
+//-----------------------------------------------------------------------------
+void THEREMAXStats::add( double value )
+{
+    m_samples[m_next] = value;
+    m_next = ( m_next + 1 ) % m_samples.size();
+    if( m_count < m_samples.size() ) m_count++;
+    m_total++;
+    m_last = value;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: clear()
+// desc: forget everything
+//-----------------------------------------------------------------------------
+void THEREMAXStats::clear()
+{
+    m_next = 0;
+    m_count = 0;
+    m_total = 0;
+    m_last = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: min() / max() / mean()
+// desc: over the window (0 if empty)
+//-----------------------------------------------------------------------------
+double THEREMAXStats::min() const
+{
+    if( m_count == 0 ) return 0;
+    return *std::min_element( m_samples.begin(), m_samples.begin() + m_count );
+}
+
+double THEREMAXStats::max() const
+{
+    if( m_count == 0 ) return 0;
+    return *std::max_element( m_samples.begin(), m_samples.begin() + m_count );
+}
+
+double THEREMAXStats::mean() const
+{
+    if( m_count == 0 ) return 0;
+    double sum = 0;
+    for( size_t i = 0; i < m_count; i++ ) sum += m_samples[i];
+    return sum / m_count;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: percentile()
+// desc: nearest rank; partial sort of a copy, so the window is untouched
+//-----------------------------------------------------------------------------
+double THEREMAXStats::percentile( double p ) const
+{
+    if( m_count == 0 ) return 0;
+    if( p < 0 ) p = 0;
+    if( p > 100 ) p = 100;
+
+    size_t rank = (size_t)ceil( p / 100.0 * m_count );
+    if( rank > 0 ) rank--;
+
+    m_scratch.assign( m_samples.begin(), m_samples.begin() + m_count );
+    std::nth_element( m_scratch.begin(), m_scratch.begin() + rank, m_scratch.end() );
+    return m_scratch[rank];
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: at()
+// desc: i-th sample in the window, oldest first (0 if out of range)
+//-----------------------------------------------------------------------------
+double THEREMAXStats::at( size_t i ) const
+{
+    if( i >= m_count ) return 0;
+    // before wrapping, the oldest is at 0; after, at m_next
+    size_t first = m_count < m_samples.size() ? 0 : m_next;
+    return m_samples[( first + i ) % m_samples.size()];
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXStatsFeed()
+// desc: constructor (one slot stays empty to tell full from empty)
+//-----------------------------------------------------------------------------
+THEREMAXStatsFeed::THEREMAXStatsFeed( size_t capacity )
+{
+    m_ring.resize( capacity > 0 ? capacity + 1 : 2 );
+    m_head = 0;
+    m_tail = 0;
+    m_numDropped = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: push()
+// desc: producer side; the sample is written before the head moves past it
+//-----------------------------------------------------------------------------
+void THEREMAXStatsFeed::push( double value )
+{
+    size_t head = m_head;
+    size_t next = ( head + 1 ) % m_ring.size();
+    if( next == m_tail )
+    {
+        m_numDropped++;
+        return;
+    }
+
+    m_ring[head] = value;
+    __sync_synchronize();
+    m_head = next;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: drain()
+// desc: consumer side; slots are read before the tail releases them
+//-----------------------------------------------------------------------------
+size_t THEREMAXStatsFeed::drain( THEREMAXStats & stats )
+{
+    size_t tail = m_tail;
+    size_t head = m_head;
+    __sync_synchronize();
+
+    size_t count = 0;
+    while( tail != head )
+    {
+        stats.add( m_ring[tail] );
+        tail = ( tail + 1 ) % m_ring.size();
+        count++;
+    }
+
+    __sync_synchronize();
+    m_tail = tail;
+    return count;
+}
@@ -0,0 +1,91 @@
+//-----------------------------------------------------------------------------
+// name: theremax-stats.h
+// desc: rolling window of timing samples with min/mean/max/percentiles
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_STATS_H__
+#define __THEREMAX_STATS_H__
+
+#include <vector>
+#include <stddef.h>
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class THEREMAXStats
+// desc: keeps the last `capacity` samples; queries are over that window
+//-----------------------------------------------------------------------------
+class THEREMAXStats
+{
+public:
+    THEREMAXStats( size_t capacity = 1024 );
+
+public:
+    // add a sample (overwrites the oldest when full)
+    void add( double value );
+    // forget everything
+    void clear();
+
+public:
+    // samples in the window
+    size_t count() const { return m_count; }
+    // samples ever added
+    unsigned long total() const { return m_total; }
+    // most recent sample
+    double last() const { return m_last; }
+    // over the window
+    double min() const;
+    double max() const;
+    double mean() const;
+    // nearest-rank percentile, p in [0, 100]
+    double percentile( double p ) const;
+    // i-th sample in the window, oldest first
+    double at( size_t i ) const;
+
+protected:
+    std::vector<double> m_samples;
+    size_t m_next;
+    size_t m_count;
+    unsigned long m_total;
+    double m_last;
+    // sort space for percentile()
+    mutable std::vector<double> m_scratch;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class THEREMAXStatsFeed
+// desc: hands samples from one real-time thread (audio, cv) to the GL
+//       thread without locks or allocation; one producer, one consumer
+//-----------------------------------------------------------------------------
+class THEREMAXStatsFeed
+{
+public:
+    THEREMAXStatsFeed( size_t capacity = 256 );
+
+public:
+    // producer: queue a sample (dropped if the consumer is behind)
+    void push( double value );
+    // consumer: add everything queued to stats; returns how many
+    size_t drain( THEREMAXStats & stats );
+    // samples pushed while full
+    unsigned long numDropped() const { return m_numDropped; }
+
+protected:
+    std::vector<double> m_ring;
+    // next write (producer only writes)
+    volatile size_t m_head;
+    // next read (consumer only writes)
+    volatile size_t m_tail;
+    unsigned long m_numDropped;
+};
+
+
+
+
+#endif
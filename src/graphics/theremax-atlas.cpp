@@ -0,0 +1,451 @@
+//-----------------------------------------------------------------------------
+// name: theremax-atlas.cpp
+// desc: bokeh sprite atlas -- images decoded on a worker thread, packed
+//       into one mipmapped texture, uploaded once on the GL thread
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-atlas.h"
+#include "x-loadlum.h"
+#include "x-loadrgb.h"
+#include "x-fun.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <algorithm>
+using namespace std;
+
+
+
+
+// atlas size in texels
+#define ATLAS_WIDTH  ( THEREMAX_ATLAS_CELL * THEREMAX_ATLAS_COLUMNS )
+#define ATLAS_HEIGHT ( THEREMAX_ATLAS_CELL * THEREMAX_ATLAS_ROWS )
+// SGI image file tag
+#define ATLAS_SGI_MAGIC 474
+// largest image we'll decode
+#define ATLAS_MAX_IMAGE 4096
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: atlas_probe()
+// desc: is path a readable SGI image; its channel count (the loaders exit
+//       or crash on missing or foreign files, so look first)
+//-----------------------------------------------------------------------------
+static bool atlas_probe( const string & path, int & channels )
+{
+    FILE * file = fopen( path.c_str(), "rb" );
+    if( !file ) return false;
+    unsigned char h[12];
+    bool ok = fread( h, 1, sizeof(h), file ) == sizeof(h);
+    fclose( file );
+    if( !ok ) return false;
+
+    // big endian shorts: magic, storage/bpc, dimension, x, y, z
+    int magic = ( h[0] << 8 ) | h[1];
+    int bpc = h[3];
+    int x = ( h[6] << 8 ) | h[7], y = ( h[8] << 8 ) | h[9], z = ( h[10] << 8 ) | h[11];
+    if( magic != ATLAS_SGI_MAGIC || bpc != 1 ) return false;
+    if( x <= 0 || y <= 0 || x > ATLAS_MAX_IMAGE || y > ATLAS_MAX_IMAGE ) return false;
+    if( z < 1 || z > 4 ) return false;
+
+    channels = z;
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: atlas_clamp()
+// desc: v limited to [low, high]
+//-----------------------------------------------------------------------------
+static inline float atlas_clamp( float v, float low, float high )
+{
+    return v < low ? low : ( v > high ? high : v );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: atlas_sample()
+// desc: bilinear sample of an RGBA image at texel coordinates (x, y)
+//-----------------------------------------------------------------------------
+static void atlas_sample( const unsigned char * image, int w, int h,
+                          float x, float y, unsigned char * out )
+{
+    x = atlas_clamp( x, 0, (float)( w - 1 ) );
+    y = atlas_clamp( y, 0, (float)( h - 1 ) );
+    int x0 = (int)x, y0 = (int)y;
+    int x1 = x0 + 1 < w ? x0 + 1 : x0, y1 = y0 + 1 < h ? y0 + 1 : y0;
+    float fx = x - x0, fy = y - y0;
+
+    const unsigned char * a = image + ( y0 * w + x0 ) * 4;
+    const unsigned char * b = image + ( y0 * w + x1 ) * 4;
+    const unsigned char * c = image + ( y1 * w + x0 ) * 4;
+    const unsigned char * d = image + ( y1 * w + x1 ) * 4;
+    for( int i = 0; i < 4; i++ )
+    {
+        float top = a[i] + ( b[i] - a[i] ) * fx;
+        float bottom = c[i] + ( d[i] - c[i] ) * fx;
+        out[i] = (unsigned char)( top + ( bottom - top ) * fy + 0.5f );
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXSpriteAtlas()
+// desc: constructor
+//-----------------------------------------------------------------------------
+THEREMAXSpriteAtlas::THEREMAXSpriteAtlas()
+{
+    m_thread = NULL;
+    m_decoded = false;
+    m_texture = 0;
+    m_numLoaded = 0;
+    m_decodeTime = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: ~THEREMAXSpriteAtlas()
+// desc: destructor (GL objects must be released with cleanup())
+//-----------------------------------------------------------------------------
+THEREMAXSpriteAtlas::~THEREMAXSpriteAtlas()
+{
+    finish();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: start()
+// desc: decode in the background
+//-----------------------------------------------------------------------------
+bool THEREMAXSpriteAtlas::start( const string & dir )
+{
+    if( m_thread ) return true;
+
+    m_dir = dir;
+    m_thread = new XThread();
+    if( !m_thread->start( decode, this ) )
+    {
+        // no thread: do it now
+        SAFE_DELETE( m_thread );
+        decodeAll();
+    }
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: finish()
+// desc: block until decoding is done
+//-----------------------------------------------------------------------------
+void THEREMAXSpriteAtlas::finish()
+{
+    if( !m_thread ) return;
+
+    // XThread::wait cancels first; only join once the worker is through
+    bool done = false;
+    while( !done )
+    {
+        m_mutex.acquire();
+        done = m_decoded;
+        m_mutex.release();
+        if( !done ) usleep( 1000 );
+    }
+    m_thread->wait();
+    SAFE_DELETE( m_thread );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: upload()
+// desc: once decoded, one texture with the whole mip chain
+//-----------------------------------------------------------------------------
+bool THEREMAXSpriteAtlas::upload()
+{
+    // done already
+    if( m_texture ) return true;
+
+    m_mutex.acquire();
+    bool decoded = m_decoded;
+    m_mutex.release();
+    if( !decoded ) return false;
+    finish();
+
+    glGenTextures( 1, &m_texture );
+    XGLState::bindTexture( m_texture );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    for( size_t level = 0; level < m_levels.size(); level++ )
+    {
+        glTexImage2D( GL_TEXTURE_2D, (GLint)level, GL_RGBA,
+                      ATLAS_WIDTH >> level, ATLAS_HEIGHT >> level, 0,
+                      GL_RGBA, GL_UNSIGNED_BYTE, &m_levels[level][0] );
+    }
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)m_levels.size() - 1 );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+
+    fprintf( stderr, "[theremax]: sprite atlas %dx%d, %d levels, %d of %d sprites from files (decoded in %.1fms)\n",
+             ATLAS_WIDTH, ATLAS_HEIGHT, (int)m_levels.size(), m_numLoaded,
+             THEREMAX_ATLAS_SLOTS, m_decodeTime * 1000 );
+
+    // the GL has its copy
+    vector< vector<unsigned char> >().swap( m_levels );
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: cleanup()
+// desc: release GL objects
+//-----------------------------------------------------------------------------
+void THEREMAXSpriteAtlas::cleanup()
+{
+    if( m_texture )
+    {
+        // (deleting the bound texture unbinds it behind the state cache)
+        XGLState::bindTexture( 0 );
+        glDeleteTextures( 1, &m_texture );
+    }
+    m_texture = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: rect()
+// desc: texture coordinates of a cell, inset half a texel so bilinear
+//       filtering stays inside it
+//-----------------------------------------------------------------------------
+void THEREMAXSpriteAtlas::rect( GLuint index, GLfloat * uv )
+{
+    int slot = (int)( index % THEREMAX_ATLAS_SLOTS );
+    int col = slot % THEREMAX_ATLAS_COLUMNS, row = slot / THEREMAX_ATLAS_COLUMNS;
+    GLfloat cw = 1.0f / THEREMAX_ATLAS_COLUMNS, ch = 1.0f / THEREMAX_ATLAS_ROWS;
+    GLfloat iu = 0.5f / ATLAS_WIDTH, iv = 0.5f / ATLAS_HEIGHT;
+    uv[0] = col * cw + iu;
+    uv[1] = row * ch + iv;
+    uv[2] = ( col + 1 ) * cw - iu;
+    uv[3] = ( row + 1 ) * ch - iv;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: decode()
+// desc: worker thread entry
+//-----------------------------------------------------------------------------
+THREAD_RETURN THREAD_TYPE THEREMAXSpriteAtlas::decode( void * data )
+{
+    ((THEREMAXSpriteAtlas *)data)->decodeAll();
+    return 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: decodeAll()
+// desc: fill every cell, then the mip chain
+//-----------------------------------------------------------------------------
+void THEREMAXSpriteAtlas::decodeAll()
+{
+    double start = XFun::now();
+
+    m_levels.resize( 1 );
+    m_levels[0].assign( (size_t)ATLAS_WIDTH * ATLAS_HEIGHT * 4, 0 );
+    m_numLoaded = 0;
+
+    for( int slot = 0; slot < THEREMAX_ATLAS_SLOTS; slot++ )
+    {
+        char name[64];
+        snprintf( name, sizeof(name), "bokeh-%d", slot );
+        if( load( slot, m_dir + name ) ) m_numLoaded++;
+        else generate( slot );
+    }
+
+    buildMipmaps();
+    m_decodeTime = XFun::now() - start;
+
+    m_mutex.acquire();
+    m_decoded = true;
+    m_mutex.release();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: cell()
+// desc: level 0 texel (x, y) of a slot's cell
+//-----------------------------------------------------------------------------
+unsigned char * THEREMAXSpriteAtlas::cell( int slot, int x, int y )
+{
+    int col = slot % THEREMAX_ATLAS_COLUMNS, row = slot / THEREMAX_ATLAS_COLUMNS;
+    size_t tx = (size_t)col * THEREMAX_ATLAS_CELL + x;
+    size_t ty = (size_t)row * THEREMAX_ATLAS_CELL + y;
+    return &m_levels[0][( ty * ATLAS_WIDTH + tx ) * 4];
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: load()
+// desc: base.bw (white, luminance as alpha) or base.rgb into a cell
+//-----------------------------------------------------------------------------
+bool THEREMAXSpriteAtlas::load( int slot, const string & base )
+{
+    vector<unsigned char> image;
+    int w = 0, h = 0, channels = 0;
+
+    string bw = base + ".bw", rgb = base + ".rgb";
+    if( atlas_probe( bw, channels ) && channels == 1 )
+    {
+        int comps = 0;
+        unsigned char * lum = loadLuminance( bw.c_str(), &w, &h, &comps );
+        if( !lum ) return false;
+        image.resize( (size_t)w * h * 4 );
+        for( size_t i = 0; i < (size_t)w * h; i++ )
+        {
+            image[i * 4 + 0] = image[i * 4 + 1] = image[i * 4 + 2] = 255;
+            image[i * 4 + 3] = lum[i];
+        }
+        free( lum );
+    }
+    else if( atlas_probe( rgb, channels ) )
+    {
+        GeImageData data;
+        if( !ge_read_image( rgb.c_str(), &data ) ) return false;
+        w = data.width; h = data.height;
+        image.resize( (size_t)w * h * 4 );
+        memcpy( &image[0], data.bits, image.size() );
+        free( data.bits );
+        // no alpha channel: black is transparent
+        if( channels < 4 )
+        {
+            for( size_t i = 0; i < (size_t)w * h; i++ )
+            {
+                unsigned char * p = &image[i * 4];
+                p[3] = max( p[0], max( p[1], p[2] ) );
+            }
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    // resample into the cell (SGI rows run bottom up, as GL's)
+    float sx = (float)w / THEREMAX_ATLAS_CELL, sy = (float)h / THEREMAX_ATLAS_CELL;
+    for( int y = 0; y < THEREMAX_ATLAS_CELL; y++ )
+        for( int x = 0; x < THEREMAX_ATLAS_CELL; x++ )
+            atlas_sample( &image[0], w, h, ( x + 0.5f ) * sx - 0.5f,
+                          ( y + 0.5f ) * sy - 0.5f, cell( slot, x, y ) );
+
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: generate()
+// desc: a bokeh disc -- polygonal aperture (round for slot 0), soft edge,
+//       brighter rim; white, shape in alpha, zero at the cell border
+//-----------------------------------------------------------------------------
+void THEREMAXSpriteAtlas::generate( int slot )
+{
+    int blades = slot == 0 ? 0 : 4 + slot;
+    float softness = 0.04f + 0.03f * ( slot % 3 );
+    float rim = 0.25f * ( slot % 2 );
+    float rotation = 0.3f * slot;
+    float half = THEREMAX_ATLAS_CELL / 2.0f;
+
+    for( int y = 0; y < THEREMAX_ATLAS_CELL; y++ )
+    {
+        for( int x = 0; x < THEREMAX_ATLAS_CELL; x++ )
+        {
+            float dx = ( x + 0.5f - half ) / half, dy = ( y + 0.5f - half ) / half;
+            float r = sqrtf( dx * dx + dy * dy );
+
+            // distance to a regular polygon's edge, relative to its apothem
+            if( blades > 0 )
+            {
+                float sector = 2 * (float)M_PI / blades;
+                float a = atan2f( dy, dx ) + rotation;
+                a = fmodf( a, sector );
+                if( a < 0 ) a += sector;
+                r *= cosf( a - sector / 2 ) / cosf( sector / 2 );
+            }
+
+            // 0.9: leave the border clear for filtering
+            float edge = 0.9f;
+            float t = ( edge - r ) / softness;
+            float a = t <= 0 ? 0 : ( t >= 1 ? 1 : t * t * ( 3 - 2 * t ) );
+            // body a little dimmer than the rim
+            float body = ( 1 - rim ) + rim * ( r / edge ) * ( r / edge );
+
+            unsigned char * p = cell( slot, x, y );
+            p[0] = p[1] = p[2] = 255;
+            p[3] = (unsigned char)( 255 * a * body + 0.5f );
+        }
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: buildMipmaps()
+// desc: 2x2 box filter down to one texel per cell (cells are aligned at
+//       every level down to there, so sprites never bleed into each other)
+//-----------------------------------------------------------------------------
+void THEREMAXSpriteAtlas::buildMipmaps()
+{
+    m_levels.resize( 1 );
+    int w = ATLAS_WIDTH, h = ATLAS_HEIGHT;
+    for( int c = THEREMAX_ATLAS_CELL; c > 1; c /= 2 )
+    {
+        int nw = w / 2, nh = h / 2;
+        m_levels.push_back( vector<unsigned char>( (size_t)nw * nh * 4 ) );
+        const vector<unsigned char> & src = m_levels[m_levels.size() - 2];
+        vector<unsigned char> & dst = m_levels.back();
+        for( int y = 0; y < nh; y++ )
+        {
+            for( int x = 0; x < nw; x++ )
+            {
+                const unsigned char * a = &src[( ( 2 * y ) * w + 2 * x ) * 4];
+                const unsigned char * b = a + w * 4;
+                for( int i = 0; i < 4; i++ )
+                    dst[( y * nw + x ) * 4 + i] =
+                        (unsigned char)( ( a[i] + a[i + 4] + b[i] + b[i + 4] + 2 ) / 4 );
+            }
+        }
+        w = nw; h = nh;
+    }
+}
@@ -0,0 +1,83 @@
+//-----------------------------------------------------------------------------
+// name: theremax-atlas.h
+// desc: bokeh sprite atlas -- images decoded on a worker thread, packed
+//       into one mipmapped texture, uploaded once on the GL thread
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_ATLAS_H__
+#define __THEREMAX_ATLAS_H__
+
+#include "x-gfx.h"
+#include "x-thread.h"
+#include <string>
+#include <vector>
+
+// atlas layout: a grid of square cells, one sprite each
+#define THEREMAX_ATLAS_CELL    128
+#define THEREMAX_ATLAS_COLUMNS 4
+#define THEREMAX_ATLAS_ROWS    2
+#define THEREMAX_ATLAS_SLOTS   ( THEREMAX_ATLAS_COLUMNS * THEREMAX_ATLAS_ROWS )
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class THEREMAXSpriteAtlas
+// desc: slot i comes from <dir>bokeh-<i>.bw (luminance as alpha) or
+//       <dir>bokeh-<i>.rgb, else a generated bokeh disc; cells are powers
+//       of two on a grid, so mip levels never mix neighbouring sprites
+//-----------------------------------------------------------------------------
+class THEREMAXSpriteAtlas
+{
+public:
+    THEREMAXSpriteAtlas();
+    ~THEREMAXSpriteAtlas();
+
+public:
+    // start decoding in the background (returns right away)
+    bool start( const std::string & dir );
+    // block until decoding is done (for deterministic offscreen runs)
+    void finish();
+    // upload once decoded (GL thread, cheap until then and after)
+    bool upload();
+    // release GL objects
+    void cleanup();
+
+public:
+    // GL texture (0 until uploaded)
+    GLuint texture() const { return m_texture; }
+    // texture coordinates of a spark texture index: u0, v0, u1, v1 (fixed
+    // layout, usable from any thread before the upload)
+    static void rect( GLuint index, GLfloat * uv );
+    // sprites read from files (rest generated)
+    int numLoaded() const { return m_numLoaded; }
+
+protected:
+    // worker
+    static THREAD_RETURN THREAD_TYPE decode( void * data );
+    void decodeAll();
+    bool load( int slot, const std::string & base );
+    void generate( int slot );
+    void buildMipmaps();
+    // cell (x, y) of a slot, in level 0 texels
+    unsigned char * cell( int slot, int x, int y );
+
+protected:
+    std::string m_dir;
+    XThread * m_thread;
+    // decoded levels, level 0 first (freed after upload)
+    std::vector< std::vector<unsigned char> > m_levels;
+    // decoding finished (under m_mutex)
+    bool m_decoded;
+    XMutex m_mutex;
+    GLuint m_texture;
+    int m_numLoaded;
+    double m_decodeTime;
+};
+
+
+
+
+#endif
@@ -0,0 +1,256 @@
+//-----------------------------------------------------------------------------
+// name: theremax-broadphase.cpp
+// desc: flock vs flock interaction (sweep and prune over bounding spheres)
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-broadphase.h"
+#include <algorithm>
+using namespace std;
+
+
+
+
+// candidates scanned per flock, as a multiple of maxNeighbors
+#define SWEEP_WINDOW 8
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: struct SweepLess
+// desc: orders flock indices by interval start
+//-----------------------------------------------------------------------------
+struct SweepLess
+{
+    SweepLess( const vector<GLfloat> & m ) : mins( m ) { }
+    bool operator ()( unsigned int a, unsigned int b ) const
+    { return mins[a] < mins[b]; }
+    const vector<GLfloat> & mins;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXFlockBroadphase()
+// desc: constructor
+//-----------------------------------------------------------------------------
+THEREMAXFlockBroadphase::THEREMAXFlockBroadphase()
+{
+    avoidDistance = 0.5f;
+    avoidWeight = 1.0f;
+    attractRange = 2.0f;
+    attractWeight = 0.01f;
+    maxNeighbors = 4;
+    m_axis = 0;
+    m_orderStale = false;
+    m_numCandidates = 0;
+    m_numPairs = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: add()
+// desc: add a flock
+//-----------------------------------------------------------------------------
+void THEREMAXFlockBroadphase::add( THEREMAXFlock * flock )
+{
+    flock->broadphaseSlot = (unsigned int)m_flocks.size();
+    m_flocks.push_back( flock );
+    m_order.push_back( (unsigned int)m_order.size() );
+    m_min.push_back( 0 );
+    m_neighbors.push_back( 0 );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: remove()
+// desc: remove a flock; the last one takes its slot
+//-----------------------------------------------------------------------------
+void THEREMAXFlockBroadphase::remove( THEREMAXFlock * flock )
+{
+    // check
+    size_t i = flock->broadphaseSlot;
+    if( i >= m_flocks.size() || m_flocks[i] != flock ) return;
+
+    THEREMAXFlock * last = m_flocks.back();
+    m_flocks[i] = last;
+    last->broadphaseSlot = (unsigned int)i;
+    m_flocks.pop_back();
+    m_min.pop_back();
+    m_neighbors.pop_back();
+    // the order gets rebuilt on the next sort
+    m_order.pop_back();
+    m_orderStale = true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: clear()
+// desc: remove all flocks
+//-----------------------------------------------------------------------------
+void THEREMAXFlockBroadphase::clear()
+{
+    m_flocks.clear();
+    m_order.clear();
+    m_min.clear();
+    m_neighbors.clear();
+    m_orderStale = false;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: update()
+// desc: refit, sort, sweep -- O(F log F) for the sort, O(F) for the sweep
+//-----------------------------------------------------------------------------
+void THEREMAXFlockBroadphase::update()
+{
+    m_numCandidates = 0;
+    m_numPairs = 0;
+
+    // refit every frame, clearing last frame's steering
+    for( size_t i = 0; i < m_flocks.size(); i++ )
+    {
+        THEREMAXFlock * flock = m_flocks[i];
+        flock->refitBounds();
+        flock->interFlock.setAll( 0 );
+        const vector<YEntity *> & boids = flock->boids();
+        for( size_t b = 0; b < boids.size(); b++ )
+            ((THEREMAXBoid *)boids[b])->interFlock.setAll( 0 );
+        m_neighbors[i] = 0;
+    }
+
+    // order along the sweep axis
+    sort();
+
+    // sweep: an interval only needs testing against the ones that start
+    // before it ends
+    GLfloat margin = attractRange / 2;
+    for( size_t i = 0; i < m_order.size(); i++ )
+    {
+        unsigned int ia = m_order[i];
+        THEREMAXFlock * a = m_flocks[ia];
+        GLfloat maxA = a->boundCenter[m_axis] + a->boundRadius + margin;
+
+        // scan window keeps this linear when everything overlaps
+        size_t end = std::min( m_order.size(), i + 1 + maxNeighbors * SWEEP_WINDOW );
+        for( size_t j = i + 1; j < end && m_min[m_order[j]] <= maxA; j++ )
+        {
+            // budget
+            if( m_neighbors[ia] >= maxNeighbors ) break;
+            unsigned int ib = m_order[j];
+            if( m_neighbors[ib] >= maxNeighbors ) continue;
+
+            // sphere test
+            THEREMAXFlock * b = m_flocks[ib];
+            m_numCandidates++;
+            GLfloat reach = a->boundRadius + b->boundRadius + attractRange;
+            if( (b->boundCenter - a->boundCenter).magnitudeSqr() > reach * reach )
+                continue;
+
+            // nearby pair
+            interact( a, b );
+            m_neighbors[ia]++;
+            m_neighbors[ib]++;
+            m_numPairs++;
+        }
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: sort()
+// desc: pick the axis of greatest spread and sort interval starts on it
+//-----------------------------------------------------------------------------
+void THEREMAXFlockBroadphase::sort()
+{
+    size_t count = m_flocks.size();
+    if( count == 0 ) return;
+
+    // after a remove
+    if( m_orderStale )
+    {
+        for( size_t i = 0; i < count; i++ )
+            m_order[i] = (unsigned int)i;
+        m_orderStale = false;
+    }
+
+    // variance of the centers per axis
+    Vector3D mean, var;
+    for( size_t i = 0; i < count; i++ )
+        mean += m_flocks[i]->boundCenter;
+    mean *= 1.0f / count;
+    for( size_t i = 0; i < count; i++ )
+    {
+        Vector3D d = m_flocks[i]->boundCenter - mean;
+        var += Vector3D( d.x * d.x, d.y * d.y, d.z * d.z );
+    }
+    m_axis = var.x >= var.y ? ( var.x >= var.z ? 0 : 2 ) : ( var.y >= var.z ? 1 : 2 );
+
+    // interval starts (half the attract range on each side)
+    GLfloat margin = attractRange / 2;
+    for( size_t i = 0; i < count; i++ )
+        m_min[i] = m_flocks[i]->boundCenter[m_axis] - m_flocks[i]->boundRadius - margin;
+
+    // order is mostly coherent from frame to frame
+    std::sort( m_order.begin(), m_order.end(), SweepLess( m_min ) );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: interact()
+// desc: attraction at flock level, avoidance at boid level when overlapping
+//-----------------------------------------------------------------------------
+void THEREMAXFlockBroadphase::interact( THEREMAXFlock * a, THEREMAXFlock * b )
+{
+    Vector3D axis = b->boundCenter - a->boundCenter;
+    GLfloat dist = axis.magnitude();
+    GLfloat gap = dist - a->boundRadius - b->boundRadius;
+
+    // apart but within range: drift together, stronger when farther
+    if( gap > 0 )
+    {
+        if( dist == 0 ) return;
+        Vector3D pull = axis * ( attractWeight * ( gap / attractRange ) / dist );
+        a->interFlock += pull;
+        b->interFlock -= pull;
+        return;
+    }
+
+    // overlapping: boids too close to boids of the other flock push apart
+    const vector<YEntity *> & boidsA = a->boids();
+    const vector<YEntity *> & boidsB = b->boids();
+    Vector3D offset = b->loc - a->loc;
+    GLfloat avoidSqr = avoidDistance * avoidDistance;
+
+    for( size_t i = 0; i < boidsA.size(); i++ )
+    {
+        THEREMAXBoid * boidA = (THEREMAXBoid *)boidsA[i];
+        for( size_t j = 0; j < boidsB.size(); j++ )
+        {
+            THEREMAXBoid * boidB = (THEREMAXBoid *)boidsB[j];
+            // B relative to A, in world space
+            Vector3D diff = boidB->loc + offset - boidA->loc;
+            if( diff.magnitudeSqr() < avoidSqr )
+            {
+                diff *= avoidWeight;
+                boidA->interFlock -= diff;
+                boidB->interFlock += diff;
+            }
+        }
+    }
+}
@@ -0,0 +1,87 @@
+//-----------------------------------------------------------------------------
+// name: theremax-broadphase.h
+// desc: flock vs flock interaction (sweep and prune over bounding spheres)
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_BROADPHASE_H__
+#define __THEREMAX_BROADPHASE_H__
+
+#include "theremax-flocking.h"
+#include <vector>
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class THEREMAXFlockBroadphase
+// desc: finds nearby flock pairs each frame and lets only those interact;
+//       flocks with overlapping spheres push their boids apart, flocks
+//       within attractRange of each other drift together
+//-----------------------------------------------------------------------------
+class THEREMAXFlockBroadphase
+{
+public:
+    THEREMAXFlockBroadphase();
+
+public:
+    // add a flock (not memory-managed)
+    void add( THEREMAXFlock * flock );
+    // remove a flock (constant time; the last flock takes its place)
+    void remove( THEREMAXFlock * flock );
+    // remove all flocks
+    void clear();
+    // number of flocks
+    size_t size() const { return m_flocks.size(); }
+    // the flocks
+    const std::vector<THEREMAXFlock *> & flocks() const { return m_flocks; }
+
+public:
+    // refit bounds, find pairs, write interaction steering
+    void update();
+
+public:
+    // pairs tested (after the sweep) and pairs interacting, last update
+    unsigned long numCandidates() const { return m_numCandidates; }
+    unsigned long numPairs() const { return m_numPairs; }
+
+public:
+    // boids of overlapping flocks closer than this push apart
+    GLfloat avoidDistance;
+    GLfloat avoidWeight;
+    // flocks whose spheres are less than this apart attract
+    GLfloat attractRange;
+    GLfloat attractWeight;
+    // max flocks any one flock interacts with per update (bounds cost when
+    // everything converges on the same spot)
+    unsigned int maxNeighbors;
+
+protected:
+    // sort along the axis of greatest spread
+    void sort();
+    // boid/flock level interaction between a nearby pair
+    void interact( THEREMAXFlock * a, THEREMAXFlock * b );
+
+protected:
+    // the flocks
+    std::vector<THEREMAXFlock *> m_flocks;
+    // indices into m_flocks in sweep order
+    std::vector<unsigned int> m_order;
+    // interval start along the sweep axis (parallel to m_flocks)
+    std::vector<GLfloat> m_min;
+    // interactions so far this update (parallel to m_flocks)
+    std::vector<unsigned int> m_neighbors;
+    // sweep axis (0, 1, 2)
+    int m_axis;
+    // m_order lost an entry (rebuilt by the next sort)
+    bool m_orderStale;
+    // stats
+    unsigned long m_numCandidates;
+    unsigned long m_numPairs;
+};
+
+
+
+
+#endif
@@ -0,0 +1,402 @@
+//-----------------------------------------------------------------------------
+// name: theremax-emitter.cpp
+// desc: particles emitted with the music -- spawn rate, initial velocity
+//       and colour follow the band levels of the output, and emission is
+//       held to a share of the frame
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-emitter.h"
+#include "theremax-atlas.h"
+#include "x-fun.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <math.h>
+using namespace std;
+
+// fewest live particles the budget allows (so the cost is still measured)
+#define EMITTER_MIN_CAP    64
+// live particles before a cost sample counts
+#define EMITTER_MIN_SAMPLE 32
+// weight of a new cost sample
+#define EMITTER_SMOOTHING  0.1
+// alpha falls to ~5% over a lifetime
+#define EMITTER_FADE       3.0f
+
+// corners of a quad as x, y offsets, counterclockwise (-1 takes u0 / v0
+// of the sprite, 1 takes u1 / v1)
+static const int g_corner[] = { -1, -1, 1, -1, 1, 1, -1, 1 };
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: emitter_byte()
+// desc: [0,1] -> [0,255]
+//-----------------------------------------------------------------------------
+static inline GLubyte emitter_byte( GLfloat v )
+{
+    if( v <= 0 ) return 0;
+    if( v >= 1 ) return 255;
+    return (GLubyte)( v * 255.0f + 0.5f );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: emitter_hue()
+// desc: fully saturated colour of hue h in [0, 1)
+//-----------------------------------------------------------------------------
+static Vector3D emitter_hue( GLfloat h )
+{
+    GLfloat s = h * 6;
+    int i = (int)s;
+    GLfloat f = s - i;
+    switch( i % 6 )
+    {
+        case 0: return Vector3D( 1, f, 0 );
+        case 1: return Vector3D( 1 - f, 1, 0 );
+        case 2: return Vector3D( 0, 1, f );
+        case 3: return Vector3D( 0, 1 - f, 1 );
+        case 4: return Vector3D( f, 0, 1 );
+        default: return Vector3D( 1, 0, 1 - f );
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXAudioEmitter()
+// desc: constructor; every particle is made here, dead
+//-----------------------------------------------------------------------------
+THEREMAXAudioEmitter::THEREMAXAudioEmitter( size_t capacity )
+{
+    following = true;
+    rate = 150;
+    lifetime = 2.5f;
+    minSpeed = 0.5f;
+    maxSpeed = 3.0f;
+    size = 0.12f;
+    budget = THEREMAX_EMITTER_BUDGET;
+
+    for( int b = 0; b < THEREMAX_AUDIO_BANDS; b++ )
+    {
+        m_levels[b] = 0;
+        m_owed[b] = 0;
+    }
+    m_cap = capacity;
+    m_cost = 0;
+    m_updateTime = 0;
+    m_renderTime = 0;
+    m_renderCount = 0;
+    m_numDenied = 0;
+
+    // all made now (no allocation while running)
+    for( size_t i = 0; i < capacity; i++ )
+    {
+        YParticle * p = new YParticle();
+        p->active = false;
+        addParticle( p );
+    }
+
+    m_gravity = new YParticleGravity( Vector3D( 0, -0.6f, 0 ) );
+    m_drag = new YParticleDrag( 0.4f );
+    addInfluence( m_gravity );
+    addInfluence( m_drag );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: ~THEREMAXAudioEmitter()
+// desc: destructor
+//-----------------------------------------------------------------------------
+THEREMAXAudioEmitter::~THEREMAXAudioEmitter()
+{
+    for( size_t i = 0; i < m_particles.size(); i++ )
+        SAFE_DELETE( m_particles[i] );
+    SAFE_DELETE( m_gravity );
+    SAFE_DELETE( m_drag );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: follow()
+// desc: band levels for the next update
+//-----------------------------------------------------------------------------
+void THEREMAXAudioEmitter::follow( const SAMPLE * levels )
+{
+    for( int b = 0; b < THEREMAX_AUDIO_BANDS; b++ )
+    {
+        GLfloat v = levels[b];
+        m_levels[b] = v < 0 ? 0 : v > 1 ? 1 : v;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: update()
+// desc: emit, move everything, then re-measure
+//-----------------------------------------------------------------------------
+void THEREMAXAudioEmitter::update( YTimeInterval dt )
+{
+    double start = XFun::now();
+
+    emit( dt );
+    YParticleSystem::update( dt );
+
+    m_updateTime = XFun::now() - start;
+    adjust();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: emit()
+// desc: rate * level particles a second per band, the fraction carried
+//       over; spawns past the cap are dropped, not owed
+//-----------------------------------------------------------------------------
+void THEREMAXAudioEmitter::emit( YTimeInterval dt )
+{
+    for( int b = 0; b < THEREMAX_AUDIO_BANDS; b++ )
+    {
+        m_owed[b] += rate * m_levels[b] * dt;
+        int count = (int)m_owed[b];
+        m_owed[b] -= count;
+
+        for( int i = 0; i < count; i++ )
+        {
+            if( m_numActive >= m_cap )
+            {
+                m_numDenied += count - i;
+                break;
+            }
+            YParticle * p = spawn( lifetime );
+            if( !p ) break;
+            launch( p, b );
+        }
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: launch()
+// desc: from the origin, louder is faster and brighter
+//-----------------------------------------------------------------------------
+void THEREMAXAudioEmitter::launch( YParticle * p, int b )
+{
+    size_t i = p->slot();
+    GLfloat level = m_levels[b];
+    // 0 for the lowest band, 1 for the highest
+    GLfloat t = THEREMAX_AUDIO_BANDS > 1 ? (GLfloat)b / ( THEREMAX_AUDIO_BANDS - 1 ) : 0;
+
+    // up, spread in a cone that narrows with the band
+    GLfloat spread = 1 - 0.8f * t;
+    GLfloat angle = XFun::rand2f( 0, 2 * M_PI );
+    GLfloat radius = spread * sqrt( XFun::rand2f( 0, 1 ) );
+    Vector3D dir( radius * cos( angle ), 1, radius * sin( angle ) );
+    dir.normalize();
+    dir *= minSpeed + ( maxSpeed - minSpeed ) * level;
+
+    YParticleData & d = m_data;
+    d.lanes[Y_PARTICLE_X].updateSet( i, 0 );
+    d.lanes[Y_PARTICLE_Y].updateSet( i, 0 );
+    d.lanes[Y_PARTICLE_Z].updateSet( i, 0 );
+    d.lanes[Y_PARTICLE_DX].updateSet( i, 0 );
+    d.lanes[Y_PARTICLE_DY].updateSet( i, 0 );
+    d.lanes[Y_PARTICLE_DZ].updateSet( i, 0 );
+    d.lanes[Y_PARTICLE_ORI_X].updateSet( i, 0 );
+    d.lanes[Y_PARTICLE_ORI_Y].updateSet( i, 0 );
+    d.lanes[Y_PARTICLE_ORI_Z].updateSet( i, 0 );
+    d.lanes[Y_PARTICLE_MULTIPLIER].updateSet( i, 1 );
+    d.lanes[Y_PARTICLE_ALPHA].updateSet( i, 1 );
+    d.lanes[Y_PARTICLE_ALPHA].update( i, 0, EMITTER_FADE / lifetime );
+    d.vx[i] = dir.x;
+    d.vy[i] = dir.y;
+    d.vz[i] = dir.z;
+
+    // red (low) to violet (high)
+    p->col = emitter_hue( 0.8f * t ) * ( 0.4f + 0.6f * level );
+    p->alpha = 1;
+    p->loc.set( 0, 0, 0 );
+    // (render() draws quads this size)
+    p->sca.x = size * ( 1.5f - t );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: adjust()
+// desc: cost per live particle (update, plus draw once there is one),
+//       smoothed; the cap is what the budget buys at that cost
+//-----------------------------------------------------------------------------
+void THEREMAXAudioEmitter::adjust()
+{
+    if( m_numActive >= EMITTER_MIN_SAMPLE )
+    {
+        double sample = m_updateTime / m_numActive;
+        if( m_renderCount >= EMITTER_MIN_SAMPLE ) sample += m_renderTime / m_renderCount;
+
+        if( m_cost <= 0 ) m_cost = sample;
+        else m_cost += ( sample - m_cost ) * EMITTER_SMOOTHING;
+    }
+
+    size_t cap = m_particles.size();
+    if( m_cost > 0 && budget / m_cost < cap ) cap = (size_t)( budget / m_cost );
+    if( cap < EMITTER_MIN_CAP ) cap = EMITTER_MIN_CAP;
+    m_cap = cap;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: render()
+// desc: one quad per live particle, one draw
+//-----------------------------------------------------------------------------
+void THEREMAXAudioEmitter::render()
+{
+    double start = XFun::now();
+
+    // (the modelview has the emitter's world in it already)
+    m_vertices.clear();
+    collect( m_vertices, NULL );
+    draw( m_vertices );
+
+    m_renderTime = XFun::now() - start;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: collect()
+// desc: quads of the live particles, facing +z in the emitter's space
+//-----------------------------------------------------------------------------
+void THEREMAXAudioEmitter::collect( vector<THEREMAXSparkVertex> & vertices,
+                                    const XMatrix4 * world )
+{
+    double start = XFun::now();
+
+    size_t count = m_numActive;
+    size_t first = vertices.size();
+    vertices.resize( first + count * 4 );
+    if( count == 0 )
+    {
+        m_renderTime = 0;
+        m_renderCount = 0;
+        return;
+    }
+
+    GLfloat uv[4];
+    THEREMAXSpriteAtlas::rect( THEREMAX_EMITTER_SPRITE, uv );
+    const GLfloat * w = world ? world->m : NULL;
+    THEREMAXSparkVertex * v = &vertices[first];
+    for( size_t i = 0; i < count; i++ )
+    {
+        const YParticle * p = m_particles[i];
+        GLfloat half = p->sca.x * 0.5f;
+        GLubyte r = emitter_byte( p->col.x );
+        GLubyte g = emitter_byte( p->col.y );
+        GLubyte b = emitter_byte( p->col.z );
+        GLubyte a = emitter_byte( p->alpha );
+        for( int c = 0; c < 4; c++, v++ )
+        {
+            GLfloat x = p->loc.x + g_corner[c * 2] * half;
+            GLfloat y = p->loc.y + g_corner[c * 2 + 1] * half;
+            GLfloat z = p->loc.z;
+            if( w )
+            {
+                v->x = w[0] * x + w[4] * y + w[8] * z + w[12];
+                v->y = w[1] * x + w[5] * y + w[9] * z + w[13];
+                v->z = w[2] * x + w[6] * y + w[10] * z + w[14];
+            }
+            else
+            {
+                v->x = x; v->y = y; v->z = z;
+            }
+            v->u = uv[g_corner[c * 2] > 0 ? 2 : 0];
+            v->v = uv[g_corner[c * 2 + 1] > 0 ? 3 : 1];
+            v->r = r; v->g = g; v->b = b; v->a = a;
+        }
+    }
+
+    m_renderCount = count;
+    m_renderTime = XFun::now() - start;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: draw()
+// desc: additive (as the sparks, but glowing where they pile up)
+//-----------------------------------------------------------------------------
+void THEREMAXAudioEmitter::draw( const vector<THEREMAXSparkVertex> & vertices )
+{
+    if( vertices.empty() ) return;
+
+    XGLState::disable( GL_LIGHTING );
+    XGLState::disable( GL_DEPTH_TEST );
+    XGLState::enable( GL_TEXTURE_2D );
+    XGLState::bindTexture( Globals::atlas ? Globals::atlas->texture() : 0 );
+    XGLState::blendFunc( GL_SRC_ALPHA, GL_ONE );
+    XGLState::enable( GL_BLEND );
+
+    const GLubyte * ptr = (const GLubyte *)&vertices[0];
+    GLsizei stride = sizeof(THEREMAXSparkVertex);
+    glVertexPointer( 3, GL_FLOAT, stride, ptr + offsetof( THEREMAXSparkVertex, x ) );
+    glTexCoordPointer( 2, GL_FLOAT, stride, ptr + offsetof( THEREMAXSparkVertex, u ) );
+    glColorPointer( 4, GL_UNSIGNED_BYTE, stride, ptr + offsetof( THEREMAXSparkVertex, r ) );
+    XGLState::clientArrays( XGL_VERTEX_ARRAY | XGL_TEXCOORD_ARRAY | XGL_COLOR_ARRAY );
+    glDrawArrays( GL_QUADS, 0, (GLsizei)vertices.size() );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: footprint()
+// desc: bytes, with the particles and their state
+//-----------------------------------------------------------------------------
+size_t THEREMAXAudioEmitter::footprint() const
+{
+    size_t bytes = sizeof(THEREMAXAudioEmitter) + heapBytes();
+    bytes += m_particles.size() * ( sizeof(YParticle) + sizeof(YParticle *) );
+    bytes += m_data.size() * ( Y_PARTICLE_NUM_CHANNELS * 3 * sizeof(GLfloat)
+                               + 7 * sizeof(GLfloat) + sizeof(unsigned int) );
+    bytes += m_vertices.capacity() * sizeof(THEREMAXSparkVertex);
+    return bytes;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: report()
+// desc: print levels, counts and costs
+//-----------------------------------------------------------------------------
+void THEREMAXAudioEmitter::report() const
+{
+    fprintf( stderr, "[theremax]: emitter: %lu live of %lu (cap %lu), %lu spawned, %lu denied\n",
+             (unsigned long)m_numActive, (unsigned long)m_particles.size(),
+             (unsigned long)m_cap, m_numSpawned, m_numDenied );
+    fprintf( stderr, "[theremax]: emitter: %.3fus per particle, update:%.3fms draw:%.3fms budget:%.3fms\n",
+             m_cost * 1000000, m_updateTime * 1000, m_renderTime * 1000, budget * 1000 );
+    fprintf( stderr, "[theremax]: emitter levels:" );
+    for( int b = 0; b < THEREMAX_AUDIO_BANDS; b++ )
+        fprintf( stderr, " %.2f", m_levels[b] );
+    fprintf( stderr, "\n" );
+}
@@ -0,0 +1,121 @@
+//-----------------------------------------------------------------------------
+// name: theremax-emitter.h
+// desc: particles emitted with the music -- spawn rate, initial velocity
+//       and colour follow the band levels of the output, and emission is
+//       held to a share of the frame
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_EMITTER_H__
+#define __THEREMAX_EMITTER_H__
+
+#include "y-particle.h"
+#include "theremax-globals.h"
+#include "theremax-entity.h"
+#include "theremax-spark-batch.h"
+#include <vector>
+
+// particles made up front (the most that can be live)
+#define THEREMAX_EMITTER_CAPACITY 8192
+// seconds of update + draw per frame the emitter may take
+#define THEREMAX_EMITTER_BUDGET   0.002
+// atlas sprite the particles draw with
+#define THEREMAX_EMITTER_SPRITE   0
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class THEREMAXAudioEmitter
+// desc: a particle system that spawns from its origin. Band b (low to high)
+//       emits rate * level particles a second, faster the louder, coloured
+//       from red (low) to violet (high); low bands spread wide, high bands
+//       go straight up. Each update measures what a live particle costs
+//       (its update, plus its draw once one has been drawn) and stops
+//       emitting while more would put the emitter over budget. Sim thread:
+//       with the sim on a thread of its own, THEREMAXSim::publish() bakes
+//       the quads (collect()) and the GL thread only draws them (draw());
+//       render() is for drawing from the updating thread
+//-----------------------------------------------------------------------------
+class THEREMAXAudioEmitter : public YParticleSystem
+{
+public:
+    THEREMAXAudioEmitter( size_t capacity = THEREMAX_EMITTER_CAPACITY );
+    virtual ~THEREMAXAudioEmitter();
+
+public:
+    // band levels in [0, 1] (THEREMAX_AUDIO_BANDS, low to high)
+    void follow( const SAMPLE * levels );
+    // live particles the budget allows right now
+    size_t cap() const { return m_cap; }
+    // measured seconds per live particle (0: not yet)
+    double cost() const { return m_cost; }
+    // spawns the budget turned down
+    unsigned long numDenied() const { return m_numDenied; }
+    // last update / quads built (seconds; render() adds its draw)
+    double updateTime() const { return m_updateTime; }
+    double renderTime() const { return m_renderTime; }
+    // print levels, counts and costs
+    void report() const;
+
+public:
+    virtual void update( YTimeInterval dt );
+    // every live particle in one draw (collect() then draw(), same thread
+    // as update())
+    virtual void render();
+    unsigned int drawKey() const { return THEREMAX_DRAW_KEY_EMITTER; }
+    // append a quad per live particle, world space given the emitter's
+    // world matrix (NULL: local); counts as the draw in the budget
+    void collect( std::vector<THEREMAXSparkVertex> & vertices, const XMatrix4 * world );
+    // draw collected quads (GL thread; touches no emitter)
+    static void draw( const std::vector<THEREMAXSparkVertex> & vertices );
+    // bytes (see YEntity)
+    size_t footprint() const;
+
+public:
+    // THEREMAXSim::step calls follow() with Globals::audioBands
+    bool following;
+    // particles a second per band at level 1
+    GLfloat rate;
+    // seconds a particle lives
+    GLfloat lifetime;
+    // initial speed at level 0 and 1
+    GLfloat minSpeed;
+    GLfloat maxSpeed;
+    // quad size of the lowest band (higher bands are smaller)
+    GLfloat size;
+    // seconds of update + draw per frame
+    double budget;
+
+protected:
+    // spawn for the bands over dt
+    void emit( YTimeInterval dt );
+    // start a spawned particle off for band b
+    void launch( YParticle * p, int b );
+    // new cost sample, new cap
+    void adjust();
+
+protected:
+    GLfloat m_levels[THEREMAX_AUDIO_BANDS];
+    // fractional particles owed per band
+    GLfloat m_owed[THEREMAX_AUDIO_BANDS];
+    // budget
+    size_t m_cap;
+    double m_cost;
+    double m_updateTime;
+    // last collect() (and render()'s draw): time and quads, for adjust()
+    double m_renderTime;
+    size_t m_renderCount;
+    unsigned long m_numDenied;
+    // render(): quads of the live particles
+    std::vector<THEREMAXSparkVertex> m_vertices;
+    // influences (owned)
+    YParticleGravity * m_gravity;
+    YParticleDrag * m_drag;
+};
+
+
+
+
+#endif
@@ -7,6 +7,7 @@
 //-----------------------------------------------------------------------------
 #include "theremax-entity.h"
 #include "theremax-globals.h"
+#include "theremax-atlas.h"
 #include "x-fun.h"
 
 using namespace std;
@@ -14,8 +15,86 @@ using namespace std;
 
 
 
-// texture coordinates
-static const GLshort g_coord[ ] = { 0, 0, 1, 0, 0, 1, 1, 1 };
+// texture coordinates (0 is u0/v0, 1 is u1/v1 of the atlas cell)
+static const int g_coord[ ] = { 0, 0, 1, 0, 0, 1, 1, 1 };
+
+int THEREMAXSpark::ourUpdateBatch = YUpdateScheduler::registerBatch(
+    typeid(THEREMAXSpark), "THEREMAXSpark", THEREMAXSpark::batchUpdate,
+    THEREMAX_UPDATE_STAGE_SPARK );
+std::vector<GLfloat> THEREMAXSpark::ourRampValue;
+std::vector<GLfloat> THEREMAXSpark::ourRampGoal;
+std::vector<GLfloat> THEREMAXSpark::ourRampSlew;
+std::vector<size_t> THEREMAXSpark::ourFreeRamps;
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXSpark()
+// desc: constructor; takes a ramp slot (a free one if there is one)
+//-----------------------------------------------------------------------------
+THEREMAXSpark::THEREMAXSpark() : texture(0), size(0)
+{
+    if( ourFreeRamps.size() )
+    {
+        m_ramp = ourFreeRamps.back();
+        ourFreeRamps.pop_back();
+    }
+    else
+    {
+        m_ramp = ourRampValue.size();
+        ourRampValue.push_back( 0 );
+        ourRampGoal.push_back( 0 );
+        ourRampSlew.push_back( 0 );
+    }
+
+    setAlphaRamp( Vector3D( 1, 1, 1 ) );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: ~THEREMAXSpark()
+// desc: destructor; frees the ramp slot (still, so the batch can slew it)
+//-----------------------------------------------------------------------------
+THEREMAXSpark::~THEREMAXSpark()
+{
+    setAlphaRamp( Vector3D( 0, 0, 0 ) );
+    ourFreeRamps.push_back( m_ramp );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: alphaRamp()
+// desc: the ramp as a Vector3D (value / goal / slew)
+//-----------------------------------------------------------------------------
+Vector3D THEREMAXSpark::alphaRamp() const
+{
+    return Vector3D( ourRampValue[m_ramp], ourRampGoal[m_ramp], ourRampSlew[m_ramp] );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: setAlphaRamp()
+// desc: set the ramp's value, goal, and slew / value and goal
+//-----------------------------------------------------------------------------
+void THEREMAXSpark::setAlphaRamp( const Vector3D & ramp )
+{
+    ourRampValue[m_ramp] = ramp.value;
+    ourRampGoal[m_ramp] = ramp.goal;
+    ourRampSlew[m_ramp] = ramp.slew;
+}
+
+void THEREMAXSpark::setAlphaRamp( GLfloat value, GLfloat goal )
+{
+    ourRampValue[m_ramp] = value;
+    ourRampGoal[m_ramp] = goal;
+}
 
 
 
@@ -40,6 +119,8 @@ void THEREMAXSpark::set( int _texture, float _size, float _alpha )
 //-----------------------------------------------------------------------------
 void THEREMAXSpark::setSize( float _size )
 {
+    // remember
+    size = _size;
     _size *= 0.3f;
     vertices[0] = -_size; vertices[1] = -_size;
     vertices[2] = _size; vertices[3] = -_size;
@@ -68,11 +149,43 @@ void THEREMAXSpark::setTexture( int _texture )
 //-------------------------------------------------------------------------------
 void THEREMAXSpark::update( YTimeInterval dt )
 {
-    // slew
-    ALPHA.interp( dt );
+    // slew (as Vector3D::interp)
+    GLfloat & value = ourRampValue[m_ramp];
+    value = ( ourRampGoal[m_ramp] - value ) * ourRampSlew[m_ramp] * (GLfloat)dt + value;
     // this->sca.set((Globals::cvIntensity * -1) + 1, (Globals::cvIntensity * -1) + 1, (Globals::cvIntensity * -1) + 1);
+}
+
+
 
-    this->alpha = ALPHA.value;
+
+//-------------------------------------------------------------------------------
+// name: batchUpdate()
+// desc: update() for every spark in the scene, in one loop -- straight down
+//       the ramps when the scene holds every spark there is (count distinct
+//       nodes, as many as there are sparks), else by slot
+//-------------------------------------------------------------------------------
+void THEREMAXSpark::batchUpdate( YEntity ** nodes, size_t count, YTimeInterval dt )
+{
+    GLfloat delta = (GLfloat)dt;
+    GLfloat * value = &ourRampValue[0];
+    const GLfloat * goal = &ourRampGoal[0];
+    const GLfloat * slew = &ourRampSlew[0];
+
+    // all of them (free slots have no slew)
+    if( count == ourRampValue.size() - ourFreeRamps.size() )
+    {
+        size_t slots = ourRampValue.size();
+        for( size_t i = 0; i < slots; i++ )
+            value[i] = ( goal[i] - value[i] ) * slew[i] * delta + value[i];
+        return;
+    }
+
+    // some pooled or off
+    for( size_t i = 0; i < count; i++ )
+    {
+        size_t r = ((THEREMAXSpark *)nodes[i])->m_ramp;
+        value[r] = ( goal[r] - value[r] ) * slew[r] * delta + value[r];
+    }
 }
 
 
@@ -84,41 +197,36 @@ void THEREMAXSpark::update( YTimeInterval dt )
 //-------------------------------------------------------------------------------
 void THEREMAXSpark::render( )
 {
-    // disable depth
-    glDisable( GL_DEPTH_TEST );
-    // enable texture
-    glEnable( GL_TEXTURE_2D );
-    // set blend function
-    // glBlendFunc( GL_ONE, GL_ONE );
-    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-    // enable blend
-    glEnable( GL_BLEND );
+    // the sim draws all sparks at once
+    if( Globals::sparkBatch ) return;
+    
+    // state (left set: the next spark needs the same)
+    XGLState::disable( GL_DEPTH_TEST );
+    XGLState::enable( GL_TEXTURE_2D );
+    XGLState::blendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    XGLState::enable( GL_BLEND );
+    XGLState::clientArrays( XGL_VERTEX_ARRAY | XGL_TEXCOORD_ARRAY );
     
-    // bind to texture
-    // glBindTexture( GL_TEXTURE_2D, Globals::textures[this->texture] );
+    // bind to the atlas (untextured until it's loaded)
+    XGLState::bindTexture( Globals::atlas ? Globals::atlas->texture() : 0 );
+    GLfloat rect[4], coords[8];
+    THEREMAXSpriteAtlas::rect( this->texture, rect );
+    for( int i = 0; i < 8; i += 2 )
+    {
+        coords[i] = rect[g_coord[i] * 2];
+        coords[i + 1] = rect[g_coord[i + 1] * 2 + 1];
+    }
     
     // set color
-    glColor4f( col.x, col.y, col.z, alpha * ALPHA.value );
+    glColor4f( col.x, col.y, col.z, drawAlpha() );
     
     // set vertex coordinates
     glVertexPointer( 2, GL_FLOAT, 0, this->vertices );
-    glEnableClientState( GL_VERTEX_ARRAY );
-    
     // set texture coordinates
-    glTexCoordPointer( 2, GL_SHORT, 0, g_coord );
-    glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+    glTexCoordPointer( 2, GL_FLOAT, 0, coords );
     
     // draw stuff!
     glDrawArrays( GL_TRIANGLE_STRIP, 0, 4 );
-    
-    // disable texture
-    glDisable( GL_TEXTURE_2D );
-    // disable blend
-    glDisable( GL_BLEND );
-    
-    // disable client states
-    glDisableClientState( GL_VERTEX_ARRAY );
-    glDisableClientState( GL_TEXTURE_COORD_ARRAY );
 }
 
 
@@ -9,9 +9,21 @@
 #define __THEREMAX_ENTITY_H__
 
 #include "y-entity.h"
+#include "y-update.h"
 #include "x-buffer.h"
 #include <vector>
 
+// draw keys (YEntity::drawKey) of spark textures
+#define THEREMAX_DRAW_KEY_SPARK     0x100
+#define THEREMAX_DRAW_KEY_SPARK_END 0x200
+// draw key of particle emitters (after the sparks)
+#define THEREMAX_DRAW_KEY_EMITTER   0x200
+
+// update stages (YUpdateScheduler), parents before children
+#define THEREMAX_UPDATE_STAGE_FLOCK 1
+#define THEREMAX_UPDATE_STAGE_BOID  2
+#define THEREMAX_UPDATE_STAGE_SPARK 3
+
 
 
 
@@ -22,28 +34,63 @@
 class THEREMAXSpark : public YEntity
 {
 public:
-    // constructor
-    THEREMAXSpark() : texture(0), ALPHA( 1, 1, 1 ) { }
+    // constructor (takes a ramp slot) / destructor (gives it back)
+    THEREMAXSpark();
+    ~THEREMAXSpark();
     
 public:
     // set
     void set( int _texture, float _size, float _alpha );
     void setTexture( int _texture );
     void setSize( float _size );
+    // alpha ramp (value / goal / slew, as a slewed Vector3D)
+    Vector3D alphaRamp() const;
+    void setAlphaRamp( const Vector3D & ramp );
+    void setAlphaRamp( GLfloat value, GLfloat goal );
+    // alpha as drawn: alpha times the ramp, where alpha follows the ramp
+    GLfloat drawAlpha() const { GLfloat v = ourRampValue[m_ramp]; return v * v; }
     
 public:
     // update
     void update( YTimeInterval dt );
+    // all sparks in one loop
+    int updateBatch() const { return ourUpdateBatch; }
+    static void batchUpdate( YEntity ** nodes, size_t count, YTimeInterval dt );
     // render
     void render();
+    // grouped by texture
+    unsigned int drawKey() const { return THEREMAX_DRAW_KEY_SPARK + ( texture & 0xff ); }
+    // corners of the quad
+    GLfloat geometryRadius() const { return size * 0.3f * 1.41421356f; }
+    // bytes (see YEntity)
+    size_t footprint() const { return sizeof(THEREMAXSpark) + heapBytes(); }
     
 public:
     // which ripple texture
     GLuint texture;
+    // size (as passed to setSize)
+    GLfloat size;
     // vertices
     GLfloat vertices[8];
-    // alpha ramp
-    Vector3D ALPHA;
+
+public:
+    // id from YUpdateScheduler::registerBatch
+    static int ourUpdateBatch;
+
+protected:
+    // slot of the alpha ramp
+    size_t m_ramp;
+    // every spark's alpha ramp by field (free slots don't slew), and the
+    // free slots
+    static std::vector<GLfloat> ourRampValue;
+    static std::vector<GLfloat> ourRampGoal;
+    static std::vector<GLfloat> ourRampSlew;
+    static std::vector<size_t> ourFreeRamps;
+
+private:
+    // one ramp slot per spark: no copies
+    THEREMAXSpark( const THEREMAXSpark & );
+    THEREMAXSpark & operator =( const THEREMAXSpark & );
 };
 
 #endif
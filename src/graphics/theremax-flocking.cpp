@@ -9,49 +9,298 @@
 #include "theremax-flocking.h"
 #include "theremax-globals.h"
 #include "x-fun.h"
+#include <math.h>
 
-YTimeInterval dtCount = 0;
+
+
+
+// golden ratio conjugate, spreads rule phases evenly for any number of flocks
+#define RULE_PHASE_STEP 0.6180339887498949
+// aggregate boids breathe around their offset by up to twice this much
+// (the wobble is sin( t + phase ) - sin( phase ), zero when they join)
+#define AGGREGATE_WOBBLE 0.1
+// ...at this rate (radians per second)
+#define AGGREGATE_WOBBLE_RATE 1.5
+
+// slots per slab chunk
+#define BOID_SLAB_CHUNK 1024
+#define FLOCK_SLAB_CHUNK 64
+
+unsigned long THEREMAXFlock::ourFlockCount = 0;
+
+Y_SLAB_DEFINE( THEREMAXBoid, BOID_SLAB_CHUNK )
+Y_SLAB_DEFINE( THEREMAXFlock, FLOCK_SLAB_CHUNK )
+
+int THEREMAXBoid::ourUpdateBatch = YUpdateScheduler::registerBatch(
+    typeid(THEREMAXBoid), "THEREMAXBoid", THEREMAXBoid::batchUpdate, THEREMAX_UPDATE_STAGE_BOID );
+int THEREMAXFlock::ourUpdateBatch = YUpdateScheduler::registerBatch(
+    typeid(THEREMAXFlock), "THEREMAXFlock", THEREMAXFlock::batchUpdate, THEREMAX_UPDATE_STAGE_FLOCK );
 
 THEREMAXBoid::THEREMAXBoid()
+{
+    this->spark = &m_spark;
+    this->addChild(spark);
+    reset();
+}
+
+THEREMAXBoid::~THEREMAXBoid()
+{
+    // (the spark is a member)
+    this->removeAllChildren();
+}
+
+void THEREMAXBoid::reset()
 {
     ALPHA.set(1,1,1);
-    this->spark = new THEREMAXSpark;
+    alpha = 1;
+    loc.setAll(0);
+    vel.setAll(0);
+    interFlock.setAll(0);
+    lodOffset.setAll(0);
+
     spark->set(0, 0.1, 0.5);
     // spark->col.set(0,XFun::rand2f(0.5, 0.6),.5);
-    spark->ALPHA.value = 0.1;
-    spark->ALPHA.goal = XFun::rand2f(0.2, 0.6);
+    spark->setAlphaRamp( 0.1, XFun::rand2f(0.2, 0.6) );
     spark->setSize(XFun::rand2f(0.05, 0.2));
-    
-    this->addChild(spark);
 }
 
 void THEREMAXBoid::update( YTimeInterval dt )
 {
-    dtCount += dt;
-    if (dtCount > (1 / THEREMAX_SRATE) * 30)
+    THEREMAXFlock * flock = (THEREMAXFlock *)parent;
+
+    // slew
+    ALPHA.interp( dt );
+    this->alpha = ALPHA.value;
+
+    // aggregated: ride along with the flock's body
+    if( flock->getLod() == THEREMAX_LOD_AGGREGATE )
     {
-        Vector3D v1, v2, v3, v4, v5, v6;
+        this->loc = flock->aggregateCenter() + flock->aggregateOffset( this );
+        return;
+    }
 
-        // slew
-        ALPHA.interp( dt );
-        this->alpha = ALPHA.value;
-    
-        v1 = ((THEREMAXFlock *)parent)->centerMass(this);
-        v2 = ((THEREMAXFlock *)parent)->collisionDetect(this);
-        v3 = ((THEREMAXFlock *)parent)->potentialVelocity(this);
-        v4 = ((THEREMAXFlock *)parent)->tendToPlace(this);
-        v5 = ((THEREMAXFlock *)parent)->boundPosition(this);
-        ((THEREMAXFlock *)parent)->boundVelocity(this);
-        // // 
+    // steering rules run on the flock's schedule
+    if( flock->rulesDue() )
+    {
+        flock->ruleEvals++;
+        Vector3D v1, v2, v3, v4, v5;
+
+        v1 = flock->centerMass(this);
+        v2 = flock->collisionDetect(this);
+        v3 = flock->potentialVelocity(this);
+        v4 = flock->tendToPlace(this);
+        v5 = flock->boundPosition(this);
+        flock->boundVelocity(this);
 
-        this->vel = (this->vel + v1 + v2 + v3 + v4 + v5);
-        dtCount = 0;
+        this->vel = (this->vel + v1 + v2 + v3 + v4 + v5 + this->interFlock + flock->interFlock);
     }
+
+    // integrate every frame
     this->loc = this->loc + this->vel * dt;
     return;
 };
 
 
+
+
+//-----------------------------------------------------------------------------
+// name: batchUpdate()
+// desc: update() for every boid in the scene (flocks have updated)
+//-----------------------------------------------------------------------------
+void THEREMAXBoid::batchUpdate( YEntity ** nodes, size_t count, YTimeInterval dt )
+{
+    for( size_t i = 0; i < count; i++ )
+        ((THEREMAXBoid *)nodes[i])->THEREMAXBoid::update( dt );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXFlock()
+// desc: constructor
+//-----------------------------------------------------------------------------
+THEREMAXFlock::THEREMAXFlock()
+{
+    broadphaseSlot = 0;
+    reset();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: reset()
+// desc: rule schedule, level of detail and motion as when new
+//-----------------------------------------------------------------------------
+void THEREMAXFlock::reset()
+{
+    m_rulesDue = false;
+    m_ruleClock = 0;
+    m_lod = THEREMAX_LOD_FULL;
+    m_aggCenter.setAll( 0 );
+    m_aggVel.setAll( 0 );
+    m_aggTime = 0;
+    ruleEvals = 0;
+    boundCenter.setAll( 0 );
+    boundRadius = 0;
+    interFlock.setAll( 0 );
+    loc.setAll( 0 );
+    vel.setAll( 0 );
+    setRuleRate( THEREMAX_FLOCK_RULE_RATE );
+
+    // stagger so flocks don't all evaluate rules on the same frame
+    double phase = fmod( ourFlockCount++ * RULE_PHASE_STEP, 1.0 );
+    m_ruleClock = phase * m_rulePeriod;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: ~THEREMAXFlock()
+// desc: destructor
+//-----------------------------------------------------------------------------
+THEREMAXFlock::~THEREMAXFlock()
+{
+    this->deleteChildren();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: setRuleRate()
+// desc: set how many times per second the steering rules run
+//-----------------------------------------------------------------------------
+void THEREMAXFlock::setRuleRate( double rate )
+{
+    m_ruleRate = rate;
+    m_rulePeriod = rate > 0 ? 1.0 / rate : 0;
+    // keep the current phase within the new period
+    if( m_rulePeriod > 0 )
+        m_ruleClock = fmod( m_ruleClock, m_rulePeriod );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: setLod()
+// desc: change level of detail; boids keep their positions and velocities
+//       across transitions so promotion back to full detail is seamless
+//-----------------------------------------------------------------------------
+void THEREMAXFlock::setLod( THEREMAXLod lod )
+{
+    if( lod == m_lod ) return;
+    size_t count = this->children.size();
+
+    // collapse into one body
+    if( lod == THEREMAX_LOD_AGGREGATE && count > 0 )
+    {
+        m_aggCenter.setAll( 0 );
+        m_aggVel.setAll( 0 );
+        for( size_t i = 0; i < count; i++ )
+        {
+            m_aggCenter += this->children[i]->loc;
+            m_aggVel += this->children[i]->vel;
+        }
+        m_aggCenter *= 1.0f / count;
+        m_aggVel *= 1.0f / count;
+        m_aggTime = 0;
+        // remember where each boid sits in the body
+        for( size_t i = 0; i < count; i++ )
+        {
+            THEREMAXBoid * boid = (THEREMAXBoid *)this->children[i];
+            boid->lodOffset = boid->loc - m_aggCenter;
+        }
+    }
+    // break out of the body, everyone moving with it
+    else if( m_lod == THEREMAX_LOD_AGGREGATE )
+    {
+        for( size_t i = 0; i < count; i++ )
+            this->children[i]->vel = m_aggVel;
+    }
+
+    m_lod = lod;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: aggregateOffset()
+// desc: where a boid sits relative to the aggregate center
+//-----------------------------------------------------------------------------
+Vector3D THEREMAXFlock::aggregateOffset( THEREMAXBoid * boid ) const
+{
+    // per-boid phase from its resting offset; the wobble starts at zero
+    // so a boid doesn't jump when its flock is demoted (m_aggTime = 0)
+    GLfloat phase = boid->lodOffset.x * 3.1f + boid->lodOffset.y * 1.7f;
+    GLfloat wobble = ::sin( m_aggTime * AGGREGATE_WOBBLE_RATE + phase ) - ::sin( phase );
+    return boid->lodOffset * ( 1 + AGGREGATE_WOBBLE * wobble );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: update()
+// desc: advance the rule clock (runs before the boids, which are children)
+//-----------------------------------------------------------------------------
+void THEREMAXFlock::update( YTimeInterval dt )
+{
+    YTimeInterval period = m_rulePeriod;
+    if( m_lod == THEREMAX_LOD_REDUCED )
+        period *= THEREMAX_LOD_REDUCED_DIVISOR;
+
+    // aggregated: flock-level rules on the body, integrate every frame
+    if( m_lod == THEREMAX_LOD_AGGREGATE )
+    {
+        m_ruleClock += dt;
+        if( period <= 0 || m_ruleClock >= period )
+        {
+            if( period > 0 ) m_ruleClock = fmod( m_ruleClock, period );
+            m_aggVel += tendToPlace( m_aggCenter ) + boundPosition( m_aggCenter ) + interFlock;
+            GLfloat mag = m_aggVel.magnitude();
+            if( mag > 5 ) m_aggVel *= 5 / mag;
+        }
+        m_aggCenter += m_aggVel * dt;
+        m_aggTime += dt;
+        m_rulesDue = false;
+        return;
+    }
+
+    // every frame
+    if( period <= 0 )
+    {
+        m_rulesDue = true;
+        return;
+    }
+
+    // advance
+    m_ruleClock += dt;
+    m_rulesDue = m_ruleClock >= period;
+    // wrap (fmod keeps the stagger after a long frame)
+    if( m_rulesDue )
+        m_ruleClock = fmod( m_ruleClock, period );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: batchUpdate()
+// desc: update() for every flock in the scene
+//-----------------------------------------------------------------------------
+void THEREMAXFlock::batchUpdate( YEntity ** nodes, size_t count, YTimeInterval dt )
+{
+    for( size_t i = 0; i < count; i++ )
+        ((THEREMAXFlock *)nodes[i])->THEREMAXFlock::update( dt );
+}
+
+
+
 Vector3D THEREMAXFlock::centerMass(THEREMAXBoid * boid)
 {
     Vector3D perceivedCenter;
@@ -113,41 +362,51 @@ Vector3D THEREMAXFlock::potentialVelocity(THEREMAXBoid * boid)
 };
 
 Vector3D THEREMAXFlock::tendToPlace(THEREMAXBoid * boid)
+{
+    return tendToPlace(boid->loc);
+}
+
+Vector3D THEREMAXFlock::tendToPlace(const Vector3D & loc)
 {
     Vector3D place(0,0,0);
     double tend = (Globals::cvIntensity * -1 + 1);
     if (tend > .8)
     {
-        return (place - boid->loc) * ((Globals::cvIntensity * -1) + 1);
+        return (place - loc) * ((Globals::cvIntensity * -1) + 1);
     }
-    return (place - boid->loc) * 0.000001;//(place - boid->loc) * 0.0001 * (Globals::cvIntensity * -1 + 1);
+    return (place - loc) * 0.000001;//(place - loc) * 0.0001 * (Globals::cvIntensity * -1 + 1);
 }
 
 Vector3D THEREMAXFlock::boundPosition(THEREMAXBoid * boid)
+{
+    return boundPosition(boid->loc);
+}
+
+Vector3D THEREMAXFlock::boundPosition(const Vector3D & loc)
 {
     int xmin = -30, xmax = 30, ymin = -50, ymax = 10, zmin = -150, zmax = 10;
     Vector3D v;
-    if(boid->loc.x < xmin)
+    if(loc.x < xmin)
     {
         v.x = 10 * Globals::cvIntensity;
     }
-    else if (boid->loc.x > xmax)
+    else if (loc.x > xmax)
     {
         v.x = -10 * Globals::cvIntensity;
     }
-    if (boid->loc.y < ymin)
+    if (loc.y < ymin)
     {
         v.y = 10 * Globals::cvIntensity;
     }
-    else if (boid->loc.y > ymax)
+    else if (loc.y > ymax)
     {
         v.y = -10 * Globals::cvIntensity;
     }
-    if (boid->loc.z < zmin)
+    if (loc.z < zmin)
     {
         v.z = 10 * Globals::cvIntensity;
     }
-    else if (boid->loc.z > zmax)
+    else if (loc.z > zmax)
     {
         v.z = -10 * Globals::cvIntensity;
     }
@@ -166,6 +425,41 @@ void THEREMAXFlock::boundVelocity(THEREMAXBoid * boid)
     }
 }
 
+//-----------------------------------------------------------------------------
+// name: refitBounds()
+// desc: bounding sphere around the boids, in world space (flocks are only
+//       ever translated, so a boid's world position is loc + boid->loc)
+//-----------------------------------------------------------------------------
+void THEREMAXFlock::refitBounds()
+{
+    Vector3D center;
+    GLfloat radiusSqr = 0;
+    size_t count = this->children.size();
+
+    // empty
+    if( count == 0 )
+    {
+        boundCenter = this->loc;
+        boundRadius = 0;
+        return;
+    }
+
+    // centroid
+    for( size_t i = 0; i < count; i++ )
+        center += this->children[i]->loc;
+    center *= 1.0f / count;
+
+    // farthest boid
+    for( size_t i = 0; i < count; i++ )
+    {
+        GLfloat d = (this->children[i]->loc - center).magnitudeSqr();
+        if( d > radiusSqr ) radiusSqr = d;
+    }
+
+    boundCenter = center + this->loc;
+    boundRadius = ::sqrt( radiusSqr );
+}
+
 void THEREMAXFlock::init(int count)
 {
     for (int i = 0; i < count; i++)
@@ -176,4 +470,21 @@ void THEREMAXFlock::init(int count)
 
         this->addChild(boid);
     }
+}
+
+void THEREMAXFlock::resize(int count)
+{
+    // grow
+    if (count > (int)this->children.size())
+    {
+        init(count - (int)this->children.size());
+        return;
+    }
+    // shrink from the end
+    while ((int)this->children.size() > count)
+    {
+        THEREMAXBoid * boid = (THEREMAXBoid *)this->children.back();
+        this->removeChild(boid);
+        delete boid;
+    }
 }
\ No newline at end of file
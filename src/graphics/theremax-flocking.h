@@ -10,32 +10,79 @@
 
 #include "y-entity.h"
 #include "theremax-entity.h"
+#include "y-slab.h"
 
 using namespace std;
 
+// default rate (per second) at which a flock evaluates its steering rules
+#define THEREMAX_FLOCK_RULE_RATE 30
+// rule rate divisor for flocks at THEREMAX_LOD_REDUCED
+#define THEREMAX_LOD_REDUCED_DIVISOR 4
+
+// level of detail for flock simulation
+enum THEREMAXLod
+{
+    // steering rules at the flock's rule rate
+    THEREMAX_LOD_FULL = 0,
+    // steering rules at a fraction of the rule rate
+    THEREMAX_LOD_REDUCED,
+    // flock moves as one body, boids are offset procedurally
+    THEREMAX_LOD_AGGREGATE,
+    // number of levels
+    THEREMAX_LOD_COUNT
+};
+
 //-----------------------------------------------------------------------------
 // name: class boid
 // desc: ...
 //-----------------------------------------------------------------------------
 class THEREMAXBoid : public YEntity
 {
+    // boids of a flock sit back to back, each with its spark
+    Y_SLAB_ALLOCATED
+
 public:
     // constructor
     THEREMAXBoid();
+    // destructor
+    ~THEREMAXBoid();
     
 public:
     //set
     void set();
+    // back to the state of a new boid, spark included (for reuse)
+    void reset();
     
 public:
     // update
     void update( YTimeInterval dt);
+    // all boids in one loop, after their flocks
+    int updateBatch() const { return ourUpdateBatch; }
+    static void batchUpdate( YEntity ** nodes, size_t count, YTimeInterval dt );
     // void render();
+    // nothing to draw (the spark is)
+    unsigned int drawKey() const { return YDRAW_KEY_NONE; }
+    GLfloat geometryRadius() const { return 0; }
+    // bytes, less the inline spark (counted as a node of its own)
+    size_t footprint() const { return sizeof(THEREMAXBoid) - sizeof(THEREMAXSpark) + heapBytes(); }
     
 public:
-    // alpha ramp
+    // the boid's spark (m_spark, the only child)
     THEREMAXSpark * spark;
+    // alpha ramp
     Vector3D ALPHA;
+    // steering from neighbouring flocks (written by the broadphase)
+    Vector3D interFlock;
+    // offset from the flock center while aggregated
+    Vector3D lodOffset;
+
+protected:
+    // inline, so the walk finds it right after the boid
+    THEREMAXSpark m_spark;
+
+public:
+    // id from YUpdateScheduler::registerBatch
+    static int ourUpdateBatch;
 };
 
 //-----------------------------------------------------------------------------
@@ -44,28 +91,105 @@ public:
 //-----------------------------------------------------------------------------
 class THEREMAXFlock : public YEntity
 {
+    Y_SLAB_ALLOCATED
+
 public:
     // constructor
-    THEREMAXFlock() {} ;
+    THEREMAXFlock();
+    // destructor (deletes the boids)
+    ~THEREMAXFlock();
     
 public:
     //set
     void set();
     void init(int count);
+    // grow (randomly placed, as init) or shrink to count boids
+    void resize(int count);
+    // back to the state of a new flock, keeping its boids (for reuse)
+    void reset();
+    
+public:
+    // set how many times per second the steering rules run (<= 0: every frame)
+    void setRuleRate( double rate );
+    // get it
+    double getRuleRate() const { return m_ruleRate; }
+    // are the steering rules due this frame?
+    bool rulesDue() const { return m_rulesDue; }
+    // time into the current rule period (the stagger phase)
+    YTimeInterval getRuleClock() const { return m_ruleClock; }
+    void setRuleClock( YTimeInterval clock ) { m_ruleClock = clock; }
+    
+public:
+    // change the level of detail (transitions are continuous)
+    void setLod( THEREMAXLod lod );
+    // get it
+    THEREMAXLod getLod() const { return m_lod; }
+    // center of the aggregate body (local space)
+    const Vector3D & aggregateCenter() const { return m_aggCenter; }
+    // velocity of the aggregate body (local space)
+    const Vector3D & aggregateVelocity() const { return m_aggVel; }
+    // procedural offset of a boid from the aggregate center
+    Vector3D aggregateOffset( THEREMAXBoid * boid ) const;
+    
+public:
+    // recompute the world-space bounding sphere around the boids
+    void refitBounds();
+    // the boids (children)
+    const vector<YEntity *> & boids() const { return children; }
     
 public:
     Vector3D centerMass(THEREMAXBoid * boid);
     Vector3D collisionDetect(THEREMAXBoid * boid);
     Vector3D potentialVelocity(THEREMAXBoid * boid);
     Vector3D tendToPlace(THEREMAXBoid * boid);
+    Vector3D tendToPlace(const Vector3D & loc);
     Vector3D boundPosition(THEREMAXBoid * boid);
+    Vector3D boundPosition(const Vector3D & loc);
     void boundVelocity(THEREMAXBoid * boid);
     // update
-    // void update( YTimeInterval dt);
+    void update( YTimeInterval dt );
+    // all flocks in one loop, before their boids
+    int updateBatch() const { return ourUpdateBatch; }
+    static void batchUpdate( YEntity ** nodes, size_t count, YTimeInterval dt );
     // void render();
+    // nothing to draw
+    unsigned int drawKey() const { return YDRAW_KEY_NONE; }
+    GLfloat geometryRadius() const { return 0; }
+    // bytes (see YEntity)
+    size_t footprint() const { return sizeof(THEREMAXFlock) + heapBytes(); }
     
 public:
     // alpha ramp
     Vector3D ALPHA;
+    // world-space bounding sphere (see refitBounds)
+    Vector3D boundCenter;
+    GLfloat boundRadius;
+    // steering toward neighbouring flocks (written by the broadphase)
+    Vector3D interFlock;
+    // index in the broadphase (written by it)
+    unsigned int broadphaseSlot;
+    // its boids' rule evaluations since the sim last collected them
+    unsigned long ruleEvals;
+
+protected:
+    // rule scheduling
+    double m_ruleRate;
+    YTimeInterval m_rulePeriod;
+    YTimeInterval m_ruleClock;
+    bool m_rulesDue;
+    // level of detail
+    THEREMAXLod m_lod;
+    // aggregate body (local space)
+    Vector3D m_aggCenter;
+    Vector3D m_aggVel;
+    YTimeInterval m_aggTime;
+
+public:
+    // id from YUpdateScheduler::registerBatch
+    static int ourUpdateBatch;
+
+protected:
+    // number of flocks created (used to stagger rule phases)
+    static unsigned long ourFlockCount;
 };
 #endif
\ No newline at end of file
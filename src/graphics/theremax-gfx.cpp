@@ -15,11 +15,23 @@
 #include "x-fun.h"
 #include "x-gfx.h"
 #include "x-loadlum.h"
+#include "y-slab.h"
 #include "x-vector3d.h"
 #include "theremax-flocking.h"
+#include "theremax-snapshot.h"
+#include "theremax-offscreen.h"
+#include "theremax-stats.h"
+#include "theremax-pacer.h"
+#include "theremax-sim-thread.h"
+#include "theremax-atlas.h"
+#include "theremax-hud.h"
+#include "theremax-resolution.h"
+#include "theremax-emitter.h"
+#include "theremax-analysis.h"
 
 #include <iostream>
 #include <vector>
+#include <stdio.h>
 using namespace std;
 
 //-----------------------------------------------------------------------------
@@ -27,6 +39,7 @@ using namespace std;
 //-----------------------------------------------------------------------------
 void idleFunc();
 void displayFunc();
+void displayFrame( YTimeInterval fixedStep, double & updateTime, double & renderTime );
 void reshapeFunc( int width, int height );
 void keyboardFunc( unsigned char, int, int );
 void mouseFunc( int button, int state, int x, int y );
@@ -41,6 +54,9 @@ void blendPane();
 void updateNodeEntities();
 void renderNodeEntities();
 
+// eye position from the last look()
+static Vector3D g_eye;
+
 
 
 
@@ -106,8 +122,20 @@ bool theremax_gfx_init( int argc, const char ** argv )
     
     // do our own initialization
     initialize_graphics();
+    // performance overlay, collects while hidden (its text needs glutInit,
+    // so not offscreen)
+    Globals::hud = new THEREMAXHud();
     // simulation
     initialize_simulation();
+    // frame pacing (needs the window's context for swap control)
+    Globals::pacer = new THEREMAXFramePacer();
+    Globals::pacer->setFrameRate( Globals::sim->getDesiredFrameRate() );
+    Globals::pacer->init();
+    // scene resolution that holds that rate
+    Globals::resolution = new THEREMAXDynamicResolution();
+    Globals::resolution->setTarget( 1000 / Globals::sim->getDesiredFrameRate() );
+    Globals::resolution->resize( Globals::windowWidth, Globals::windowHeight );
+    Globals::resolution->init();
     // do data
     if( !initialize_data() )
     {
@@ -133,6 +161,9 @@ bool theremax_gfx_init( int argc, const char ** argv )
 //-----------------------------------------------------------------------------
 void theremax_gfx_loop()
 {
+    // update on another core while this one draws
+    if( Globals::simThread )
+        theremax_sim_thread_start( Globals::sim );
     // let GLUT handle the current thread from here
     glutMainLoop();
 }
@@ -163,25 +194,25 @@ void initialize_graphics()
     // set the shading model to 'smooth'
     glShadeModel( GL_SMOOTH );
     // enable depth
-    glEnable( GL_DEPTH_TEST );
+    XGLState::enable( GL_DEPTH_TEST );
     // set the front faces of polygons
     glFrontFace( GL_CCW );
     // set fill mode
     glPolygonMode( GL_FRONT_AND_BACK, Globals::fillmode );
     // enable lighting
-    glEnable( GL_LIGHTING );
+    XGLState::enable( GL_LIGHTING );
     // enable lighting for front
     glLightModeli( GL_FRONT_AND_BACK, GL_TRUE );
     // material have diffuse and ambient lighting
     glColorMaterial( GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE );
     // enable color
-    glEnable( GL_COLOR_MATERIAL );
+    XGLState::enable( GL_COLOR_MATERIAL );
     // normalize (for scaling)
-    glEnable( GL_NORMALIZE );
+    XGLState::enable( GL_NORMALIZE );
     // line width
     glLineWidth( Globals::linewidth );
     
-    // enable light 0
+    // enable light 0 (lights aren't shadowed by XGLState)
     glEnable( GL_LIGHT0 );
     
     // setup and enable light 1
@@ -190,8 +221,9 @@ void initialize_graphics()
     glLightfv( GL_LIGHT1, GL_SPECULAR, Globals::light1_specular );
     glEnable( GL_LIGHT1 );
     
-    // load textures
-    // loadTextures();
+    // load textures (decoded in the background, uploaded when ready)
+    Globals::atlas = new THEREMAXSpriteAtlas();
+    Globals::atlas->start( Globals::path + Globals::relpath );
     
     // fog
     Globals::fog_mode[0] = 0;
@@ -215,7 +247,7 @@ void initialize_graphics()
     // fog end depth
     glFogf( GL_FOG_END, 10.5f );
     // enable
-    if( Globals::fog_filter ) glEnable( GL_FOG );
+    if( Globals::fog_filter ) XGLState::enable( GL_FOG );
     
     // check global flag
     if( Globals::fog )
@@ -223,12 +255,12 @@ void initialize_graphics()
         // fog mode
         glFogi(GL_FOG_MODE, Globals::fog_mode[Globals::fog_filter]);
         // enable
-        glEnable(GL_FOG);
+        XGLState::enable( GL_FOG );
     }
     else
     {
         // disable
-        glDisable(GL_FOG);
+        XGLState::disable( GL_FOG );
     }
     
     // clear the color buffer once
@@ -247,15 +279,20 @@ void initialize_simulation()
     // instantiate simulation
     Globals::sim = new THEREMAXSim();
     
-    vector<THEREMAXFlock *> flockVector;
+    // pick up where a previous run left off (the snapshot decides the
+    // flocks; nothing to build first)
+    bool restored = Globals::snapshotRestore &&
+        theremax_snapshot_load( Globals::sim, Globals::snapshotPath.c_str() );
     
-    for (int i = 0; i < 2000; i++)
-    {
-        THEREMAXFlock * flock = new THEREMAXFlock;
-        flock->init(10);
-        flock->loc.set(0.,3.,0.);
-        Globals::sim->root().addChild(flock);
-    }
+    // flocks at (0, 3, 0), from the sim's pools
+    THEREMAXPopulation & population = Globals::sim->population();
+    for (int i = 0; !restored && i < 2000; i++)
+        population.spawnFlock(10);
+    
+    // particles with the music, from below the flocks
+    THEREMAXAudioEmitter * emitter = new THEREMAXAudioEmitter();
+    emitter->loc.set( 0, 1, 0 );
+    Globals::sim->setEmitter( emitter );
 }
 
 
@@ -306,6 +343,16 @@ void theremax_keys()
     fprintf( stderr, "  'h' - print this help message\n" );
     fprintf( stderr, "  's' - toggle fullscreen\n" );
     fprintf( stderr, "  'f' - toggle fog rendering\n" );
+    fprintf( stderr, "  'w' - write simulation snapshot\n" );
+    fprintf( stderr, "  'v' - toggle batched spark rendering\n" );
+    fprintf( stderr, "  'x' - toggle back to front (depth sorted) batched sparks\n" );
+    fprintf( stderr, "  'c' - toggle frustum culling\n" );
+    fprintf( stderr, "  'j' - print frame pacing / jitter / memory\n" );
+    fprintf( stderr, "  'p' - toggle performance overlay\n" );
+    fprintf( stderr, "  'd' - toggle dynamic resolution\n" );
+    fprintf( stderr, "  'e' - toggle flock population following cv\n" );
+    fprintf( stderr, "  'o' - start / stop profiling entity types (writes a report)\n" );
+    fprintf( stderr, "  'k' - toggle particles following the audio bands\n" );
     fprintf( stderr, "  '[' and ']' - rotate automaton\n" );
     fprintf( stderr, "  '-' and '+' - zoom away/closer to center of automaton\n" );
     // fprintf( stderr, "  'n' and 'm' - adjust amount of blending\n" );
@@ -344,7 +391,9 @@ void theremax_usage()
     fprintf( stderr, "[theremax]: command line arguments\n" );
     theremax_line();
     fprintf( stderr, "usage: theremax --[options] [name]\n" );
-    fprintf( stderr, "   [options] = help | fullscreen" );
+    fprintf( stderr, "   [options] = help | fullscreen | snapshot <file> |\n" );
+    fprintf( stderr, "               offscreen <frames> | dump-frames <dir> |\n" );
+    fprintf( stderr, "               single-thread\n" );
 }
 
 
@@ -382,6 +431,8 @@ void reshapeFunc( int w, int h )
 {
     // save the new window size
     Globals::windowWidth = w; Globals::windowHeight = h;
+    // the scene's framebuffer follows
+    if( Globals::resolution ) Globals::resolution->resize( w, h );
     // map the view port to the client area
     glViewport( 0, 0, w, h );
     // set the matrix mode to project
@@ -417,12 +468,18 @@ void look( )
     glMatrixMode( GL_MODELVIEW );
     // load the identity matrix
     glLoadIdentity();
+    // the view point
+    Vector3D eye( 0.0f,
+                  Globals::viewRadius.x * sin( Globals::viewEyeY.x ),
+                  Globals::viewRadius.x * cos( Globals::viewEyeY.x ) );
     // position the view point
-    gluLookAt( 0.0f,
-              Globals::viewRadius.x * sin( Globals::viewEyeY.x ),
-              Globals::viewRadius.x * cos( Globals::viewEyeY.x ),
+    gluLookAt( eye.x, eye.y, eye.z,
               0.0f, 0.0f, 0.0f,
               0.0f, ( cos( Globals::viewEyeY.x ) < 0 ? -1.0f : 1.0f ), 0.0f );
+    // simulation detail follows the camera (the sim thread picks it up
+    // from the camera handed over in displayFrame)
+    g_eye = eye;
+    if( Globals::sim && !theremax_sim_thread_running() ) Globals::sim->setViewpoint( eye );
     
     // set the position of the lights
     glLightfv( GL_LIGHT0, GL_POSITION, Globals::light0_pos );
@@ -443,6 +500,7 @@ void keyboardFunc( unsigned char key, int x, int y )
     {
         case 'q':
         {
+            theremax_sim_thread_stop();
             theremax_cv_thread_stop();
             exit( 0 );
             break;
@@ -495,12 +553,12 @@ void keyboardFunc( unsigned char key, int x, int y )
                 // fog mode
                 glFogi( GL_FOG_MODE, Globals::fog_mode[Globals::fog_filter] );
                 // enable
-                glEnable( GL_FOG );
+                XGLState::enable( GL_FOG );
             }
             else
             {
                 // disable
-                glDisable( GL_FOG );
+                XGLState::disable( GL_FOG );
             }
             break;
         }
@@ -545,6 +603,137 @@ void keyboardFunc( unsigned char key, int x, int y )
             fprintf( stderr, "[theremax]: fullscreen:%s\n", Globals::fullscreen ? "ON" : "OFF" );
             break;
         }
+        case 'j':
+        {
+            if( Globals::pacer ) Globals::pacer->report();
+            theremax_sim_thread_report();
+            if( Globals::resolution ) Globals::resolution->report();
+            fprintf( stderr, "[theremax]: last frame gl state calls issued:%lu skipped:%lu%s\n",
+                     XGLState::numIssued(), XGLState::numSkipped(),
+                     XGLState::caching() ? "" : " (cache off)" );
+            YSlab::report();
+            break;
+        }
+        case 'p':
+        {
+            Globals::showHud = !Globals::showHud;
+            fprintf( stderr, "[theremax]: performance overlay:%s\n", Globals::showHud ? "ON" : "OFF" );
+            break;
+        }
+        case 'd':
+        {
+            if( !Globals::resolution ) break;
+            Globals::resolution->setEnabled( !Globals::resolution->enabled() );
+            fprintf( stderr, "[theremax]: dynamic resolution:%s\n",
+                     Globals::resolution->enabled() ? "ON" : "OFF" );
+            break;
+        }
+        case 'c':
+        {
+            if( Globals::frustumCull && Globals::sim )
+            {
+                theremax_sim_thread_lock();
+                YDrawList & list = Globals::sim->drawList();
+                fprintf( stderr, "[theremax]: last frame culled %lu of %lu nodes (%lu tests)\n",
+                         (unsigned long)list.numCulled(),
+                         (unsigned long)( list.numCulled() + list.numNodes() ),
+                         (unsigned long)list.numCullTests() );
+                theremax_sim_thread_unlock();
+            }
+            Globals::frustumCull = !Globals::frustumCull;
+            fprintf( stderr, "[theremax]: frustum culling:%s\n", Globals::frustumCull ? "ON" : "OFF" );
+            break;
+        }
+        case 'e':
+        {
+            if( !Globals::sim ) break;
+            theremax_sim_thread_lock();
+            THEREMAXPopulation & population = Globals::sim->population();
+            population.following = !population.following;
+            fprintf( stderr, "[theremax]: population follows cv:%s\n", population.following ? "ON" : "OFF" );
+            population.report();
+            theremax_sim_thread_unlock();
+            break;
+        }
+        case 'k':
+        {
+            if( !Globals::sim || !Globals::sim->emitter() ) break;
+            theremax_sim_thread_lock();
+            THEREMAXAudioEmitter * emitter = Globals::sim->emitter();
+            emitter->following = !emitter->following;
+            // (stops emitting; the live ones run out)
+            if( !emitter->following )
+            {
+                SAMPLE silence[THEREMAX_AUDIO_BANDS] = { 0 };
+                emitter->follow( silence );
+            }
+            fprintf( stderr, "[theremax]: particles follow audio:%s\n", emitter->following ? "ON" : "OFF" );
+            emitter->report();
+            theremax_sim_thread_unlock();
+            if( Globals::analysis ) Globals::analysis->report();
+            break;
+        }
+        case 'o':
+        {
+            if( !Globals::sim ) break;
+            theremax_sim_thread_lock();
+            THEREMAXSim * sim = Globals::sim;
+            sim->setProfiling( !sim->profiling() );
+            fprintf( stderr, "[theremax]: profiling:%s\n", sim->profiling() ? "ON" : "OFF" );
+            // what the frames since 'o' cost
+            if( !sim->profiling() )
+            {
+                sim->profiler().census( sim->root() );
+                sim->profiler().report();
+                if( sim->profiler().save( Globals::profilePath.c_str() ) )
+                    fprintf( stderr, "[theremax]: profile written to %s\n", Globals::profilePath.c_str() );
+            }
+            theremax_sim_thread_unlock();
+            break;
+        }
+        case 'v':
+        {
+            Globals::sparkBatch = !Globals::sparkBatch;
+            fprintf( stderr, "[theremax]: spark batch:%s\n", Globals::sparkBatch ? "ON" : "OFF" );
+            if( Globals::sparkBatch && Globals::sim )
+            {
+                // (collect runs in publish on the sim thread)
+                theremax_sim_thread_lock();
+                THEREMAXSparkBatch & batch = Globals::sim->sparkBatch();
+                fprintf( stderr, "[theremax]: last batch %lu sparks, collect:%.2fms (sort:%.2fms) draw:%.2fms\n",
+                         (unsigned long)batch.numSparks(), batch.collectTime() * 1000,
+                         batch.sortTime() * 1000, batch.drawTime() * 1000 );
+                theremax_sim_thread_unlock();
+            }
+            break;
+        }
+        case 'x':
+        {
+            Globals::sparkSort = !Globals::sparkSort;
+            fprintf( stderr, "[theremax]: sorted sparks:%s%s\n", Globals::sparkSort ? "ON" : "OFF",
+                     Globals::sparkBatch ? "" : " (needs spark batch, 'v')" );
+            if( Globals::sim )
+            {
+                theremax_sim_thread_lock();
+                THEREMAXSparkBatch & batch = Globals::sim->sparkBatch();
+                fprintf( stderr, "[theremax]: last sort %lu sparks in %d passes, %.3fms\n",
+                         (unsigned long)batch.numSorted(), batch.numSortPasses(),
+                         batch.sortTime() * 1000 );
+                theremax_sim_thread_unlock();
+            }
+            break;
+        }
+        case 'w':
+        {
+            // restore with --snapshot (between updates)
+            if( Globals::sim )
+            {
+                theremax_sim_thread_lock();
+                theremax_snapshot_save( Globals::sim, Globals::snapshotPath.c_str() );
+                theremax_sim_thread_unlock();
+            }
+            break;
+        }
         case '<':
             Globals::fog_density *= .95f;
             fprintf( stderr, "[theremax]: fog density:%f\n", Globals::fog_density );
@@ -697,6 +886,12 @@ void specialFunc( int key, int x, int y )
 //-----------------------------------------------------------------------------
 void idleFunc( )
 {
+    // wait for the next frame, leaving the CPU to audio and cv
+    if( Globals::pacer )
+    {
+        Globals::pacer->setFrameRate( Globals::sim->getDesiredFrameRate() );
+        Globals::pacer->wait();
+    }
     // render the scene
     glutPostRedisplay( );
 }
@@ -710,6 +905,60 @@ void idleFunc( )
 //-----------------------------------------------------------------------------
 void displayFunc( )
 {
+    double updateTime, renderTime;
+    // the frame (simulation on the wall clock), scaled into a framebuffer
+    // when the dynamic resolution has one, to the sim's current rate
+    if( Globals::resolution )
+        Globals::resolution->setTarget( 1000 / Globals::sim->getDesiredFrameRate() );
+    bool scaled = Globals::resolution && Globals::resolution->begin();
+    displayFrame( 0, updateTime, renderTime );
+    if( scaled ) Globals::resolution->end();
+    
+    // present to present when paced, else this frame's work
+    double frame = ( updateTime + renderTime ) * 1000;
+    if( Globals::pacer && Globals::pacer->intervals().count() )
+        frame = Globals::pacer->intervals().last();
+    
+    // performance overlay, in a second pass over the finished frame (at
+    // the window's resolution)
+    if( Globals::hud )
+    {
+        Globals::hud->addFrame( frame, updateTime * 1000, renderTime * 1000 );
+        
+        if( Globals::showHud )
+        {
+            Globals::hud->project();
+            Globals::hud->updateAll( XGfx::delta() );
+            Globals::hud->drawAll();
+            Globals::hud->unproject();
+        }
+    }
+    
+    // swap the buffers
+    glutSwapBuffers();
+    // present-to-present timing
+    if( Globals::pacer ) Globals::pacer->presented();
+    // state call counts
+    XGLState::endFrame();
+    // next frame's scale
+    if( Globals::resolution ) Globals::resolution->frame( frame );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// Name: displayFrame( )
+// Desc: everything displayFunc does but the swap; fixedStep > 0 steps the
+//       simulation by that much instead of by the wall clock; reports the
+//       time spent updating the simulation and everything else (seconds);
+//       with the sim thread running, draws its latest published update
+//       (sparks always batched) and updateTime is that update's cost
+//-----------------------------------------------------------------------------
+void displayFrame( YTimeInterval fixedStep, double & updateTime, double & renderTime )
+{
+    double start = XFun::now();
+    
     // update time
     XGfx::getCurrentTime( TRUE );
     
@@ -717,8 +966,14 @@ void displayFunc( )
     Globals::bgColor.interp( XGfx::delta() );
     Globals::blendAlpha.interp( XGfx::delta() );
     
-    // clear or blend
-    if( Globals::blendScreen && Globals::blendAlpha.value > .0001 )
+    // renders leave their state set: depth writes back on, so the clear
+    // reaches the depth buffer
+    XGLState::depthMask( GL_TRUE );
+    
+    // clear or blend (over the last frame, unless a resized or rescaled
+    // framebuffer doesn't hold it)
+    if( Globals::blendScreen && Globals::blendAlpha.value > .0001 &&
+        !( Globals::resolution && Globals::resolution->stale() ) )
     {
         // clear the depth buffer
         glClear( GL_DEPTH_BUFFER_BIT );
@@ -734,7 +989,11 @@ void displayFunc( )
     }
     
     // enable depth test
-    glEnable( GL_DEPTH_TEST );
+    XGLState::enable( GL_DEPTH_TEST );
+    
+    // sprites, once they're decoded
+    if( Globals::atlas && Globals::atlas->upload() )
+        Globals::sim->sparkBatch().setTexture( Globals::atlas->texture() );
     
     // save state
     glPushMatrix();
@@ -744,21 +1003,140 @@ void displayFunc( )
     Globals::viewRadius.interp( XGfx::delta() );
     look();
     
-    // cascade simulation
-    Globals::sim->systemCascade();
+    double updateHere = 0;
+    if( fixedStep <= 0 && theremax_sim_thread_running() )
+    {
+        // camera for the sim thread's next update
+        XMatrix4 projection, modelview;
+        glGetFloatv( GL_PROJECTION_MATRIX, projection.m );
+        glGetFloatv( GL_MODELVIEW_MATRIX, modelview.m );
+        theremax_sim_thread_camera( projection * modelview, g_eye );
+        // draw its latest complete update (the update ran on another core)
+        const THEREMAXRenderState * state = theremax_sim_thread_acquire();
+        if( state ) Globals::sim->render( *state );
+        updateTime = state ? state->updateTime : 0;
+    }
+    else
+    {
+        // cascade simulation (as systemCascade, timing the update)
+        double updateStart = XFun::now();
+        if( fixedStep > 0 ) Globals::sim->step( fixedStep );
+        else Globals::sim->systemUpdate();
+        updateTime = updateHere = XFun::now() - updateStart;
+        Globals::sim->systemRender();
+    }
     
     // pop state
     glPopMatrix();
     
-    //    // draw any HUD here
-    //    Globals::hud->project();
-    //    Globals::hud->updateAll( Globals::sim->delta() );
-    //    Globals::hud->drawAll();
-    
     // flush gl commands
     glFlush();
-    // swap the buffers
-    glutSwapBuffers();
+    
+    renderTime = XFun::now() - start - updateHere;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: gfx_dump_frame()
+// desc: write the current color buffer as a binary PPM
+//-----------------------------------------------------------------------------
+static bool gfx_dump_frame( const char * dir, long frame, vector<unsigned char> & pixels )
+{
+    GLsizei w = Globals::windowWidth, h = Globals::windowHeight;
+    pixels.resize( (size_t)w * h * 3 );
+    glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+    glReadPixels( 0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0] );
+    
+    char path[1024];
+    snprintf( path, sizeof(path), "%s/frame-%05ld.ppm", dir, frame );
+    FILE * file = fopen( path, "wb" );
+    if( !file )
+    {
+        fprintf( stderr, "[theremax]: cannot write '%s'\n", path );
+        return false;
+    }
+    fprintf( file, "P6\n%d %d\n255\n", (int)w, (int)h );
+    // GL rows go bottom up
+    for( GLsizei y = h - 1; y >= 0; y-- )
+        fwrite( &pixels[(size_t)y * w * 3], 1, (size_t)w * 3, file );
+    fclose( file );
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: theremax_gfx_offscreen( )
+// desc: render frames into a pbuffer (no window, no display server) and
+//       report frame time percentiles; optionally dump frames to dumpDir
+//-----------------------------------------------------------------------------
+bool theremax_gfx_offscreen( long frames, const char * dumpDir )
+{
+    // print about
+    theremax_about();
+    theremax_endline();
+    
+    if( !theremax_offscreen_init( Globals::windowWidth, Globals::windowHeight ) )
+        return false;
+    fprintf( stderr, "[theremax]: offscreen %dx%d on %s\n", (int)Globals::windowWidth,
+             (int)Globals::windowHeight, (const char *)glGetString( GL_RENDERER ) );
+    
+    // as theremax_gfx_init
+    initialize_graphics();
+    initialize_simulation();
+    if( !initialize_data() )
+    {
+        theremax_offscreen_shutdown();
+        return false;
+    }
+    reshapeFunc( Globals::windowWidth, Globals::windowHeight );
+    // every frame textured, so dumps are reproducible
+    Globals::atlas->finish();
+    
+    // steady timestep, so runs are comparable however slow the renderer
+    YTimeInterval step = 1.0 / Globals::sim->getDesiredFrameRate();
+    THEREMAXStats update( frames ), render( frames ), total( frames );
+    THEREMAXStats issued( frames ), skipped( frames );
+    vector<unsigned char> pixels;
+    
+    for( long f = 0; f < frames; f++ )
+    {
+        double updateTime, renderTime;
+        displayFrame( step, updateTime, renderTime );
+        // count the rasterizer (llvmpipe runs on the CPU)
+        double finishStart = XFun::now();
+        glFinish();
+        renderTime += XFun::now() - finishStart;
+        
+        update.add( updateTime * 1000 );
+        render.add( renderTime * 1000 );
+        total.add( ( updateTime + renderTime ) * 1000 );
+        
+        if( dumpDir && !gfx_dump_frame( dumpDir, f, pixels ) ) dumpDir = NULL;
+        theremax_offscreen_swap();
+        XGLState::endFrame();
+        issued.add( XGLState::numIssued() );
+        skipped.add( XGLState::numSkipped() );
+    }
+    
+    // report
+    THEREMAXStats * stats[] = { &update, &render, &total };
+    const char * names[] = { "update", "render", "frame" };
+    fprintf( stderr, "[theremax]: %ld frames (ms)       p50      p90      p99      max     mean\n", frames );
+    for( int i = 0; i < 3; i++ )
+        fprintf( stderr, "[theremax]:   %-14s %8.3f %8.3f %8.3f %8.3f %8.3f\n", names[i],
+                 stats[i]->percentile( 50 ), stats[i]->percentile( 90 ),
+                 stats[i]->percentile( 99 ), stats[i]->max(), stats[i]->mean() );
+    fprintf( stderr, "[theremax]: gl state calls per frame issued:%.1f skipped:%.1f%s\n",
+             issued.mean(), skipped.mean(), XGLState::caching() ? "" : " (cache off)" );
+    
+    Globals::sim->sparkBatch().cleanup();
+    Globals::atlas->cleanup();
+    theremax_offscreen_shutdown();
+    return true;
 }
 
 
@@ -771,12 +1149,14 @@ void displayFunc( )
 void blendPane()
 {
     // enable blending
-    glEnable( GL_BLEND );
-    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    XGLState::enable( GL_BLEND );
+    XGLState::blendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
     // disable lighting
-    glDisable( GL_LIGHTING );
+    XGLState::disable( GL_LIGHTING );
     // disable depth test
-    glDisable( GL_DEPTH_TEST );
+    XGLState::disable( GL_DEPTH_TEST );
+    // untextured (sprites leave texturing on)
+    XGLState::disable( GL_TEXTURE_2D );
     // blend in a polygon
     glColor4f( Globals::bgColor.actual().x, Globals::bgColor.actual().y, Globals::bgColor.actual().z, Globals::blendAlpha.value );
     // glColor4f( Globals::blendRed, Globals::blendRed, Globals::blendRed, Globals::blendAlpha );
@@ -796,11 +1176,11 @@ void blendPane()
     glEnd();
     
     // enable lighting
-    glEnable( GL_LIGHTING );
+    XGLState::enable( GL_LIGHTING );
     // enable depth test
-    glEnable( GL_DEPTH_TEST );
+    XGLState::enable( GL_DEPTH_TEST );
     // disable blending
-    glDisable( GL_BLEND );
+    XGLState::disable( GL_BLEND );
 }
 
 
@@ -18,6 +18,8 @@
 // entry point for graphics
 bool theremax_gfx_init( int argc, const char ** argv );
 void theremax_gfx_loop();
+// render frames without a window (EGL pbuffer), report timing, and return
+bool theremax_gfx_offscreen( long frames, const char * dumpDir = NULL );
 void theremax_about();
 void theremax_keys();
 void theremax_help();
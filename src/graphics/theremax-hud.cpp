@@ -0,0 +1,487 @@
+//-----------------------------------------------------------------------------
+// name: theremax-hud.cpp
+// desc: performance overlay -- rolling charts and min/avg/p99 readouts of
+//       frame, sim, render, audio and cv timing, drawn over the scene
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-hud.h"
+#include "theremax-globals.h"
+#include <stdio.h>
+#include <math.h>
+using namespace std;
+
+
+
+
+// samples kept per row
+#define HUD_WINDOW 600
+// readouts refresh this often (seconds)
+#define HUD_REFRESH .25
+// layout (window pixels)
+#define HUD_MARGIN 10
+#define HUD_WIDTH 480
+#define HUD_ROW_HEIGHT 44
+#define HUD_CHART_WIDTH 200
+#define HUD_CHART_HEIGHT 32
+#define HUD_HISTOGRAM_BINS 20
+#define HUD_HISTOGRAM_HEIGHT 60
+// of each bin's width the bar takes
+#define HUD_BAR_FILL .985f
+// stroke font scale (about 9 pixel capitals)
+#define HUD_TEXT_SIZE 80
+// bar counts (a little smaller)
+#define HUD_COUNT_SIZE 64
+// initial feedback buffer for the text capture (floats; grows on overflow)
+#define HUD_FEEDBACK 65536
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXHudRow()
+// desc: range is where the chart tops out unless samples go higher; rate
+//       rows (higher is better) read out the 1st percentile instead of p99
+//-----------------------------------------------------------------------------
+THEREMAXHudRow::THEREMAXHudRow( const string & name, const Vector3D & color,
+                                GLfloat range, bool rate, THEREMAXStatsFeed * feed )
+    : m_stats( HUD_WINDOW )
+{
+    m_feed = feed;
+    m_range = range;
+    m_rate = rate;
+    m_name = name;
+
+    // chart
+    m_chart.init( HUD_CHART_WIDTH, HUD_CHART_HEIGHT );
+    m_chart.setCapacity( HUD_WINDOW );
+    m_chart.viewY( 0, range, 0 );
+    m_chart.loc.set( HUD_MARGIN, 6, 0 );
+    m_chart.col = color;
+
+    // text to the right of it
+    m_label.set( name );
+    m_label.sca.set( HUD_TEXT_SIZE, HUD_TEXT_SIZE, HUD_TEXT_SIZE );
+    m_label.loc.set( 2 * HUD_MARGIN + HUD_CHART_WIDTH, 24, 0 );
+    m_label.col = color;
+    m_readout.set( "--" );
+    m_readout.sca.set( HUD_TEXT_SIZE, HUD_TEXT_SIZE, HUD_TEXT_SIZE );
+    m_readout.loc.set( 2 * HUD_MARGIN + HUD_CHART_WIDTH, 8, 0 );
+    m_readout.col = Globals::ourWhite;
+
+    // add (the text is the HUD's to draw)
+    this->addChild( &m_chart );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: add()
+// desc: add a sample (x on the chart is the sample count)
+//-----------------------------------------------------------------------------
+void THEREMAXHudRow::add( double value )
+{
+    m_stats.add( value );
+    GLfloat x = (GLfloat)m_stats.total();
+    m_chart.addValue( x, (GLfloat)value );
+    m_chart.viewX( x - HUD_WINDOW, x, 0 );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: drain()
+// desc: pick up samples from the feed, if any
+//-----------------------------------------------------------------------------
+void THEREMAXHudRow::drain()
+{
+    if( !m_feed ) return;
+
+    // through the window, so the chart sees each sample
+    size_t before = m_stats.total();
+    size_t count = m_feed->drain( m_stats );
+    for( size_t i = 0; i < count; i++ )
+    {
+        GLfloat x = (GLfloat)( before + i + 1 );
+        m_chart.addValue( x, (GLfloat)m_stats.at( m_stats.count() - count + i ) );
+    }
+    if( count )
+    {
+        GLfloat x = (GLfloat)m_stats.total();
+        m_chart.viewX( x - HUD_WINDOW, x, 0 );
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: refresh()
+// desc: readout and chart range from the window
+//-----------------------------------------------------------------------------
+void THEREMAXHudRow::refresh()
+{
+    if( m_stats.count() == 0 )
+    {
+        m_readout.set( "--" );
+        return;
+    }
+
+    snprintf( m_buffer, sizeof(m_buffer), "min %.1f  avg %.1f  %s %.1f",
+              m_stats.min(), m_stats.mean(), m_rate ? "p1" : "p99",
+              m_stats.percentile( m_rate ? 1 : 99 ) );
+    m_readout.set( m_buffer );
+
+    // grow to fit spikes, shrink back once they leave the window
+    GLfloat top = (GLfloat)m_stats.max() * 1.1f;
+    m_chart.viewY( 0, top > m_range ? top : m_range, 4 );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXHud()
+// desc: constructor
+//-----------------------------------------------------------------------------
+THEREMAXHud::THEREMAXHud()
+{
+    // what's plotted (top to bottom)
+    m_frame = new THEREMAXHudRow( "frame ms", Globals::ourWhite, 100 / 3.0f, false, NULL );
+    m_sim = new THEREMAXHudRow( "sim ms", Globals::ourGreen, 8, false, NULL );
+    m_render = new THEREMAXHudRow( "render ms", Globals::ourBlue, 100 / 6.0f, false, NULL );
+    m_rows.push_back( m_frame );
+    m_rows.push_back( m_sim );
+    m_rows.push_back( m_render );
+    m_rows.push_back( new THEREMAXHudRow( "audio load %", Globals::ourOrange, 100, false, &Globals::perfAudioLoad ) );
+    m_rows.push_back( new THEREMAXHudRow( "cv fps", Globals::ourYellow, 30, true, &Globals::perfCvRate ) );
+    m_rows.push_back( new THEREMAXHudRow( "cv->audio ms", Globals::ourRed, 100, false, &Globals::perfCvLatency ) );
+
+    // frame time histogram along the bottom, rows stacked above
+    GLfloat histogram = HUD_HISTOGRAM_HEIGHT + 2.5f * HUD_MARGIN;
+    m_width = HUD_WIDTH;
+    m_height = histogram + m_rows.size() * HUD_ROW_HEIGHT + HUD_MARGIN;
+    for( size_t i = 0; i < m_rows.size(); i++ )
+    {
+        m_rows[i]->loc.set( 0, m_height - HUD_MARGIN / 2 - ( i + 1 ) * HUD_ROW_HEIGHT, 0 );
+        this->addChild( m_rows[i] );
+    }
+
+    // (bars and counts are drawn by render())
+    for( long i = 0; i < HUD_HISTOGRAM_BINS; i++ )
+    {
+        YText * count = new YText();
+        count->sca.set( HUD_COUNT_SIZE, HUD_COUNT_SIZE, HUD_COUNT_SIZE );
+        m_counts.push_back( count );
+    }
+    m_histogramRange = 100 / 3.0f;
+    m_histogramLabel.sca.set( HUD_TEXT_SIZE, HUD_TEXT_SIZE, HUD_TEXT_SIZE );
+    m_histogramLabel.loc.set( HUD_MARGIN, HUD_MARGIN / 2, 0 );
+    m_histogramLabel.col = Globals::ourGray * 2;
+
+    m_refresh = 0;
+    m_textStale = true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: ~THEREMAXHud()
+// desc: destructor
+//-----------------------------------------------------------------------------
+THEREMAXHud::~THEREMAXHud()
+{
+    // remove all children (do this first since it sets state on children)
+    this->removeAllChildren();
+    for( size_t i = 0; i < m_rows.size(); i++ )
+        SAFE_DELETE( m_rows[i] );
+    m_rows.clear();
+    for( size_t i = 0; i < m_counts.size(); i++ )
+        SAFE_DELETE( m_counts[i] );
+    m_counts.clear();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: addFrame()
+// desc: this frame's timings (ms); also drains the audio / cv feeds
+//-----------------------------------------------------------------------------
+void THEREMAXHud::addFrame( double frame, double sim, double render )
+{
+    m_frame->add( frame );
+    m_sim->add( sim );
+    m_render->add( render );
+    for( size_t i = 0; i < m_rows.size(); i++ )
+        m_rows[i]->drain();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: project()
+// desc: screen space pass: origin at the bottom left, units are pixels;
+//       saves what it changes for unproject()
+//-----------------------------------------------------------------------------
+void THEREMAXHud::project()
+{
+    // state
+    glPushAttrib( GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT |
+                  GL_LINE_BIT | GL_POLYGON_BIT | GL_DEPTH_BUFFER_BIT );
+    XGLState::disable( GL_DEPTH_TEST );
+    XGLState::disable( GL_LIGHTING );
+    XGLState::disable( GL_FOG );
+    XGLState::disable( GL_TEXTURE_2D );
+    glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+    XGLState::enable( GL_BLEND );
+    XGLState::blendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+
+    // matrices
+    glMatrixMode( GL_PROJECTION );
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho( 0, Globals::windowWidth, 0, Globals::windowHeight, -1, 1 );
+    glMatrixMode( GL_MODELVIEW );
+    glPushMatrix();
+    glLoadIdentity();
+
+    // top left
+    loc.set( HUD_MARGIN, Globals::windowHeight - HUD_MARGIN - m_height, 0 );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: unproject()
+// desc: back to the scene's matrices and state
+//-----------------------------------------------------------------------------
+void THEREMAXHud::unproject()
+{
+    glMatrixMode( GL_PROJECTION );
+    glPopMatrix();
+    glMatrixMode( GL_MODELVIEW );
+    glPopMatrix();
+    glPopAttrib();
+    // (the pop changed state behind the cache)
+    XGLState::invalidate();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: update()
+// desc: readouts a few times a second (the charts follow every sample)
+//-----------------------------------------------------------------------------
+void THEREMAXHud::update( YTimeInterval dt )
+{
+    m_refresh -= dt;
+    if( m_refresh > 0 ) return;
+    m_refresh = HUD_REFRESH;
+
+    for( size_t i = 0; i < m_rows.size(); i++ )
+        m_rows[i]->refresh();
+    refreshHistogram();
+    m_textStale = true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: render()
+// desc: backing panel, histogram bars, then the text and outlines (the
+//       charts draw themselves on top); three draws
+//-----------------------------------------------------------------------------
+void THEREMAXHud::render()
+{
+    GLfloat panel[] = { 0, 0, m_width, 0, 0, m_height, m_width, m_height };
+
+    glColor4f( 0, 0, 0, .6f );
+    XGLState::clientArrays( XGL_VERTEX_ARRAY );
+    glVertexPointer( 2, GL_FLOAT, 0, panel );
+    glDrawArrays( GL_TRIANGLE_STRIP, 0, 4 );
+
+    // bars
+    if( m_bars.size() )
+    {
+        glColor4f( .4f, .6f, .8f, 1 );
+        glVertexPointer( 2, GL_FLOAT, 0, &m_bars[0] );
+        glDrawArrays( GL_TRIANGLES, 0, (GLsizei)( m_bars.size() / 2 ) );
+    }
+
+    // lines, captured again only after a refresh
+    if( m_textStale )
+    {
+        captureText();
+        m_textStale = false;
+    }
+    if( m_lineVertices.empty() ) return;
+
+    glLineWidth( 1 );
+    XGLState::clientArrays( XGL_VERTEX_ARRAY | XGL_COLOR_ARRAY );
+    glVertexPointer( 2, GL_FLOAT, 0, &m_lineVertices[0] );
+    glColorPointer( 4, GL_FLOAT, 0, &m_lineColors[0] );
+    glDrawArrays( GL_LINES, 0, (GLsizei)( m_lineVertices.size() / 2 ) );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: captureText()
+// desc: draws the text in feedback mode, through a viewport and projection
+//       that make window coordinates HUD coordinates, and keeps the lines
+//-----------------------------------------------------------------------------
+void THEREMAXHud::captureText()
+{
+    m_lineVertices.clear();
+    m_lineColors.clear();
+
+    // HUD coordinates in, the same out (nothing clipped)
+    GLint viewport[4];
+    glGetIntegerv( GL_VIEWPORT, viewport );
+    glViewport( 0, 0, (GLsizei)ceilf( m_width ), (GLsizei)ceilf( m_height ) );
+    glMatrixMode( GL_PROJECTION );
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho( 0, ceilf( m_width ), 0, ceilf( m_height ), -1, 1 );
+    glMatrixMode( GL_MODELVIEW );
+    glPushMatrix();
+
+    GLint size = -1;
+    while( size < 0 )
+    {
+        if( m_feedback.empty() )
+            m_feedback.resize( HUD_FEEDBACK );
+        glFeedbackBuffer( (GLsizei)m_feedback.size(), GL_3D_COLOR, &m_feedback[0] );
+        glRenderMode( GL_FEEDBACK );
+        for( size_t i = 0; i < m_rows.size(); i++ )
+        {
+            captureText( m_rows[i]->label(), m_rows[i]->loc );
+            captureText( m_rows[i]->readout(), m_rows[i]->loc );
+        }
+        for( size_t i = 0; i < m_counts.size(); i++ )
+            captureText( *m_counts[i], Vector3D( 0, 0, 0 ) );
+        captureText( m_histogramLabel, Vector3D( 0, 0, 0 ) );
+        // < 0: overflowed, again with more room
+        size = glRenderMode( GL_RENDER );
+        if( size < 0 )
+            m_feedback.resize( m_feedback.size() * 2 );
+    }
+
+    // back
+    glMatrixMode( GL_PROJECTION );
+    glPopMatrix();
+    glMatrixMode( GL_MODELVIEW );
+    glPopMatrix();
+    glViewport( viewport[0], viewport[1], viewport[2], viewport[3] );
+
+    // a token and two vertices (x, y, z, r, g, b, a) per segment; stroke
+    // text is all lines
+    GLint i = 0;
+    while( i + 15 <= size )
+    {
+        GLfloat token = m_feedback[i];
+        if( token != GL_LINE_TOKEN && token != GL_LINE_RESET_TOKEN ) break;
+        for( GLint v = i + 1; v < i + 15; v += 7 )
+        {
+            m_lineVertices.push_back( m_feedback[v] );
+            m_lineVertices.push_back( m_feedback[v + 1] );
+            m_lineColors.insert( m_lineColors.end(), &m_feedback[v + 3], &m_feedback[v + 7] );
+        }
+        i += 15;
+    }
+
+    // outlines, gray
+    m_lineVertices.insert( m_lineVertices.end(), m_outlines.begin(), m_outlines.end() );
+    for( size_t i = 0; i < m_outlines.size() / 2; i++ )
+    {
+        GLfloat gray[] = { .5f, .5f, .5f, 1 };
+        m_lineColors.insert( m_lineColors.end(), gray, gray + 4 );
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: captureText()
+// desc: one text at offset + its loc (HUD text isn't rotated)
+//-----------------------------------------------------------------------------
+void THEREMAXHud::captureText( YText & text, const Vector3D & offset )
+{
+    glLoadIdentity();
+    glTranslatef( offset.x + text.loc.x, offset.y + text.loc.y, 0 );
+    glScalef( text.sca.x, text.sca.y, text.sca.z );
+    glColor4f( text.col.x, text.col.y, text.col.z, text.alpha );
+    text.render();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: refreshHistogram()
+// desc: frame times in the window, binned from 0 to a range that covers
+//       p99 (at least two 60Hz frames); the last bin takes the overflow
+//-----------------------------------------------------------------------------
+void THEREMAXHud::refreshHistogram()
+{
+    const THEREMAXStats & frames = m_frame->stats();
+    long numBins = HUD_HISTOGRAM_BINS;
+    if( frames.count() == 0 ) return;
+
+    // range in steps of 10ms
+    GLfloat range = 100 / 3.0f;
+    GLfloat p99 = (GLfloat)frames.percentile( 99 ) * 1.25f;
+    if( p99 > range ) range = ceilf( p99 / 10 ) * 10;
+    m_histogramRange = range;
+
+    // count
+    int counts[HUD_HISTOGRAM_BINS] = { 0 };
+    for( size_t i = 0; i < frames.count(); i++ )
+    {
+        long b = (long)( frames.at( i ) / range * numBins );
+        if( b < 0 ) b = 0;
+        if( b >= numBins ) b = numBins - 1;
+        counts[b]++;
+    }
+
+    int most = 1;
+    for( long b = 0; b < numBins; b++ )
+        if( counts[b] > most ) most = counts[b];
+
+    // bars, outlines and counts (HUD coordinates)
+    m_bars.clear();
+    m_outlines.clear();
+    GLfloat binWidth = ( HUD_WIDTH - 2 * HUD_MARGIN ) / (GLfloat)numBins;
+    GLfloat barWidth = binWidth * HUD_BAR_FILL;
+    for( long b = 0; b < numBins; b++ )
+    {
+        GLfloat left = HUD_MARGIN + ( b + .5f ) * binWidth - barWidth / 2;
+        GLfloat right = left + barWidth;
+        GLfloat bottom = 2 * HUD_MARGIN;
+        GLfloat top = bottom + HUD_HISTOGRAM_HEIGHT * counts[b] / (GLfloat)most;
+        GLfloat bar[] = { left, bottom, right, bottom, left, top,
+                          left, top, right, bottom, right, top };
+        GLfloat outline[] = { left, bottom, right, bottom, right, bottom, right, top,
+                              right, top, left, top, left, top, left, bottom };
+        m_bars.insert( m_bars.end(), bar, bar + 12 );
+        m_outlines.insert( m_outlines.end(), outline, outline + 16 );
+
+        snprintf( m_buffer, sizeof(m_buffer), "%d", counts[b] );
+        m_counts[b]->set( m_buffer );
+        m_counts[b]->setCenterLocation( Vector3D( left + barWidth / 2, top + barWidth * .3f, 0 ) );
+    }
+
+    snprintf( m_buffer, sizeof(m_buffer), "frame time 0 - %.0f ms", range );
+    m_histogramLabel.set( m_buffer );
+}
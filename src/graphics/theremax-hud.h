@@ -0,0 +1,122 @@
+//-----------------------------------------------------------------------------
+// name: theremax-hud.h
+// desc: performance overlay -- rolling charts and min/avg/p99 readouts of
+//       frame, sim, render, audio and cv timing, drawn over the scene
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_HUD_H__
+#define __THEREMAX_HUD_H__
+
+#include "y-charting.h"
+#include "theremax-stats.h"
+#include <vector>
+#include <string>
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class THEREMAXHudRow
+// desc: one measurement: chart of the window, name, readout
+//-----------------------------------------------------------------------------
+class THEREMAXHudRow : public YEntity
+{
+public:
+    THEREMAXHudRow( const std::string & name, const Vector3D & color,
+                    GLfloat range, bool rate, THEREMAXStatsFeed * feed );
+
+public:
+    // add a sample
+    void add( double value );
+    // pick up samples from the feed, if any
+    void drain();
+    // refresh readout and chart range from the window
+    void refresh();
+    // the window
+    const THEREMAXStats & stats() const { return m_stats; }
+    // text (drawn by the HUD, see THEREMAXHud::captureText())
+    YText & label() { return m_label; }
+    YText & readout() { return m_readout; }
+
+protected:
+    THEREMAXStats m_stats;
+    // where samples come from another thread (NULL: add() only)
+    THEREMAXStatsFeed * m_feed;
+    // chart range floor
+    GLfloat m_range;
+    // higher is better (readout shows the low tail instead of p99)
+    bool m_rate;
+    std::string m_name;
+    YLineChart m_chart;
+    YText m_label;
+    YText m_readout;
+    char m_buffer[128];
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class THEREMAXHud
+// desc: call addFrame() every frame (cheap, keeps history while hidden);
+//       to draw: project(), updateAll(), drawAll(), unproject()
+//-----------------------------------------------------------------------------
+class THEREMAXHud : public YEntity
+{
+public:
+    THEREMAXHud();
+    ~THEREMAXHud();
+
+public:
+    // this frame's timings (ms); also drains the audio / cv feeds
+    void addFrame( double frame, double sim, double render );
+    // screen space pass (window pixels, no depth, no lighting)
+    void project();
+    // back to the scene's matrices and state
+    void unproject();
+
+public:
+    void update( YTimeInterval dt );
+    void render();
+
+protected:
+    // frame time distribution
+    void refreshHistogram();
+    // the text as lines in HUD coordinates, drawn in one call with the
+    // outlines until the next refresh (stroke text is a strip per stroke)
+    void captureText();
+    void captureText( YText & text, const Vector3D & offset );
+
+protected:
+    std::vector<THEREMAXHudRow *> m_rows;
+    THEREMAXHudRow * m_frame;
+    THEREMAXHudRow * m_sim;
+    THEREMAXHudRow * m_render;
+    // frame time histogram: bars (triangles) and outlines (lines) in HUD
+    // coordinates and a count over each bar, all rebuilt at refresh
+    std::vector<GLfloat> m_bars;
+    std::vector<GLfloat> m_outlines;
+    std::vector<YText *> m_counts;
+    YText m_histogramLabel;
+    // frame time range of the histogram (ms)
+    GLfloat m_histogramRange;
+    // until the next readout refresh (seconds)
+    YTimeInterval m_refresh;
+    // captured text and the outlines: x, y and r, g, b, a per vertex
+    std::vector<GLfloat> m_lineVertices;
+    std::vector<GLfloat> m_lineColors;
+    // text changed since the capture
+    bool m_textStale;
+    // feedback buffer for the capture
+    std::vector<GLfloat> m_feedback;
+    GLfloat m_width;
+    GLfloat m_height;
+    char m_buffer[64];
+};
+
+
+
+
+#endif
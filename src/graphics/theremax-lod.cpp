@@ -0,0 +1,124 @@
+//-----------------------------------------------------------------------------
+// name: theremax-lod.cpp
+// desc: distance based level of detail for flock simulation
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-lod.h"
+#include <stdio.h>
+using namespace std;
+
+
+
+
+// smoothing for the cost estimates (per update)
+#define LOD_SMOOTHING 0.05
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXFlockLod()
+// desc: constructor
+//-----------------------------------------------------------------------------
+THEREMAXFlockLod::THEREMAXFlockLod()
+{
+    enabled = false;
+    reducedDistance = 15;
+    aggregateDistance = 40;
+    hysteresis = 0.1f;
+    reportInterval = 5;
+    m_evalCost = 0;
+    m_saved = 0;
+    m_reportClock = 0;
+    for( int i = 0; i < THEREMAX_LOD_COUNT; i++ )
+        m_boids[i] = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: choose()
+// desc: level for a distance; moving in needs to get hysteresis closer than
+//       the threshold, moving out needs to get hysteresis farther
+//-----------------------------------------------------------------------------
+THEREMAXLod THEREMAXFlockLod::choose( GLfloat distance, THEREMAXLod current ) const
+{
+    GLfloat in = 1 - hysteresis;
+    GLfloat out = 1 + hysteresis;
+
+    // thresholds biased toward staying at the current level
+    GLfloat reduced = reducedDistance * ( current >= THEREMAX_LOD_REDUCED ? in : out );
+    GLfloat aggregate = aggregateDistance * ( current >= THEREMAX_LOD_AGGREGATE ? in : out );
+
+    if( distance > aggregate ) return THEREMAX_LOD_AGGREGATE;
+    if( distance > reduced ) return THEREMAX_LOD_REDUCED;
+    return THEREMAX_LOD_FULL;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: update()
+// desc: assign levels and update the counters
+//-----------------------------------------------------------------------------
+void THEREMAXFlockLod::update( const vector<THEREMAXFlock *> & flocks, const Vector3D & eye,
+                               YTimeInterval dt, unsigned long ruleEvals, double updateTime )
+{
+    // rule evaluations we would have done at full detail
+    double fullEvals = 0;
+
+    for( int i = 0; i < THEREMAX_LOD_COUNT; i++ )
+        m_boids[i] = 0;
+
+    for( size_t i = 0; i < flocks.size(); i++ )
+    {
+        THEREMAXFlock * flock = flocks[i];
+        THEREMAXLod lod = THEREMAX_LOD_FULL;
+
+        // distance to the sphere (0 inside)
+        if( enabled )
+        {
+            GLfloat distance = (flock->boundCenter - eye).magnitude() - flock->boundRadius;
+            lod = choose( distance > 0 ? distance : 0, flock->getLod() );
+        }
+        flock->setLod( lod );
+
+        size_t boids = flock->boids().size();
+        m_boids[lod] += boids;
+        fullEvals += flock->getRuleRate() > 0 ? boids * flock->getRuleRate() * dt : boids;
+    }
+
+    // what a rule evaluation costs (an upper bound: includes integration)
+    if( ruleEvals > 0 )
+        m_evalCost += ( updateTime / ruleEvals - m_evalCost ) * LOD_SMOOTHING;
+
+    // saved = evaluations skipped, at that cost
+    double skipped = fullEvals - ruleEvals;
+    m_saved += ( ( skipped > 0 ? skipped : 0 ) * m_evalCost - m_saved ) * LOD_SMOOTHING;
+
+    // report
+    m_reportClock += dt;
+    if( enabled && reportInterval > 0 && m_reportClock >= reportInterval )
+    {
+        report();
+        m_reportClock = 0;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: report()
+// desc: print counters
+//-----------------------------------------------------------------------------
+void THEREMAXFlockLod::report() const
+{
+    fprintf( stderr, "[theremax]: lod boids full:%lu reduced:%lu aggregate:%lu saved:%.2fms\n",
+             m_boids[THEREMAX_LOD_FULL], m_boids[THEREMAX_LOD_REDUCED],
+             m_boids[THEREMAX_LOD_AGGREGATE], m_saved * 1000 );
+}
@@ -0,0 +1,71 @@
+//-----------------------------------------------------------------------------
+// name: theremax-lod.h
+// desc: distance based level of detail for flock simulation
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_LOD_H__
+#define __THEREMAX_LOD_H__
+
+#include "theremax-flocking.h"
+#include <vector>
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class THEREMAXFlockLod
+// desc: picks a level of detail for each flock from its distance to the
+//       eye, and keeps count of what that saves
+//-----------------------------------------------------------------------------
+class THEREMAXFlockLod
+{
+public:
+    THEREMAXFlockLod();
+
+public:
+    // assign levels from the eye position (world space); ruleEvals and
+    // updateTime are what the last update actually cost
+    void update( const std::vector<THEREMAXFlock *> & flocks, const Vector3D & eye,
+                 YTimeInterval dt, unsigned long ruleEvals, double updateTime );
+    // print counters to stderr
+    void report() const;
+
+public:
+    // boids at a level (last update)
+    unsigned long boidsAt( THEREMAXLod lod ) const { return m_boids[lod]; }
+    // estimated simulation time saved (seconds, smoothed)
+    double savedTime() const { return m_saved; }
+
+public:
+    // on/off (when off, every flock is at full detail)
+    bool enabled;
+    // distance from the eye to a flock's bounding sphere beyond which...
+    // ...rules run at a reduced rate
+    GLfloat reducedDistance;
+    // ...the flock becomes a single body
+    GLfloat aggregateDistance;
+    // fraction of a distance to move past before switching (no flicker)
+    GLfloat hysteresis;
+    // seconds between reports (0: never)
+    YTimeInterval reportInterval;
+
+protected:
+    // level for a distance, given the current level
+    THEREMAXLod choose( GLfloat distance, THEREMAXLod current ) const;
+
+protected:
+    unsigned long m_boids[THEREMAX_LOD_COUNT];
+    // smoothed cost of one boid rule evaluation
+    double m_evalCost;
+    // smoothed time saved
+    double m_saved;
+    // time since last report
+    YTimeInterval m_reportClock;
+};
+
+
+
+
+#endif
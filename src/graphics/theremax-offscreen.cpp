@@ -0,0 +1,147 @@
+//-----------------------------------------------------------------------------
+// name: theremax-offscreen.cpp
+// desc: windowless GL context (EGL pbuffer) for headless rendering
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-offscreen.h"
+#include <stdio.h>
+
+#ifdef THEREMAX_USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+// the context
+static EGLDisplay g_display = EGL_NO_DISPLAY;
+static EGLSurface g_surface = EGL_NO_SURFACE;
+static EGLContext g_context = EGL_NO_CONTEXT;
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: offscreen_display()
+// desc: default display, else Mesa's surfaceless platform (no X server)
+//-----------------------------------------------------------------------------
+static EGLDisplay offscreen_display()
+{
+    EGLint major, minor;
+    EGLDisplay display = eglGetDisplay( EGL_DEFAULT_DISPLAY );
+    if( display != EGL_NO_DISPLAY && eglInitialize( display, &major, &minor ) )
+        return display;
+
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+    if( getPlatformDisplay )
+    {
+        display = getPlatformDisplay( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL );
+        if( display != EGL_NO_DISPLAY && eglInitialize( display, &major, &minor ) )
+            return display;
+    }
+#endif
+
+    return EGL_NO_DISPLAY;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: theremax_offscreen_init()
+// desc: create a pbuffer and a desktop GL context, make it current
+//-----------------------------------------------------------------------------
+bool theremax_offscreen_init( int width, int height )
+{
+    g_display = offscreen_display();
+    if( g_display == EGL_NO_DISPLAY )
+    {
+        fprintf( stderr, "[theremax]: no EGL display for offscreen rendering\n" );
+        return false;
+    }
+
+    // rgba + depth, like the GLUT window
+    EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if( !eglChooseConfig( g_display, configAttribs, &config, 1, &numConfigs ) || numConfigs < 1 )
+    {
+        fprintf( stderr, "[theremax]: no EGL pbuffer config\n" );
+        theremax_offscreen_shutdown();
+        return false;
+    }
+
+    EGLint surfaceAttribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+    g_surface = eglCreatePbufferSurface( g_display, config, surfaceAttribs );
+    // fixed function, so desktop GL
+    eglBindAPI( EGL_OPENGL_API );
+    g_context = eglCreateContext( g_display, config, EGL_NO_CONTEXT, NULL );
+    if( g_surface == EGL_NO_SURFACE || g_context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent( g_display, g_surface, g_surface, g_context ) )
+    {
+        fprintf( stderr, "[theremax]: cannot create EGL pbuffer context\n" );
+        theremax_offscreen_shutdown();
+        return false;
+    }
+
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: theremax_offscreen_shutdown()
+// desc: release
+//-----------------------------------------------------------------------------
+void theremax_offscreen_shutdown()
+{
+    if( g_display == EGL_NO_DISPLAY ) return;
+    eglMakeCurrent( g_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+    if( g_context != EGL_NO_CONTEXT ) eglDestroyContext( g_display, g_context );
+    if( g_surface != EGL_NO_SURFACE ) eglDestroySurface( g_display, g_surface );
+    eglTerminate( g_display );
+    g_display = EGL_NO_DISPLAY;
+    g_surface = EGL_NO_SURFACE;
+    g_context = EGL_NO_CONTEXT;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: theremax_offscreen_swap()
+// desc: finish the frame
+//-----------------------------------------------------------------------------
+void theremax_offscreen_swap()
+{
+    if( g_display != EGL_NO_DISPLAY ) eglSwapBuffers( g_display, g_surface );
+}
+
+
+
+
+#else
+
+
+
+
+// built without EGL
+bool theremax_offscreen_init( int width, int height )
+{
+    fprintf( stderr, "[theremax]: built without EGL, no offscreen rendering\n" );
+    return false;
+}
+void theremax_offscreen_shutdown() { }
+void theremax_offscreen_swap() { }
+
+
+
+
+#endif
@@ -0,0 +1,24 @@
+//-----------------------------------------------------------------------------
+// name: theremax-offscreen.h
+// desc: windowless GL context (EGL pbuffer) for headless rendering
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_OFFSCREEN_H__
+#define __THEREMAX_OFFSCREEN_H__
+
+
+
+
+// create a width x height pbuffer and make its context current
+bool theremax_offscreen_init( int width, int height );
+// release it
+void theremax_offscreen_shutdown();
+// swap (finishes the frame)
+void theremax_offscreen_swap();
+
+
+
+
+#endif
@@ -0,0 +1,197 @@
+//-----------------------------------------------------------------------------
+// name: theremax-pacer.cpp
+// desc: frame pacing -- swap control when the driver has it, otherwise
+//       sleep until the next frame deadline; measures present intervals
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-pacer.h"
+#include "x-def.h"
+#include "x-fun.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+
+#if defined(__APPLE__)
+  #include <OpenGL/OpenGL.h>
+#elif defined(__linux)
+  #include <GL/glx.h>
+#endif
+
+
+
+
+// wake this long before the deadline and yield the rest (seconds); covers
+// the scheduler's wakeup latency
+#define PACER_SPIN_MARGIN 0.0008
+// more than this many periods late: start over instead of catching up
+#define PACER_MAX_LATE 2
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: pacer_swap_interval()
+// desc: ask the driver to sync swaps to the display (true if it agreed)
+//-----------------------------------------------------------------------------
+static bool pacer_swap_interval( int interval )
+{
+#if defined(__APPLE__)
+    CGLContextObj context = CGLGetCurrentContext();
+    GLint value = interval;
+    return context && CGLSetParameter( context, kCGLCPSwapInterval, &value ) == kCGLNoError;
+#elif defined(__linux)
+    Display * display = glXGetCurrentDisplay();
+    GLXDrawable drawable = glXGetCurrentDrawable();
+    if( !display || !drawable ) return false;
+    const char * extensions = glXQueryExtensionsString( display, DefaultScreen( display ) );
+    if( !extensions ) return false;
+
+    // EXT takes the drawable; MESA and SGI apply to the current one
+    if( strstr( extensions, "GLX_EXT_swap_control" ) )
+    {
+        typedef void (*SwapIntervalEXT)( Display *, GLXDrawable, int );
+        SwapIntervalEXT f = (SwapIntervalEXT)glXGetProcAddressARB( (const GLubyte *)"glXSwapIntervalEXT" );
+        if( f ) { f( display, drawable, interval ); return true; }
+    }
+    if( strstr( extensions, "GLX_MESA_swap_control" ) )
+    {
+        typedef int (*SwapIntervalMESA)( unsigned int );
+        SwapIntervalMESA f = (SwapIntervalMESA)glXGetProcAddressARB( (const GLubyte *)"glXSwapIntervalMESA" );
+        if( f && f( interval ) == 0 ) return true;
+    }
+    if( strstr( extensions, "GLX_SGI_swap_control" ) && interval > 0 )
+    {
+        typedef int (*SwapIntervalSGI)( int );
+        SwapIntervalSGI f = (SwapIntervalSGI)glXGetProcAddressARB( (const GLubyte *)"glXSwapIntervalSGI" );
+        if( f && f( interval ) == 0 ) return true;
+    }
+    return false;
+#else
+    return false;
+#endif
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXFramePacer()
+// desc: constructor
+//-----------------------------------------------------------------------------
+THEREMAXFramePacer::THEREMAXFramePacer()
+    : m_intervals( 600 ), m_jitter( 600 )
+{
+    m_rate = 60;
+    m_swapControl = false;
+    m_deadline = 0;
+    m_lastPresent = 0;
+    m_slept = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: init()
+// desc: try swap control
+//-----------------------------------------------------------------------------
+void THEREMAXFramePacer::init( bool vsync )
+{
+    m_swapControl = vsync && pacer_swap_interval( 1 );
+    m_deadline = 0;
+    fprintf( stderr, "[theremax]: frame pacing: %s\n",
+             m_swapControl ? "swap control (vsync)" : "sleep to deadline" );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: setFrameRate()
+// desc: target rate
+//-----------------------------------------------------------------------------
+void THEREMAXFramePacer::setFrameRate( double rate )
+{
+    if( rate != m_rate ) m_deadline = 0;
+    m_rate = rate;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: wait()
+// desc: sleep most of the way to the deadline, yield the last bit
+//-----------------------------------------------------------------------------
+void THEREMAXFramePacer::wait()
+{
+    m_slept = 0;
+    if( m_swapControl || m_rate <= 0 ) return;
+
+    double period = 1.0 / m_rate;
+    double now = XFun::now();
+
+    // first frame, or too far behind to catch up
+    if( m_deadline == 0 || now - m_deadline > PACER_MAX_LATE * period )
+    {
+        m_deadline = now + period;
+        return;
+    }
+
+    double start = now;
+    double remaining = m_deadline - now;
+    if( remaining > PACER_SPIN_MARGIN )
+    {
+        double sleep = remaining - PACER_SPIN_MARGIN;
+        struct timespec ts;
+        ts.tv_sec = (time_t)sleep;
+        ts.tv_nsec = (long)( ( sleep - ts.tv_sec ) * 1e9 );
+        nanosleep( &ts, NULL );
+    }
+    while( XFun::now() < m_deadline )
+        sched_yield();
+
+    m_slept = XFun::now() - start;
+    // next deadline on the grid (no drift from late wakeups)
+    m_deadline += period;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: presented()
+// desc: record the present-to-present interval
+//-----------------------------------------------------------------------------
+void THEREMAXFramePacer::presented()
+{
+    double now = XFun::now();
+    if( m_lastPresent > 0 )
+    {
+        double interval = ( now - m_lastPresent ) * 1000;
+        m_intervals.add( interval );
+        if( m_rate > 0 ) m_jitter.add( fabs( interval - 1000.0 / m_rate ) );
+    }
+    m_lastPresent = now;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: report()
+// desc: print a summary
+//-----------------------------------------------------------------------------
+void THEREMAXFramePacer::report() const
+{
+    fprintf( stderr, "[theremax]: pacing (%s) target:%.2fms interval p50:%.2f p99:%.2f max:%.2f "
+             "jitter p50:%.2f p99:%.2f (ms, last %lu frames)\n",
+             m_swapControl ? "vsync" : "sleep", m_rate > 0 ? 1000.0 / m_rate : 0,
+             m_intervals.percentile( 50 ), m_intervals.percentile( 99 ), m_intervals.max(),
+             m_jitter.percentile( 50 ), m_jitter.percentile( 99 ),
+             (unsigned long)m_intervals.count() );
+}
@@ -0,0 +1,64 @@
+//-----------------------------------------------------------------------------
+// name: theremax-pacer.h
+// desc: frame pacing -- swap control when the driver has it, otherwise
+//       sleep until the next frame deadline; measures present intervals
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_PACER_H__
+#define __THEREMAX_PACER_H__
+
+#include "theremax-stats.h"
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class THEREMAXFramePacer
+// desc: call wait() before asking for a frame and presented() after the swap
+//-----------------------------------------------------------------------------
+class THEREMAXFramePacer
+{
+public:
+    THEREMAXFramePacer();
+
+public:
+    // try to turn on swap control (needs the current GL context)
+    void init( bool vsync = true );
+    // frames per second to pace to (<= 0: don't pace)
+    void setFrameRate( double rate );
+    double getFrameRate() const { return m_rate; }
+    // block until the next frame is due (no-op with swap control)
+    void wait();
+    // a frame was just presented
+    void presented();
+
+public:
+    // swap control is pacing (else sleeping)
+    bool swapControl() const { return m_swapControl; }
+    // present-to-present intervals (ms)
+    const THEREMAXStats & intervals() const { return m_intervals; }
+    // |interval - frame period| (ms)
+    const THEREMAXStats & jitter() const { return m_jitter; }
+    // time slept in wait(), last frame (seconds)
+    double slept() const { return m_slept; }
+    // print a summary
+    void report() const;
+
+protected:
+    double m_rate;
+    bool m_swapControl;
+    // next frame deadline (0: not started)
+    double m_deadline;
+    // last present (0: none yet)
+    double m_lastPresent;
+    double m_slept;
+    THEREMAXStats m_intervals;
+    THEREMAXStats m_jitter;
+};
+
+
+
+
+#endif
@@ -0,0 +1,252 @@
+//-----------------------------------------------------------------------------
+// name: theremax-population.cpp
+// desc: flocks and boids spawned and despawned at run time from pools of
+//       recycled ones
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-population.h"
+#include "x-fun.h"
+#include <stdio.h>
+using namespace std;
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXPopulation()
+// desc: constructor
+//-----------------------------------------------------------------------------
+THEREMAXPopulation::THEREMAXPopulation()
+{
+    following = false;
+    minFlocks = 500;
+    maxFlocks = 2000;
+    minBoids = 5;
+    maxBoids = 10;
+    maxChanges = 50;
+    origin.set( 0, 3, 0 );
+    m_root = NULL;
+    m_broadphase = NULL;
+    m_wait = 0;
+    m_cursor = 0;
+    m_numSpawned = 0;
+    m_numDespawned = 0;
+    m_numCreated = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: ~THEREMAXPopulation()
+// desc: destructor
+//-----------------------------------------------------------------------------
+THEREMAXPopulation::~THEREMAXPopulation()
+{
+    // (pooled flocks have no boids)
+    for( size_t i = 0; i < m_flockPool.size(); i++ )
+        SAFE_DELETE( m_flockPool[i] );
+    for( size_t i = 0; i < m_boidPool.size(); i++ )
+        SAFE_DELETE( m_boidPool[i] );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: attach()
+// desc: the scene to spawn into
+//-----------------------------------------------------------------------------
+void THEREMAXPopulation::attach( YEntity * root, THEREMAXFlockBroadphase * broadphase )
+{
+    m_root = root;
+    m_broadphase = broadphase;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: reserve()
+// desc: pool enough that flocks x boids exist
+//-----------------------------------------------------------------------------
+void THEREMAXPopulation::reserve( size_t flocks, size_t boids )
+{
+    // what the scene has
+    size_t liveBoids = 0;
+    const vector<THEREMAXFlock *> & live = m_broadphase->flocks();
+    for( size_t i = 0; i < live.size(); i++ )
+        liveBoids += live[i]->boids().size();
+
+    while( live.size() + m_flockPool.size() < flocks )
+    {
+        m_flockPool.push_back( new THEREMAXFlock );
+        m_numCreated++;
+    }
+    while( liveBoids + m_boidPool.size() < flocks * boids )
+    {
+        m_boidPool.push_back( new THEREMAXBoid );
+        m_numCreated++;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: spawnFlock()
+// desc: a reset flock of count boids, into the root and broadphase
+//-----------------------------------------------------------------------------
+THEREMAXFlock * THEREMAXPopulation::spawnFlock( int count )
+{
+    THEREMAXFlock * flock = NULL;
+    if( m_flockPool.size() )
+    {
+        flock = m_flockPool.back();
+        m_flockPool.pop_back();
+        flock->reset();
+    }
+    else
+    {
+        flock = new THEREMAXFlock;
+        m_numCreated++;
+    }
+
+    setBoids( flock, count );
+    flock->loc = origin;
+    m_root->addChild( flock );
+    m_broadphase->add( flock );
+    m_numSpawned++;
+    return flock;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: despawnFlock()
+// desc: out of the root and broadphase, into the pool
+//-----------------------------------------------------------------------------
+void THEREMAXPopulation::despawnFlock( THEREMAXFlock * flock )
+{
+    m_broadphase->remove( flock );
+    m_root->swapRemoveChild( flock );
+    setBoids( flock, 0 );
+    m_flockPool.push_back( flock );
+    m_numDespawned++;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: setBoids()
+// desc: grow from the pool, or shrink into it from the end
+//-----------------------------------------------------------------------------
+void THEREMAXPopulation::setBoids( THEREMAXFlock * flock, int count )
+{
+    if( count < 0 ) count = 0;
+
+    // grow
+    while( (int)flock->boids().size() < count )
+    {
+        THEREMAXBoid * boid = takeBoid();
+        boid->loc.set( XFun::rand2f( -1.0, 1.0 ), XFun::rand2f( -1.0, 1.0 ), XFun::rand2f( -1.0, 1.0 ) );
+        // joins an aggregated flock where it stands
+        if( flock->getLod() == THEREMAX_LOD_AGGREGATE )
+            boid->lodOffset = boid->loc - flock->aggregateCenter();
+        flock->addChild( boid );
+    }
+
+    // shrink
+    while( (int)flock->boids().size() > count )
+    {
+        THEREMAXBoid * boid = (THEREMAXBoid *)flock->boids().back();
+        flock->swapRemoveChild( boid );
+        m_boidPool.push_back( boid );
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: takeBoid()
+// desc: a reset boid from the pool, else a new one
+//-----------------------------------------------------------------------------
+THEREMAXBoid * THEREMAXPopulation::takeBoid()
+{
+    if( m_boidPool.empty() )
+    {
+        m_numCreated++;
+        return new THEREMAXBoid;
+    }
+
+    THEREMAXBoid * boid = m_boidPool.back();
+    m_boidPool.pop_back();
+    boid->reset();
+    return boid;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: follow()
+// desc: step the population toward what energy asks for
+//-----------------------------------------------------------------------------
+void THEREMAXPopulation::follow( GLfloat energy, YTimeInterval dt )
+{
+    // not yet
+    m_wait -= dt;
+    if( m_wait > 0 ) return;
+    m_wait += THEREMAX_POPULATION_PERIOD;
+    if( m_wait < 0 ) m_wait = 0;
+
+    // targets
+    if( energy < 0 ) energy = 0;
+    if( energy > 1 ) energy = 1;
+    size_t flocks = minFlocks + (size_t)( energy * ( maxFlocks - minFlocks ) + .5f );
+    int boids = minBoids + (int)( energy * ( maxBoids - minBoids ) + .5f );
+
+    // flocks (newest first out)
+    size_t changes = 0;
+    while( numFlocks() < flocks && changes < maxChanges )
+    {
+        spawnFlock( boids );
+        changes++;
+    }
+    while( numFlocks() > flocks && changes < maxChanges )
+    {
+        despawnFlock( m_broadphase->flocks().back() );
+        changes++;
+    }
+
+    // boids, a few flocks at a time
+    const vector<THEREMAXFlock *> & live = m_broadphase->flocks();
+    for( size_t i = 0; i < live.size() && changes < maxChanges; i++ )
+    {
+        if( m_cursor >= live.size() ) m_cursor = 0;
+        THEREMAXFlock * flock = live[m_cursor++];
+        if( (int)flock->boids().size() == boids ) continue;
+        setBoids( flock, boids );
+        changes++;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: report()
+// desc: print the pools and counts
+//-----------------------------------------------------------------------------
+void THEREMAXPopulation::report() const
+{
+    fprintf( stderr, "[theremax]: population %lu flocks%s, pooled %lu flocks %lu boids, "
+             "spawned %lu despawned %lu, created %lu\n", (unsigned long)numFlocks(),
+             following ? " (following cv)" : "", (unsigned long)m_flockPool.size(),
+             (unsigned long)m_boidPool.size(), m_numSpawned, m_numDespawned, m_numCreated );
+}
@@ -0,0 +1,104 @@
+//-----------------------------------------------------------------------------
+// name: theremax-population.h
+// desc: flocks and boids spawned and despawned at run time from pools of
+//       recycled ones -- no allocation once the pools have grown to the
+//       largest population seen
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_POPULATION_H__
+#define __THEREMAX_POPULATION_H__
+
+#include "theremax-broadphase.h"
+#include <vector>
+
+// seconds between follow() adjustments (each one re-gathers the update pass)
+#define THEREMAX_POPULATION_PERIOD 0.25
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class THEREMAXPopulation
+// desc: the flocks in a sim's root and broadphase. Despawned flocks and
+//       boids go to free lists and come back reset; removal is constant
+//       time (swap with the last flock / boid), so the order of flocks in
+//       the scene changes. Sim thread only (or with it stopped)
+//-----------------------------------------------------------------------------
+class THEREMAXPopulation
+{
+public:
+    THEREMAXPopulation();
+    // deletes the pooled flocks and boids (not those in the scene)
+    ~THEREMAXPopulation();
+
+public:
+    // the scene to spawn into
+    void attach( YEntity * root, THEREMAXFlockBroadphase * broadphase );
+    // pool enough that flocks x boids (in the scene and pooled) exist
+    void reserve( size_t flocks, size_t boids );
+
+public:
+    // a flock of count boids at origin, into the scene
+    THEREMAXFlock * spawnFlock( int count );
+    // out of the scene, it and its boids into the pools
+    void despawnFlock( THEREMAXFlock * flock );
+    // grow (randomly placed, as THEREMAXFlock::init) or shrink from the end
+    void setBoids( THEREMAXFlock * flock, int count );
+    // flocks in the scene
+    size_t numFlocks() const { return m_broadphase ? m_broadphase->size() : 0; }
+
+public:
+    // move toward minFlocks + energy * ( maxFlocks - minFlocks ) flocks of
+    // minBoids + energy * ( maxBoids - minBoids ) boids (energy in [0, 1]),
+    // every THEREMAX_POPULATION_PERIOD seconds, spawning, despawning or
+    // resizing at most maxChanges flocks each time
+    void follow( GLfloat energy, YTimeInterval dt );
+    // print the pools and counts
+    void report() const;
+
+public:
+    // pooled flocks / boids
+    size_t numPooledFlocks() const { return m_flockPool.size(); }
+    size_t numPooledBoids() const { return m_boidPool.size(); }
+    // spawned / despawned flocks, and flocks + boids made with new
+    unsigned long numSpawned() const { return m_numSpawned; }
+    unsigned long numDespawned() const { return m_numDespawned; }
+    unsigned long numCreated() const { return m_numCreated; }
+
+public:
+    // THEREMAXSim::step calls follow() with Globals::cvIntensity
+    bool following;
+    size_t minFlocks;
+    size_t maxFlocks;
+    int minBoids;
+    int maxBoids;
+    size_t maxChanges;
+    // where flocks spawn (parent space)
+    Vector3D origin;
+
+protected:
+    // a boid from the pool, else a new one
+    THEREMAXBoid * takeBoid();
+
+protected:
+    YEntity * m_root;
+    THEREMAXFlockBroadphase * m_broadphase;
+    // free lists
+    std::vector<THEREMAXFlock *> m_flockPool;
+    std::vector<THEREMAXBoid *> m_boidPool;
+    // time to the next follow() adjustment
+    YTimeInterval m_wait;
+    // next flock follow() looks at for resizing
+    size_t m_cursor;
+    // stats
+    unsigned long m_numSpawned;
+    unsigned long m_numDespawned;
+    unsigned long m_numCreated;
+};
+
+
+
+
+#endif
@@ -0,0 +1,131 @@
+//-----------------------------------------------------------------------------
+// name: theremax-render-state.cpp
+// desc: what the simulation publishes for drawing, triple buffered between
+//       the sim thread (writer) and the GL thread (reader)
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-render-state.h"
+#include <algorithm>
+using namespace std;
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: clear()
+// desc: empty, keeping capacity
+//-----------------------------------------------------------------------------
+void THEREMAXRenderState::clear()
+{
+    sparks.clear();
+    sparkIndices.clear();
+    emitters.clear();
+    frame = 0;
+    elapsed = 0;
+    updateTime = 0;
+    publishTime = 0;
+    numNodes = 0;
+    numCulled = 0;
+    numCullTests = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXRenderBuffers()
+// desc: constructor
+//-----------------------------------------------------------------------------
+THEREMAXRenderBuffers::THEREMAXRenderBuffers()
+{
+    m_write = 0;
+    m_ready = 1;
+    m_read = 2;
+    m_fresh = false;
+    m_started = false;
+    m_hasCamera = false;
+    m_numDropped = 0;
+    m_numRepeated = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: publish()
+// desc: the written state becomes the newest; the writer takes the old one
+//-----------------------------------------------------------------------------
+void THEREMAXRenderBuffers::publish()
+{
+    m_mutex.acquire();
+    // the reader never saw the one being replaced
+    if( m_fresh ) m_numDropped++;
+    std::swap( m_write, m_ready );
+    m_fresh = true;
+    m_mutex.release();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: acquire()
+// desc: trade the reader's state for the newest, if there is a newer one
+//-----------------------------------------------------------------------------
+const THEREMAXRenderState * THEREMAXRenderBuffers::acquire()
+{
+    m_mutex.acquire();
+    if( m_fresh )
+    {
+        std::swap( m_read, m_ready );
+        m_fresh = false;
+        m_started = true;
+    }
+    else if( m_started )
+    {
+        // drawing the same update again
+        m_numRepeated++;
+    }
+    bool started = m_started;
+    m_mutex.release();
+
+    return started ? &m_states[m_read] : NULL;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: setCamera()
+// desc: camera for the next update
+//-----------------------------------------------------------------------------
+void THEREMAXRenderBuffers::setCamera( const XMatrix4 & clip, const Vector3D & eye )
+{
+    m_mutex.acquire();
+    m_clip = clip;
+    m_eye = eye;
+    m_hasCamera = true;
+    m_mutex.release();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: getCamera()
+// desc: latest camera
+//-----------------------------------------------------------------------------
+bool THEREMAXRenderBuffers::getCamera( XMatrix4 & clip, Vector3D & eye )
+{
+    m_mutex.acquire();
+    bool has = m_hasCamera;
+    if( has )
+    {
+        clip = m_clip;
+        eye = m_eye;
+    }
+    m_mutex.release();
+    return has;
+}
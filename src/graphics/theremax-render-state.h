@@ -0,0 +1,107 @@
+//-----------------------------------------------------------------------------
+// name: theremax-render-state.h
+// desc: what the simulation publishes for drawing, triple buffered between
+//       the sim thread (writer) and the GL thread (reader)
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_RENDER_STATE_H__
+#define __THEREMAX_RENDER_STATE_H__
+
+#include "theremax-spark-batch.h"
+#include "x-thread.h"
+#include <vector>
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: struct THEREMAXRenderState
+// desc: one complete frame: sparks and emitter particles as world-space
+//       quads (transforms, colors and alphas baked in); nothing in it points
+//       back into the scene, which the sim thread keeps changing
+//-----------------------------------------------------------------------------
+struct THEREMAXRenderState
+{
+    THEREMAXRenderState() { clear(); }
+    // empty, keeping capacity
+    void clear();
+
+    // the sparks, then the emitters' particles (draw key order)
+    std::vector<THEREMAXSparkVertex> sparks;
+    // back to front order of the spark quads (empty: unsorted)
+    std::vector<GLuint> sparkIndices;
+    std::vector<THEREMAXSparkVertex> emitters;
+
+    // which update this is (0: nothing published yet)
+    unsigned long frame;
+    // simulated time
+    double elapsed;
+    // cost of the update and of building this state (seconds)
+    double updateTime;
+    double publishTime;
+    // draw list stats
+    size_t numNodes;
+    size_t numCulled;
+    size_t numCullTests;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class THEREMAXRenderBuffers
+// desc: three states -- the writer fills one, the newest complete one waits,
+//       the reader draws one; publish/acquire only swap indices (under a
+//       mutex held for a few instructions), so neither side blocks on the
+//       other's work; also carries the camera from the reader to the writer
+//-----------------------------------------------------------------------------
+class THEREMAXRenderBuffers
+{
+public:
+    THEREMAXRenderBuffers();
+
+public:
+    // writer: the state to fill
+    THEREMAXRenderState & writeState() { return m_states[m_write]; }
+    // writer: make it the newest complete state
+    void publish();
+    // reader: the newest complete state (NULL until the first publish);
+    // stays valid until the next acquire
+    const THEREMAXRenderState * acquire();
+
+public:
+    // reader: camera for the next update (world -> clip, eye in world)
+    void setCamera( const XMatrix4 & clip, const Vector3D & eye );
+    // writer: latest camera (false if none set)
+    bool getCamera( XMatrix4 & clip, Vector3D & eye );
+
+public:
+    // publishes the reader skipped / acquires that found nothing new
+    unsigned long numDropped() const { return m_numDropped; }
+    unsigned long numRepeated() const { return m_numRepeated; }
+
+protected:
+    THEREMAXRenderState m_states[3];
+    int m_write;
+    int m_ready;
+    int m_read;
+    // m_ready holds something the reader hasn't seen
+    bool m_fresh;
+    // the reader has seen at least one state
+    bool m_started;
+    // camera
+    XMatrix4 m_clip;
+    Vector3D m_eye;
+    bool m_hasCamera;
+    // stats
+    unsigned long m_numDropped;
+    unsigned long m_numRepeated;
+    XMutex m_mutex;
+};
+
+
+
+
+#endif
@@ -0,0 +1,428 @@
+//-----------------------------------------------------------------------------
+// name: theremax-resolution.cpp
+// desc: dynamic resolution -- the scene renders into a framebuffer object at
+//       a scale of the window, chosen each frame from measured frame times,
+//       and is upscaled to the window
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-resolution.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+
+
+
+// frame times kept for the report
+#define RESOLUTION_WINDOW 600
+// scale range, in steps of (keeps the size from wandering a pixel a frame)
+#define RESOLUTION_MIN_SCALE .4f
+#define RESOLUTION_STEP ( 1 / 32.0f )
+// most the scale changes at once (fraction): drop fast, recover slowly
+#define RESOLUTION_MAX_DOWN .25f
+#define RESOLUTION_MAX_UP .1f
+// frames to wait after a change (timer results lag a couple of frames)
+#define RESOLUTION_HOLD 8
+// smoothing of the measured time (0-1, higher follows faster)
+#define RESOLUTION_SMOOTHING .2
+// scale down above this fraction of the target, up below the other; aim
+// under the target so a change doesn't land right back on the edge
+#define RESOLUTION_OVER 1.05
+#define RESOLUTION_UNDER .75
+#define RESOLUTION_AIM .9
+// without timer queries: frames at the target before trying a step up
+#define RESOLUTION_PROBE_HOLD 120
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: resolution_has()
+// desc: GL version at least major.minor, or the extension
+//-----------------------------------------------------------------------------
+static bool resolution_has( int major, int minor, const char * extension )
+{
+    const char * version = (const char *)glGetString( GL_VERSION );
+    int haveMajor = 0, haveMinor = 0;
+    if( version ) sscanf( version, "%d.%d", &haveMajor, &haveMinor );
+    if( haveMajor > major || ( haveMajor == major && haveMinor >= minor ) ) return true;
+
+    const char * extensions = (const char *)glGetString( GL_EXTENSIONS );
+    return extensions && strstr( extensions, extension );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXDynamicResolution()
+// desc: constructor
+//-----------------------------------------------------------------------------
+THEREMAXDynamicResolution::THEREMAXDynamicResolution()
+    : m_times( RESOLUTION_WINDOW )
+{
+    m_supported = false;
+    m_enabled = true;
+    m_active = false;
+    m_stale = false;
+    m_drawnScale = 0;
+    m_framebuffer = m_color = m_depth = 0;
+    m_allocWidth = m_allocHeight = 0;
+    m_drawnScale = 0;
+    m_windowWidth = m_windowHeight = 0;
+    m_timer = false;
+    m_timing = false;
+    memset( m_queries, 0, sizeof(m_queries) );
+    memset( m_pending, 0, sizeof(m_pending) );
+    m_query = 0;
+    m_sceneTime = -1;
+    m_scale = 1;
+    m_target = 1000 / 60.0;
+    m_smoothed = -1;
+    m_hold = 0;
+    m_probe = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: ~THEREMAXDynamicResolution()
+// desc: destructor (GL objects go with the context, or cleanup())
+//-----------------------------------------------------------------------------
+THEREMAXDynamicResolution::~THEREMAXDynamicResolution()
+{
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: init()
+// desc: framebuffer objects are core in GL 3.0, timer queries in 3.3
+//-----------------------------------------------------------------------------
+bool THEREMAXDynamicResolution::init()
+{
+    m_supported = resolution_has( 3, 0, "GL_ARB_framebuffer_object" );
+    m_timer = m_supported && resolution_has( 3, 3, "GL_ARB_timer_query" );
+    // software rasterizers draw at the flush / swap, on their own threads;
+    // their queries only time the submit
+    const char * renderer = (const char *)glGetString( GL_RENDERER );
+    if( renderer && ( strstr( renderer, "llvmpipe" ) || strstr( renderer, "softpipe" ) ||
+                      strstr( renderer, "Software" ) ) )
+        m_timer = false;
+    if( m_timer ) glGenQueries( THEREMAX_RESOLUTION_QUERIES, m_queries );
+
+    if( !m_supported )
+        fprintf( stderr, "[theremax]: no framebuffer objects, rendering at window resolution\n" );
+    else
+        fprintf( stderr, "[theremax]: dynamic resolution to %.1fms frames (scene time from %s)\n",
+                 m_target, m_timer ? "timer queries" : "present intervals" );
+    return m_supported;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: resize()
+// desc: window size
+//-----------------------------------------------------------------------------
+void THEREMAXDynamicResolution::resize( GLsizei width, GLsizei height )
+{
+    m_windowWidth = width;
+    m_windowHeight = height;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: setEnabled()
+// desc: scale with frame time, or draw at the window's size
+//-----------------------------------------------------------------------------
+void THEREMAXDynamicResolution::setEnabled( bool enabled )
+{
+    m_enabled = enabled;
+    // (the framebuffer's frame is from before)
+    m_drawnScale = 0;
+    // start over from whatever the frames measure next
+    m_smoothed = -1;
+    m_hold = RESOLUTION_HOLD;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: width() / height()
+// desc: scene size at the current scale
+//-----------------------------------------------------------------------------
+GLsizei THEREMAXDynamicResolution::width() const
+{
+    GLsizei w = (GLsizei)( m_windowWidth * m_scale + .5f );
+    return w > 0 ? w : 1;
+}
+
+GLsizei THEREMAXDynamicResolution::height() const
+{
+    GLsizei h = (GLsizei)( m_windowHeight * m_scale + .5f );
+    return h > 0 ? h : 1;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: allocate()
+// desc: color and depth at the window's size; scaled frames draw into the
+//       bottom left, so changing the scale never reallocates
+//-----------------------------------------------------------------------------
+bool THEREMAXDynamicResolution::allocate()
+{
+    if( !m_framebuffer )
+    {
+        glGenFramebuffers( 1, &m_framebuffer );
+        glGenRenderbuffers( 1, &m_color );
+        glGenRenderbuffers( 1, &m_depth );
+    }
+
+    glBindRenderbuffer( GL_RENDERBUFFER, m_color );
+    glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, m_windowWidth, m_windowHeight );
+    glBindRenderbuffer( GL_RENDERBUFFER, m_depth );
+    glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_windowWidth, m_windowHeight );
+    glBindRenderbuffer( GL_RENDERBUFFER, 0 );
+
+    glBindFramebuffer( GL_FRAMEBUFFER, m_framebuffer );
+    glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color );
+    glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depth );
+    GLenum status = glCheckFramebufferStatus( GL_FRAMEBUFFER );
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+
+    if( status != GL_FRAMEBUFFER_COMPLETE )
+    {
+        fprintf( stderr, "[theremax]: framebuffer incomplete (0x%x), rendering at window resolution\n", status );
+        cleanup();
+        m_supported = false;
+        return false;
+    }
+
+    m_allocWidth = m_windowWidth;
+    m_allocHeight = m_windowHeight;
+    m_drawnScale = 0;
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: cleanup()
+// desc: release GL objects
+//-----------------------------------------------------------------------------
+void THEREMAXDynamicResolution::cleanup()
+{
+    if( m_framebuffer ) glDeleteFramebuffers( 1, &m_framebuffer );
+    if( m_color ) glDeleteRenderbuffers( 1, &m_color );
+    if( m_depth ) glDeleteRenderbuffers( 1, &m_depth );
+    m_framebuffer = m_color = m_depth = 0;
+    m_allocWidth = m_allocHeight = 0;
+    m_drawnScale = 0;
+
+    if( m_timer ) glDeleteQueries( THEREMAX_RESOLUTION_QUERIES, m_queries );
+    memset( m_queries, 0, sizeof(m_queries) );
+    memset( m_pending, 0, sizeof(m_pending) );
+    m_timer = false;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: begin()
+// desc: scene into the framebuffer at the current scale
+//-----------------------------------------------------------------------------
+bool THEREMAXDynamicResolution::begin()
+{
+    if( !m_enabled || !m_supported || m_windowWidth <= 0 || m_windowHeight <= 0 )
+        return false;
+    if( ( m_allocWidth != m_windowWidth || m_allocHeight != m_windowHeight ) && !allocate() )
+        return false;
+
+    glBindFramebuffer( GL_FRAMEBUFFER, m_framebuffer );
+    glViewport( 0, 0, width(), height() );
+    // clears only touch the part in use
+    if( m_scale < 1 )
+    {
+        glScissor( 0, 0, width(), height() );
+        glEnable( GL_SCISSOR_TEST );
+    }
+
+    // time it, unless this slot's result still hasn't come back
+    if( m_timer && !m_pending[m_query] )
+    {
+        glBeginQuery( GL_TIME_ELAPSED, m_queries[m_query] );
+        m_timing = true;
+    }
+
+    m_active = true;
+    m_stale = m_drawnScale != m_scale;
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: end()
+// desc: upscale into the window (viewport back to the window)
+//-----------------------------------------------------------------------------
+void THEREMAXDynamicResolution::end()
+{
+    if( !m_active ) return;
+    m_active = false;
+    m_drawnScale = m_scale;
+
+    if( m_timing )
+    {
+        glEndQuery( GL_TIME_ELAPSED );
+        m_pending[m_query] = true;
+        m_query = ( m_query + 1 ) % THEREMAX_RESOLUTION_QUERIES;
+        m_timing = false;
+    }
+
+    // (the blit is scissored too)
+    glDisable( GL_SCISSOR_TEST );
+    glBindFramebuffer( GL_READ_FRAMEBUFFER, m_framebuffer );
+    glBindFramebuffer( GL_DRAW_FRAMEBUFFER, 0 );
+    glBlitFramebuffer( 0, 0, width(), height(), 0, 0, m_windowWidth, m_windowHeight,
+                       GL_COLOR_BUFFER_BIT, m_scale < 1 ? GL_LINEAR : GL_NEAREST );
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+    glViewport( 0, 0, m_windowWidth, m_windowHeight );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: poll()
+// desc: collect finished timer queries, oldest first
+//-----------------------------------------------------------------------------
+void THEREMAXDynamicResolution::poll()
+{
+    for( int i = 0; i < THEREMAX_RESOLUTION_QUERIES; i++ )
+    {
+        int q = ( m_query + i ) % THEREMAX_RESOLUTION_QUERIES;
+        if( !m_pending[q] ) continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv( m_queries[q], GL_QUERY_RESULT_AVAILABLE, &available );
+        if( !available ) continue;
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v( m_queries[q], GL_QUERY_RESULT, &elapsed );
+        m_sceneTime = elapsed / 1e6;
+        m_pending[q] = false;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: frame()
+// desc: this frame's present interval (ms); adjusts the scale
+//-----------------------------------------------------------------------------
+void THEREMAXDynamicResolution::frame( double interval )
+{
+    if( !m_enabled || !m_supported ) return;
+
+    double cost = interval;
+    if( m_timer )
+    {
+        poll();
+        cost = m_sceneTime;
+        m_sceneTime = -1;
+    }
+    if( cost < 0 ) return;
+
+    adjust( cost );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: adjust()
+// desc: fill cost goes with the area, so the scale moves by the square root
+//       of the time ratio; steps are limited, then held while results for
+//       the new size come in
+//-----------------------------------------------------------------------------
+void THEREMAXDynamicResolution::adjust( double cost )
+{
+    m_times.add( cost );
+    m_smoothed = m_smoothed < 0 ? cost : m_smoothed + RESOLUTION_SMOOTHING * ( cost - m_smoothed );
+    if( m_hold > 0 )
+    {
+        m_hold--;
+        return;
+    }
+
+    GLfloat next = m_scale;
+    if( m_smoothed > m_target * RESOLUTION_OVER || m_smoothed < m_target * RESOLUTION_UNDER )
+    {
+        next = m_scale * (GLfloat)sqrt( m_target * RESOLUTION_AIM / m_smoothed );
+        m_probe = 0;
+    }
+    else if( !m_timer && ++m_probe >= RESOLUTION_PROBE_HOLD )
+    {
+        // present intervals sit at the target under vsync whatever the
+        // headroom: try a step up now and then (a step too far comes back)
+        next = m_scale + RESOLUTION_STEP;
+        m_probe = 0;
+    }
+
+    // limit, snap, clamp
+    if( next < m_scale * ( 1 - RESOLUTION_MAX_DOWN ) ) next = m_scale * ( 1 - RESOLUTION_MAX_DOWN );
+    if( next > m_scale * ( 1 + RESOLUTION_MAX_UP ) ) next = m_scale * ( 1 + RESOLUTION_MAX_UP );
+    next = floorf( next / RESOLUTION_STEP + .5f ) * RESOLUTION_STEP;
+    if( next < RESOLUTION_MIN_SCALE ) next = RESOLUTION_MIN_SCALE;
+    if( next > 1 ) next = 1;
+    if( next == m_scale ) return;
+
+    fprintf( stderr, "[theremax]: render scale %.2f -> %.2f (%dx%d), %s %.1fms for a %.1fms target\n",
+             m_scale, next, (int)( m_windowWidth * next + .5f ), (int)( m_windowHeight * next + .5f ),
+             m_timer ? "scene" : "frame", m_smoothed, m_target );
+    m_scale = next;
+    m_smoothed = -1;
+    m_hold = RESOLUTION_HOLD;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: report()
+// desc: print a summary
+//-----------------------------------------------------------------------------
+void THEREMAXDynamicResolution::report() const
+{
+    if( !m_supported )
+    {
+        fprintf( stderr, "[theremax]: dynamic resolution unsupported\n" );
+        return;
+    }
+    if( !m_enabled )
+    {
+        fprintf( stderr, "[theremax]: dynamic resolution off (%dx%d)\n",
+                 (int)m_windowWidth, (int)m_windowHeight );
+        return;
+    }
+
+    fprintf( stderr, "[theremax]: render scale %.2f (%dx%d of %dx%d), %s p50:%.2f p99:%.2f ms, "
+             "target %.1fms\n", m_scale, (int)width(), (int)height(),
+             (int)m_windowWidth, (int)m_windowHeight, m_timer ? "scene" : "frame",
+             m_times.percentile( 50 ), m_times.percentile( 99 ), m_target );
+}
@@ -0,0 +1,119 @@
+//-----------------------------------------------------------------------------
+// name: theremax-resolution.h
+// desc: dynamic resolution -- the scene renders into a framebuffer object at
+//       a scale of the window, chosen each frame from measured frame times,
+//       and is upscaled to the window
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_RESOLUTION_H__
+#define __THEREMAX_RESOLUTION_H__
+
+#include "x-gfx.h"
+#include "theremax-stats.h"
+
+// timer queries in flight (results are read a couple of frames late)
+#define THEREMAX_RESOLUTION_QUERIES 3
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class THEREMAXDynamicResolution
+// desc: per frame: begin() (false: draw to the window as usual), draw the
+//       scene, end(), then frame() with the present interval once swapped.
+//       Scene time comes from GPU timer queries when the GL has them (else
+//       the present interval, which can't show headroom under vsync, so
+//       there the scale creeps back up instead)
+//-----------------------------------------------------------------------------
+class THEREMAXDynamicResolution
+{
+public:
+    THEREMAXDynamicResolution();
+    ~THEREMAXDynamicResolution();
+
+public:
+    // probe for framebuffer objects / timer queries (GL thread)
+    bool init();
+    // window size (reallocates on the next begin())
+    void resize( GLsizei width, GLsizei height );
+    // frame time to hold (ms)
+    void setTarget( double ms ) { m_target = ms; }
+    double target() const { return m_target; }
+    // scale with frame time (else draw at the window's size)
+    void setEnabled( bool enabled );
+    bool enabled() const { return m_enabled; }
+    // release GL objects
+    void cleanup();
+
+public:
+    // scene into the framebuffer at the current scale
+    bool begin();
+    // between begin() and end(): the framebuffer doesn't hold the last frame
+    // at this scale (just allocated, re-enabled, or the scale changed), so
+    // there is nothing to blend over -- clear it instead
+    bool stale() const { return m_active && m_stale; }
+    // upscale into the window (viewport back to the window)
+    void end();
+    // this frame's present interval (ms); adjusts the scale
+    void frame( double interval );
+
+public:
+    // fraction of the window's width and height drawn
+    GLfloat scale() const { return m_scale; }
+    // scene size at the current scale
+    GLsizei width() const;
+    GLsizei height() const;
+    // scene (or frame) times the controller saw (ms)
+    const THEREMAXStats & times() const { return m_times; }
+    // print a summary
+    void report() const;
+
+protected:
+    // framebuffer at the window's size (scaled frames use part of it)
+    bool allocate();
+    // collect finished timer queries
+    void poll();
+    // the controller
+    void adjust( double cost );
+
+protected:
+    bool m_supported;
+    bool m_enabled;
+    // this frame drew into the framebuffer, and found it stale
+    bool m_active;
+    bool m_stale;
+    // scale of the frame left in the framebuffer (0: none)
+    GLfloat m_drawnScale;
+    GLuint m_framebuffer;
+    GLuint m_color;
+    GLuint m_depth;
+    // allocated size
+    GLsizei m_allocWidth;
+    GLsizei m_allocHeight;
+    // window size
+    GLsizei m_windowWidth;
+    GLsizei m_windowHeight;
+    // scene time from timer queries (one running this frame)
+    bool m_timer;
+    bool m_timing;
+    GLuint m_queries[THEREMAX_RESOLUTION_QUERIES];
+    bool m_pending[THEREMAX_RESOLUTION_QUERIES];
+    int m_query;
+    // latest finished query (ms, < 0 when none since the last frame())
+    double m_sceneTime;
+    // controller
+    GLfloat m_scale;
+    double m_target;
+    double m_smoothed;
+    // frames before the next change / step up
+    int m_hold;
+    int m_probe;
+    THEREMAXStats m_times;
+};
+
+
+
+
+#endif
@@ -0,0 +1,210 @@
+//-----------------------------------------------------------------------------
+// name: theremax-sim-thread.cpp
+// desc: runs the simulation update on its own thread; the GL thread draws
+//       the latest published render state
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-sim-thread.h"
+#include "theremax-sim.h"
+#include "theremax-globals.h"
+#include "theremax-pacer.h"
+#include "x-fun.h"
+#include <stdio.h>
+#include <unistd.h>
+using namespace std;
+
+
+
+
+// the thread
+static XThread * g_thread = NULL;
+// what it updates
+static THEREMAXSim * g_sim = NULL;
+// update vs anyone else touching the sim
+static XMutex g_simMutex;
+// sim thread -> GL thread
+static THEREMAXRenderBuffers g_buffers;
+// update timing (sim thread, read for the report)
+static THEREMAXFramePacer g_pacer;
+// stop request / acknowledgment (under g_simMutex)
+static bool g_quit = false;
+static bool g_done = false;
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: sim_thread_func()
+// desc: update, publish, wait for the next step
+//-----------------------------------------------------------------------------
+static THREAD_RETURN THREAD_TYPE sim_thread_func( void * /* data */ )
+{
+    XMatrix4 clip;
+    Vector3D eye;
+
+    while( true )
+    {
+        // at the sim's rate, independent of the display
+        g_pacer.setFrameRate( g_sim->getDesiredFrameRate() );
+        g_pacer.wait();
+
+        // camera from the last drawn frame
+        bool hasCamera = g_buffers.getCamera( clip, eye );
+
+        g_simMutex.acquire();
+        if( g_quit ) break;
+        if( hasCamera ) g_sim->setViewpoint( eye );
+        double start = XFun::now();
+        g_sim->systemUpdate();
+        double updateTime = XFun::now() - start;
+        THEREMAXRenderState & state = g_buffers.writeState();
+        g_sim->publish( state, hasCamera ? &clip : NULL );
+        state.updateTime = updateTime;
+        g_buffers.publish();
+        g_pacer.presented();
+        g_simMutex.release();
+    }
+
+    // (still holding the mutex)
+    g_done = true;
+    g_simMutex.release();
+    return 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: theremax_sim_thread_start()
+// desc: start updating sim on its own thread
+//-----------------------------------------------------------------------------
+bool theremax_sim_thread_start( THEREMAXSim * sim )
+{
+    if( g_thread ) return true;
+
+    g_sim = sim;
+    g_quit = false;
+    g_done = false;
+    // no swap to sync with, always sleeps
+    g_pacer.init( false );
+
+    g_thread = new XThread();
+    if( !g_thread->start( sim_thread_func ) )
+    {
+        fprintf( stderr, "[theremax]: cannot start simulation thread\n" );
+        SAFE_DELETE( g_thread );
+        return false;
+    }
+
+    fprintf( stderr, "[theremax]: simulation running on its own thread\n" );
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: theremax_sim_thread_stop()
+// desc: stop after the update in progress
+//-----------------------------------------------------------------------------
+bool theremax_sim_thread_stop()
+{
+    if( !g_thread ) return true;
+
+    // let it finish the step (XThread::wait cancels, which could land
+    // mid-update holding the mutex)
+    g_simMutex.acquire();
+    g_quit = true;
+    g_simMutex.release();
+    bool done = false;
+    for( int i = 0; i < 1000 && !done; i++ )
+    {
+        usleep( 1000 );
+        g_simMutex.acquire();
+        done = g_done;
+        g_simMutex.release();
+    }
+
+    g_thread->wait();
+    SAFE_DELETE( g_thread );
+    return done;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: theremax_sim_thread_running()
+// desc: is it running
+//-----------------------------------------------------------------------------
+bool theremax_sim_thread_running()
+{
+    return g_thread != NULL;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: theremax_sim_thread_camera()
+// desc: camera for the next update
+//-----------------------------------------------------------------------------
+void theremax_sim_thread_camera( const XMatrix4 & clip, const Vector3D & eye )
+{
+    g_buffers.setCamera( clip, eye );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: theremax_sim_thread_acquire()
+// desc: latest complete render state
+//-----------------------------------------------------------------------------
+const THEREMAXRenderState * theremax_sim_thread_acquire()
+{
+    return g_buffers.acquire();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: theremax_sim_thread_lock() / unlock()
+// desc: hold off updates
+//-----------------------------------------------------------------------------
+void theremax_sim_thread_lock()
+{
+    if( g_thread ) g_simMutex.acquire();
+}
+
+void theremax_sim_thread_unlock()
+{
+    if( g_thread ) g_simMutex.release();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: theremax_sim_thread_report()
+// desc: print update rate and buffer stats
+//-----------------------------------------------------------------------------
+void theremax_sim_thread_report()
+{
+    if( !g_thread )
+    {
+        fprintf( stderr, "[theremax]: simulation runs on the GL thread\n" );
+        return;
+    }
+
+    g_simMutex.acquire();
+    const THEREMAXStats & intervals = g_pacer.intervals();
+    fprintf( stderr, "[theremax]: sim thread update interval p50:%.2f p99:%.2f ms, "
+             "dropped:%lu repeated:%lu\n",
+             intervals.percentile( 50 ), intervals.percentile( 99 ),
+             g_buffers.numDropped(), g_buffers.numRepeated() );
+    g_simMutex.release();
+}
@@ -0,0 +1,34 @@
+//-----------------------------------------------------------------------------
+// name: theremax-sim-thread.h
+// desc: runs the simulation update on its own thread; the GL thread draws
+//       the latest published render state
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_SIM_THREAD_H__
+#define __THEREMAX_SIM_THREAD_H__
+
+#include "theremax-render-state.h"
+
+// forward reference
+class THEREMAXSim;
+
+// start updating sim on its own thread
+bool theremax_sim_thread_start( THEREMAXSim * sim );
+// stop (waits for the update in progress)
+bool theremax_sim_thread_stop();
+// is it running
+bool theremax_sim_thread_running();
+// GL thread: camera for the next update (world -> clip, eye)
+void theremax_sim_thread_camera( const XMatrix4 & clip, const Vector3D & eye );
+// GL thread: latest complete render state (NULL before the first)
+const THEREMAXRenderState * theremax_sim_thread_acquire();
+// hold off updates while touching the sim from another thread (no-op when
+// the thread isn't running)
+void theremax_sim_thread_lock();
+void theremax_sim_thread_unlock();
+// print update rate and buffer stats
+void theremax_sim_thread_report();
+
+#endif
@@ -6,6 +6,8 @@
 //   date: 2013
 //-----------------------------------------------------------------------------
 #include "theremax-sim.h"
+#include "theremax-globals.h"
+#include "x-fun.h"
 #include <iostream>
 using namespace std;
 
@@ -31,8 +33,14 @@ THEREMAXSim::THEREMAXSim()
     m_timeLeftOver = 0;
     m_simTime = 0;
     m_lastDelta = 0;
+    m_elapsed = 0;
     m_first = true;
     m_isPaused = false;
+    m_numPublished = 0;
+    m_batchedUpdate = true;
+    m_profiling = false;
+    m_emitter = NULL;
+    m_population.attach( &m_gfxRoot, &m_flockBroadphase );
 }
 
 
@@ -51,16 +59,28 @@ THEREMAXSim::~THEREMAXSim()
 
 
 //-------------------------------------------------------------------------------
-// name: triggerUpdates()
-// desc: trigger system wide update with time steps
+// name: systemCascade()
+// desc: trigger system wide update with time steps, then redraw
 //-------------------------------------------------------------------------------
 void THEREMAXSim::systemCascade()
 {
-    // get current time (once per frame)
-    XGfx::getCurrentTime( true );
-    
-    // Timing loop
-    YTimeInterval timeElapsed = XGfx::getCurrentTime() - m_simTime;
+    // update
+    systemUpdate();
+    // redraw
+    systemRender();
+}
+
+
+
+
+//-------------------------------------------------------------------------------
+// name: systemUpdate()
+// desc: trigger system wide update with time steps
+//-------------------------------------------------------------------------------
+void THEREMAXSim::systemUpdate()
+{
+    // get current time (own clock: XGfx's belongs to the GL thread)
+    YTimeInterval timeElapsed = XFun::now() - m_simTime;
     m_simTime += timeElapsed;
     
     // special case: first update
@@ -77,24 +97,243 @@ void THEREMAXSim::systemCascade()
         timeElapsed = SIM_SKIP_TIME;
     
     // update it
+    step( timeElapsed );
+}
+
+
+
+
+//-------------------------------------------------------------------------------
+// name: systemRender()
+// desc: draw the world
+//-------------------------------------------------------------------------------
+void THEREMAXSim::systemRender()
+{
+    // the current camera, to cull and sort sparks by
+    XMatrix4 clip;
+    if( Globals::frustumCull || Globals::sparkSort )
+    {
+        XMatrix4 projection, modelview;
+        glGetFloatv( GL_PROJECTION_MATRIX, projection.m );
+        glGetFloatv( GL_MODELVIEW_MATRIX, modelview.m );
+        clip = projection * modelview;
+    }
+    XFrustum * frustum = NULL;
+    if( Globals::frustumCull )
+    {
+        m_frustum.set( clip );
+        frustum = &m_frustum;
+    }
+    
+    // world matrices and draw order, no GL
+    m_drawList.prepare( &m_gfxRoot, frustum );
+    m_drawList.sort();
+    
+    // one item at a time
+    if( !Globals::sparkBatch )
+    {
+        m_drawList.submit();
+        if( m_profiling ) m_profiler.renderFrame();
+        return;
+    }
+    
+    // sparks as one batch, in key order with everything else
+    size_t sparks = m_drawList.lowerBound( THEREMAX_DRAW_KEY_SPARK );
+    size_t sparksEnd = m_drawList.lowerBound( THEREMAX_DRAW_KEY_SPARK_END );
+    m_drawList.submit( 0, sparks );
+    double start = XFun::now();
+    m_sparkBatch.collect( m_drawList, sparks, sparksEnd, Globals::sparkSort ? &clip : NULL );
+    m_sparkBatch.draw();
+    if( m_profiling )
+        m_profiler.addRender( typeid(THEREMAXSpark), XFun::now() - start, sparksEnd - sparks );
+    m_drawList.submit( sparksEnd, m_drawList.size() );
+    if( m_profiling ) m_profiler.renderFrame();
+}
+
+
+
+
+//-------------------------------------------------------------------------------
+// name: publish()
+// desc: prepare and sort as systemRender, but copy the result out
+//-------------------------------------------------------------------------------
+void THEREMAXSim::publish( THEREMAXRenderState & state, const XMatrix4 * clip )
+{
+    double start = XFun::now();
+    
+    // frustum from the given camera
+    XFrustum * frustum = NULL;
+    if( clip && Globals::frustumCull )
+    {
+        m_frustum.set( *clip );
+        frustum = &m_frustum;
+    }
+    
+    // world matrices and draw order
+    m_drawList.prepare( &m_gfxRoot, frustum );
+    m_drawList.sort();
+    
+    // keeps capacity, no allocation in steady state
+    state.emitters.clear();
+    size_t sparks = m_drawList.lowerBound( THEREMAX_DRAW_KEY_SPARK );
+    size_t sparksEnd = m_drawList.lowerBound( THEREMAX_DRAW_KEY_SPARK_END );
+    size_t emitters = m_drawList.lowerBound( THEREMAX_DRAW_KEY_EMITTER );
+    size_t emittersEnd = m_drawList.lowerBound( THEREMAX_DRAW_KEY_EMITTER + 1 );
+    
+    // everything drawn goes in baked (render() would read the scene while
+    // the next update moves it), so the rest must draw nothing: a plain
+    // YEntity (the root)
+    for( size_t i = 0; i < m_drawList.size(); i++ )
+    {
+        if( i == sparks ) i = sparksEnd;
+        if( i == emitters ) i = emittersEnd;
+        if( i >= m_drawList.size() ) break;
+        assert( typeid( *m_drawList.item( i ).entity ) == typeid( YEntity ) );
+    }
+    
+    // sparks and emitters as quads
+    double collect = XFun::now();
+    m_sparkBatch.collect( m_drawList, sparks, sparksEnd, state.sparks, state.sparkIndices,
+                          Globals::sparkSort ? clip : NULL );
+    // (render() adds the draw)
+    if( m_profiling )
+        m_profiler.addRender( typeid(THEREMAXSpark), XFun::now() - collect, sparksEnd - sparks );
+    collect = XFun::now();
+    for( size_t i = emitters; i < emittersEnd; i++ )
+    {
+        const YDrawItem & it = m_drawList.item( i );
+        ( (THEREMAXAudioEmitter *)it.entity )->collect( state.emitters, it.world );
+    }
+    if( m_profiling )
+        m_profiler.addRender( typeid(THEREMAXAudioEmitter), XFun::now() - collect, emittersEnd - emitters );
+    
+    // stats
+    state.frame = ++m_numPublished;
+    state.elapsed = m_elapsed;
+    state.numNodes = m_drawList.numNodes();
+    state.numCulled = m_drawList.numCulled();
+    state.numCullTests = m_drawList.numCullTests();
+    state.publishTime = XFun::now() - start;
+}
+
+
+
+
+//-------------------------------------------------------------------------------
+// name: render()
+// desc: draw a published state; sparks and emitters go as one batch each
+//-------------------------------------------------------------------------------
+void THEREMAXSim::render( const THEREMAXRenderState & state )
+{
+    YSceneProfiler * profiler = m_profiling ? &m_profiler : NULL;
+    double start = XFun::now();
+    m_sparkBatch.draw( state.sparks, state.sparkIndices );
+    // (publish() counted the sparks and emitters)
+    if( profiler ) profiler->addRender( typeid(THEREMAXSpark), XFun::now() - start, 0 );
+    start = XFun::now();
+    THEREMAXAudioEmitter::draw( state.emitters );
+    if( profiler ) profiler->addRender( typeid(THEREMAXAudioEmitter), XFun::now() - start, 0 );
+    if( profiler ) profiler->renderFrame();
+}
+
+
+
+
+//-------------------------------------------------------------------------------
+// name: step()
+// desc: update the world by a fixed timestep
+//-------------------------------------------------------------------------------
+void THEREMAXSim::step( YTimeInterval dt )
+{
     // check paused
     if( !m_isPaused )
     {
-        // update the world with a fixed timestep
-        m_gfxRoot.updateAll( timeElapsed );
+        double start = XFun::now();
+        
+        // flocks come and go with the cv
+        if( m_population.following )
+            m_population.follow( Globals::cvIntensity, dt );
+        // particles with the music
+        if( m_emitter && m_emitter->following )
+            m_emitter->follow( Globals::audioBands );
+        
+        // update the world (one loop per type, or the recursive walk;
+        // profiling times types in the batched pass)
+        if( m_batchedUpdate || m_profiling ) m_updater.update( m_gfxRoot, dt );
+        else m_gfxRoot.updateAll( dt );
+        if( m_profiling ) m_profiler.updateFrame();
+        // flocks steer around each other on their next rule pass
+        m_flockBroadphase.update();
+        
+        // this update's rule evaluations (counted per flock: nothing shared
+        // with other sims or threads)
+        const vector<THEREMAXFlock *> & flocks = m_flockBroadphase.flocks();
+        unsigned long ruleEvals = 0;
+        for( size_t i = 0; i < flocks.size(); i++ )
+        {
+            ruleEvals += flocks[i]->ruleEvals;
+            flocks[i]->ruleEvals = 0;
+        }
+        
+        // pick levels of detail for the next update
+        m_flockLod.update( flocks, m_viewpoint, dt, ruleEvals, XFun::now() - start );
+        
+        // count
+        m_elapsed += dt;
     }
     
-    // redraw
-    m_gfxRoot.drawAll();
-    
     // set
-    m_lastDelta = timeElapsed;
+    m_lastDelta = dt;
 }
 
 
 
 
 
+//-------------------------------------------------------------------------------
+// name: setProfiling()
+// desc: hand the profiler to the update pass and the draw list (times only
+//       come per type from the batched update, so step() uses it while
+//       profiling); starts from zero
+//-------------------------------------------------------------------------------
+void THEREMAXSim::setProfiling( bool profiling )
+{
+    m_profiling = profiling;
+    m_updater.setProfiler( profiling ? &m_profiler : NULL );
+    m_drawList.setProfiler( profiling ? &m_profiler : NULL );
+    if( profiling ) m_profiler.reset();
+}
+
+
+
+
+//-------------------------------------------------------------------------------
+// name: setEmitter()
+// desc: into root in place of the last one (sim thread, or with it stopped)
+//-------------------------------------------------------------------------------
+void THEREMAXSim::setEmitter( THEREMAXAudioEmitter * emitter )
+{
+    if( m_emitter ) m_gfxRoot.removeChild( m_emitter );
+    m_emitter = emitter;
+    if( m_emitter ) m_gfxRoot.addChild( m_emitter );
+}
+
+
+
+
+//-------------------------------------------------------------------------------
+// name: setViewpoint()
+// desc: set the eye position, used for level of detail
+//-------------------------------------------------------------------------------
+void THEREMAXSim::setViewpoint( const Vector3D & eye )
+{
+    m_viewpoint = eye;
+    m_flockLod.enabled = true;
+}
+
+
+
+
 //-------------------------------------------------------------------------------
 // pause the simulation
 //-------------------------------------------------------------------------------
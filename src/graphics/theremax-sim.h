@@ -9,6 +9,13 @@
 #define __THEREMAX_SIM_H__
 
 #include "theremax-entity.h"
+#include "theremax-broadphase.h"
+#include "theremax-population.h"
+#include "theremax-lod.h"
+#include "theremax-spark-batch.h"
+#include "theremax-render-state.h"
+#include "theremax-emitter.h"
+#include "y-profile.h"
 
 
 
@@ -26,6 +33,18 @@ public:
 public:
     // cascade timestep simulation through system (as connected to this)
     void systemCascade();
+    // advance the clock and update the world (no drawing)
+    void systemUpdate();
+    // draw the world
+    void systemRender();
+    // update the world by a fixed timestep (ignores the clock; headless)
+    void step( YTimeInterval dt );
+    // copy what systemRender would draw into state, no GL (sim thread);
+    // clip is the camera's world -> clip space (NULL: none yet), to cull
+    // with (Globals::frustumCull) and sort sparks by (Globals::sparkSort)
+    void publish( THEREMAXRenderState & state, const XMatrix4 * clip );
+    // draw a published state (GL thread)
+    void render( const THEREMAXRenderState & state );
     
 public:
     // pause the simulation
@@ -42,13 +61,53 @@ public:
     double getDesiredFrameRate() const;
     // get the timestep in effect (fixed or dynamic)
     YTimeInterval delta() const;
+    // total simulated time (sum of all steps)
+    YTimeInterval elapsed() const { return m_elapsed; }
     
 public:
     // get the root
     YEntity & root() { return m_gfxRoot; }
+    // flock vs flock interaction (flocks register here as well as in root)
+    THEREMAXFlockBroadphase & flockBroadphase() { return m_flockBroadphase; }
+    // spawns / despawns flocks (in root and the broadphase) from pools
+    THEREMAXPopulation & population() { return m_population; }
+    // flock level of detail
+    THEREMAXFlockLod & flockLod() { return m_flockLod; }
+    // set the eye position (world space), turns on level of detail
+    void setViewpoint( const Vector3D & eye );
+    // flat draw list used by systemRender
+    YDrawList & drawList() { return m_drawList; }
+    // batched spark renderer (see Globals::sparkBatch)
+    THEREMAXSparkBatch & sparkBatch() { return m_sparkBatch; }
+    // type-batched update pass (the default; else updateAll)
+    void setBatchedUpdate( bool batched ) { m_batchedUpdate = batched; }
+    bool batchedUpdate() const { return m_batchedUpdate; }
+    YUpdateScheduler & updater() { return m_updater; }
+    // time update and render per entity type (see profiler())
+    void setProfiling( bool profiling );
+    bool profiling() const { return m_profiling; }
+    // per type costs while profiling (census() it before reading)
+    YSceneProfiler & profiler() { return m_profiler; }
+    // particles driven by the audio bands (into root; NULL: none)
+    void setEmitter( THEREMAXAudioEmitter * emitter );
+    THEREMAXAudioEmitter * emitter() { return m_emitter; }
     
 protected:
     YEntity m_gfxRoot;
+    THEREMAXFlockBroadphase m_flockBroadphase;
+    THEREMAXPopulation m_population;
+    THEREMAXFlockLod m_flockLod;
+    YDrawList m_drawList;
+    XFrustum m_frustum;
+    THEREMAXSparkBatch m_sparkBatch;
+    YUpdateScheduler m_updater;
+    bool m_batchedUpdate;
+    YSceneProfiler m_profiler;
+    bool m_profiling;
+    THEREMAXAudioEmitter * m_emitter;
+    Vector3D m_viewpoint;
+    // publish() count
+    unsigned long m_numPublished;
     
 public:
     double m_desiredFrameRate;
@@ -58,6 +117,7 @@ public:
     YTimeInterval m_timeLeftOver;
     YTimeInterval m_simTime;
     YTimeInterval m_lastDelta;
+    YTimeInterval m_elapsed;
     bool m_first;
     bool m_isPaused;
 };
@@ -0,0 +1,315 @@
+//-----------------------------------------------------------------------------
+// name: theremax-snapshot.cpp
+// desc: binary snapshot / restore of the simulation state
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-snapshot.h"
+#include "theremax-sim.h"
+#include "theremax-flocking.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+using namespace std;
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: snapshot_put() / snapshot_get()
+// desc: Vector3D <-> float[3]
+//-----------------------------------------------------------------------------
+static void snapshot_put( float * dest, const Vector3D & v )
+{
+    dest[0] = v.x; dest[1] = v.y; dest[2] = v.z;
+}
+
+static void snapshot_get( Vector3D & v, const float * src )
+{
+    v.set( src[0], src[1], src[2] );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: theremax_snapshot_save()
+// desc: write the flocks and timing to path (via a temp file, so a reader
+//       never sees a partial snapshot)
+//-----------------------------------------------------------------------------
+bool theremax_snapshot_save( THEREMAXSim * sim, const char * path )
+{
+    const vector<THEREMAXFlock *> & flocks = sim->flockBroadphase().flocks();
+
+    // header
+    THEREMAXSnapshotHeader header;
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.magic, THEREMAX_SNAPSHOT_MAGIC, sizeof(header.magic) );
+    header.version = THEREMAX_SNAPSHOT_VERSION;
+    header.headerSize = sizeof(THEREMAXSnapshotHeader);
+    header.flockSize = sizeof(THEREMAXSnapshotFlock);
+    header.boidSize = sizeof(THEREMAXSnapshotBoid);
+    header.numFlocks = flocks.size();
+    header.numBoids = 0;
+    for( size_t i = 0; i < flocks.size(); i++ )
+        header.numBoids += flocks[i]->boids().size();
+    header.desiredFrameRate = sim->m_desiredFrameRate;
+    header.timeLeftOver = sim->m_timeLeftOver;
+    header.lastDelta = sim->m_lastDelta;
+    header.elapsed = sim->m_elapsed;
+    header.useFixedTimeStep = sim->m_useFixedTimeStep;
+    header.isPaused = sim->isPaused();
+
+    // open
+    string temp = string( path ) + ".tmp";
+    FILE * file = fopen( temp.c_str(), "wb" );
+    if( !file )
+    {
+        fprintf( stderr, "[theremax]: cannot write snapshot '%s'\n", temp.c_str() );
+        return false;
+    }
+
+    bool ok = fwrite( &header, sizeof(header), 1, file ) == 1;
+
+    // flocks
+    for( size_t i = 0; ok && i < flocks.size(); i++ )
+    {
+        THEREMAXFlock * flock = flocks[i];
+        THEREMAXSnapshotFlock record;
+        memset( &record, 0, sizeof(record) );
+        snapshot_put( record.loc, flock->loc );
+        snapshot_put( record.ALPHA, flock->ALPHA );
+        record.ruleClock = flock->getRuleClock();
+        record.ruleRate = flock->getRuleRate();
+        record.numBoids = flock->boids().size();
+        ok = fwrite( &record, sizeof(record), 1, file ) == 1;
+    }
+
+    // boids
+    for( size_t i = 0; ok && i < flocks.size(); i++ )
+    {
+        THEREMAXFlock * flock = flocks[i];
+        const vector<YEntity *> & boids = flock->boids();
+        for( size_t b = 0; ok && b < boids.size(); b++ )
+        {
+            THEREMAXBoid * boid = (THEREMAXBoid *)boids[b];
+            THEREMAXSnapshotBoid record;
+            memset( &record, 0, sizeof(record) );
+            snapshot_put( record.loc, boid->loc );
+            // aggregated boids don't integrate their own velocity; they
+            // come back at full detail moving with the body
+            snapshot_put( record.vel, flock->getLod() == THEREMAX_LOD_AGGREGATE
+                          ? flock->aggregateVelocity() : boid->vel );
+            snapshot_put( record.ALPHA, boid->ALPHA );
+            snapshot_put( record.col, boid->col );
+            record.alpha = boid->alpha;
+            snapshot_put( record.sparkALPHA, boid->spark->alphaRamp() );
+            record.sparkSize = boid->spark->size;
+            record.sparkAlpha = boid->spark->alpha;
+            ok = fwrite( &record, sizeof(record), 1, file ) == 1;
+        }
+    }
+
+    // close
+    if( fclose( file ) != 0 ) ok = false;
+    if( !ok || rename( temp.c_str(), path ) != 0 )
+    {
+        fprintf( stderr, "[theremax]: error writing snapshot '%s'\n", path );
+        unlink( temp.c_str() );
+        return false;
+    }
+
+    fprintf( stderr, "[theremax]: wrote snapshot '%s' (%lu flocks, %lu boids)\n",
+             path, (unsigned long)header.numFlocks, (unsigned long)header.numBoids );
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: snapshot_validate()
+// desc: check the header against the mapped size
+//-----------------------------------------------------------------------------
+static bool snapshot_validate( const char * data, size_t size, const char * path )
+{
+    if( size < sizeof(THEREMAXSnapshotHeader) )
+    {
+        fprintf( stderr, "[theremax]: snapshot '%s' is truncated\n", path );
+        return false;
+    }
+
+    const THEREMAXSnapshotHeader * header = (const THEREMAXSnapshotHeader *)data;
+    if( memcmp( header->magic, THEREMAX_SNAPSHOT_MAGIC, sizeof(header->magic) ) != 0 )
+    {
+        fprintf( stderr, "[theremax]: '%s' is not a snapshot\n", path );
+        return false;
+    }
+    if( header->version != THEREMAX_SNAPSHOT_VERSION ||
+        header->headerSize != sizeof(THEREMAXSnapshotHeader) ||
+        header->flockSize != sizeof(THEREMAXSnapshotFlock) ||
+        header->boidSize != sizeof(THEREMAXSnapshotBoid) )
+    {
+        fprintf( stderr, "[theremax]: snapshot '%s' has an incompatible format (version %u)\n",
+                 path, header->version );
+        return false;
+    }
+
+    // records: each count bounded by what the file can hold before it is
+    // multiplied (an untrusted count could wrap the product around)
+    uint64_t left = size - sizeof(THEREMAXSnapshotHeader);
+    if( header->numFlocks > left / sizeof(THEREMAXSnapshotFlock) )
+    {
+        fprintf( stderr, "[theremax]: snapshot '%s' is truncated\n", path );
+        return false;
+    }
+    left -= header->numFlocks * sizeof(THEREMAXSnapshotFlock);
+    if( header->numBoids > left / sizeof(THEREMAXSnapshotBoid) ||
+        header->numBoids * sizeof(THEREMAXSnapshotBoid) != left )
+    {
+        fprintf( stderr, "[theremax]: snapshot '%s' is truncated\n", path );
+        return false;
+    }
+
+    // per-flock counts must add up (each within what is left, so the sum
+    // can't wrap either)
+    const THEREMAXSnapshotFlock * flocks = (const THEREMAXSnapshotFlock *)( header + 1 );
+    uint64_t boids = 0;
+    bool fits = true;
+    for( uint64_t i = 0; i < header->numFlocks && fits; i++ )
+    {
+        fits = flocks[i].numBoids <= header->numBoids - boids;
+        if( fits ) boids += flocks[i].numBoids;
+    }
+    if( !fits || boids != header->numBoids )
+    {
+        fprintf( stderr, "[theremax]: snapshot '%s' is corrupt\n", path );
+        return false;
+    }
+
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: snapshot_apply()
+// desc: restore validated records into sim
+//-----------------------------------------------------------------------------
+static void snapshot_apply( THEREMAXSim * sim, const char * data )
+{
+    const THEREMAXSnapshotHeader * header = (const THEREMAXSnapshotHeader *)data;
+    const THEREMAXSnapshotFlock * records = (const THEREMAXSnapshotFlock *)( header + 1 );
+    const THEREMAXSnapshotBoid * boidRecords = (const THEREMAXSnapshotBoid *)( records + header->numFlocks );
+
+    THEREMAXFlockBroadphase & broadphase = sim->flockBroadphase();
+    THEREMAXPopulation & population = sim->population();
+
+    // drop extra flocks
+    while( broadphase.size() > header->numFlocks )
+        population.despawnFlock( broadphase.flocks().back() );
+    // add missing ones
+    while( broadphase.size() < header->numFlocks )
+        population.spawnFlock( 0 );
+
+    // overwrite in place
+    const vector<THEREMAXFlock *> & flocks = broadphase.flocks();
+    for( size_t i = 0; i < flocks.size(); i++ )
+    {
+        THEREMAXFlock * flock = flocks[i];
+        const THEREMAXSnapshotFlock & record = records[i];
+
+        population.setBoids( flock, (int)record.numBoids );
+        // level of detail gets re-picked on the next update
+        flock->setLod( THEREMAX_LOD_FULL );
+        snapshot_get( flock->loc, record.loc );
+        snapshot_get( flock->ALPHA, record.ALPHA );
+        flock->setRuleRate( record.ruleRate );
+        flock->setRuleClock( record.ruleClock );
+
+        const vector<YEntity *> & boids = flock->boids();
+        for( size_t b = 0; b < boids.size(); b++, boidRecords++ )
+        {
+            THEREMAXBoid * boid = (THEREMAXBoid *)boids[b];
+            snapshot_get( boid->loc, boidRecords->loc );
+            snapshot_get( boid->vel, boidRecords->vel );
+            snapshot_get( boid->ALPHA, boidRecords->ALPHA );
+            snapshot_get( boid->col, boidRecords->col );
+            boid->alpha = boidRecords->alpha;
+            Vector3D ramp;
+            snapshot_get( ramp, boidRecords->sparkALPHA );
+            boid->spark->setAlphaRamp( ramp );
+            boid->spark->setSize( boidRecords->sparkSize );
+            boid->spark->alpha = boidRecords->sparkAlpha;
+        }
+    }
+
+    // timing (the wall clock restarts from here)
+    sim->setDesiredFrameRate( header->desiredFrameRate );
+    sim->m_useFixedTimeStep = header->useFixedTimeStep != 0;
+    sim->m_timeLeftOver = header->timeLeftOver;
+    sim->m_lastDelta = header->lastDelta;
+    sim->m_elapsed = header->elapsed;
+    sim->m_first = true;
+    if( header->isPaused ) sim->pause();
+    else sim->resume();
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: theremax_snapshot_load()
+// desc: map the file, validate, restore
+//-----------------------------------------------------------------------------
+bool theremax_snapshot_load( THEREMAXSim * sim, const char * path )
+{
+    // open
+    int fd = open( path, O_RDONLY );
+    if( fd < 0 )
+    {
+        fprintf( stderr, "[theremax]: cannot open snapshot '%s'\n", path );
+        return false;
+    }
+    struct stat info;
+    if( fstat( fd, &info ) != 0 || info.st_size <= 0 )
+    {
+        fprintf( stderr, "[theremax]: snapshot '%s' is empty\n", path );
+        close( fd );
+        return false;
+    }
+
+    // map it (records are read straight out of the page cache)
+    size_t size = (size_t)info.st_size;
+    void * data = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if( data == MAP_FAILED )
+    {
+        fprintf( stderr, "[theremax]: cannot map snapshot '%s'\n", path );
+        return false;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise( data, size, MADV_SEQUENTIAL );
+#endif
+
+    // restore
+    bool ok = snapshot_validate( (const char *)data, size, path );
+    if( ok )
+    {
+        snapshot_apply( sim, (const char *)data );
+        const THEREMAXSnapshotHeader * header = (const THEREMAXSnapshotHeader *)data;
+        fprintf( stderr, "[theremax]: restored snapshot '%s' (%lu flocks, %lu boids, t=%.2fs)\n",
+                 path, (unsigned long)header->numFlocks, (unsigned long)header->numBoids,
+                 header->elapsed );
+    }
+
+    munmap( data, size );
+    return ok;
+}
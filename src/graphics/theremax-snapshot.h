@@ -0,0 +1,101 @@
+//-----------------------------------------------------------------------------
+// name: theremax-snapshot.h
+// desc: binary snapshot / restore of the simulation state
+//
+//   layout (native byte order, each record the struct as the compiler lays
+//   it out; the header stores the three sizes and a file whose sizes
+//   differ is refused):
+//       THEREMAXSnapshotHeader
+//       THEREMAXSnapshotFlock  x numFlocks
+//       THEREMAXSnapshotBoid   x numBoids (flock 0's boids, flock 1's, ...)
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_SNAPSHOT_H__
+#define __THEREMAX_SNAPSHOT_H__
+
+#include <stdint.h>
+
+// forward reference
+class THEREMAXSim;
+
+// file tag and format version
+#define THEREMAX_SNAPSHOT_MAGIC   "THRMXSNP"
+#define THEREMAX_SNAPSHOT_VERSION 1
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: struct THEREMAXSnapshotHeader
+// desc: file header, simulation timing
+//-----------------------------------------------------------------------------
+struct THEREMAXSnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    // sizeof the header and records (catches layout mismatches)
+    uint32_t headerSize;
+    uint32_t flockSize;
+    uint32_t boidSize;
+    uint64_t numFlocks;
+    uint64_t numBoids;
+    // timing
+    double desiredFrameRate;
+    double timeLeftOver;
+    double lastDelta;
+    double elapsed;
+    uint32_t useFixedTimeStep;
+    uint32_t isPaused;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: struct THEREMAXSnapshotFlock
+// desc: one flock
+//-----------------------------------------------------------------------------
+struct THEREMAXSnapshotFlock
+{
+    float loc[3];
+    float ALPHA[3];
+    // phase into the rule period
+    double ruleClock;
+    double ruleRate;
+    uint64_t numBoids;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: struct THEREMAXSnapshotBoid
+// desc: one boid and its spark
+//-----------------------------------------------------------------------------
+struct THEREMAXSnapshotBoid
+{
+    float loc[3];
+    float vel[3];
+    float ALPHA[3];
+    float col[3];
+    float alpha;
+    // spark
+    float sparkALPHA[3];
+    float sparkSize;
+    float sparkAlpha;
+};
+
+
+
+
+// write every flock registered with the sim's broadphase (and its timing)
+bool theremax_snapshot_save( THEREMAXSim * sim, const char * path );
+// restore a snapshot into sim, adding/removing flocks and boids as needed
+bool theremax_snapshot_load( THEREMAXSim * sim, const char * path );
+
+
+
+
+#endif
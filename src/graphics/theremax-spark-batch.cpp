@@ -0,0 +1,413 @@
+//-----------------------------------------------------------------------------
+// name: theremax-spark-batch.cpp
+// desc: draws every spark in one streamed vertex buffer
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-spark-batch.h"
+#include "theremax-entity.h"
+#include "theremax-atlas.h"
+#include "x-fun.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+using namespace std;
+
+
+
+
+// corners within the atlas cell: 0 is u0/v0, 1 is u1/v1 (as THEREMAXSpark::render)
+static const int g_corner_uv[] = { 0, 0, 1, 0, 1, 1, 0, 1 };
+// spark vertices are a triangle strip; quads go around
+static const int g_corner_vertex[] = { 0, 1, 3, 2 };
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: batch_byte()
+// desc: [0,1] -> [0,255]
+//-----------------------------------------------------------------------------
+static inline GLubyte batch_byte( GLfloat v )
+{
+    if( v <= 0 ) return 0;
+    if( v >= 1 ) return 255;
+    return (GLubyte)( v * 255.0f + 0.5f );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: batch_key()
+// desc: depth to a key that sorts ascending as the depths descend: flip
+//       all bits of a negative float, only the sign of a positive one (now
+//       unsigned order is float order), then invert
+//-----------------------------------------------------------------------------
+static inline unsigned int batch_key( GLfloat depth )
+{
+    unsigned int u;
+    memcpy( &u, &depth, sizeof(u) );
+    unsigned int mask = ( u & 0x80000000 ) ? 0xffffffff : 0x80000000;
+    return ~( u ^ mask );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: THEREMAXSparkBatch()
+// desc: constructor
+//-----------------------------------------------------------------------------
+THEREMAXSparkBatch::THEREMAXSparkBatch()
+{
+    m_mode = MODE_UNKNOWN;
+    m_buffer = 0;
+    m_capacity = 0;
+    m_indexBuffer = 0;
+    m_indexCapacity = 0;
+    m_texture = 0;
+    m_numSparks = 0;
+    m_numDrawCalls = 0;
+    m_collectTime = 0;
+    m_drawTime = 0;
+    m_sortTime = 0;
+    m_numSorted = 0;
+    m_numSortPasses = 0;
+    m_numReused = 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: ~THEREMAXSparkBatch()
+// desc: destructor (GL objects must be released with cleanup())
+//-----------------------------------------------------------------------------
+THEREMAXSparkBatch::~THEREMAXSparkBatch()
+{
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: cleanup()
+// desc: release GL objects
+//-----------------------------------------------------------------------------
+void THEREMAXSparkBatch::cleanup()
+{
+    if( m_buffer ) glDeleteBuffers( 1, &m_buffer );
+    if( m_indexBuffer ) glDeleteBuffers( 1, &m_indexBuffer );
+    m_buffer = 0;
+    m_capacity = 0;
+    m_indexBuffer = 0;
+    m_indexCapacity = 0;
+    m_mode = MODE_UNKNOWN;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: collect()
+// desc: gather the sparks in [first, last) of a sorted draw list
+//-----------------------------------------------------------------------------
+void THEREMAXSparkBatch::collect( const YDrawList & list, size_t first, size_t last,
+                                  const XMatrix4 * clip )
+{
+    collect( list, first, last, m_vertices, m_indices, clip );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: collect()
+// desc: gather into caller-owned vertices
+//-----------------------------------------------------------------------------
+void THEREMAXSparkBatch::collect( const YDrawList & list, size_t first, size_t last,
+                                  vector<THEREMAXSparkVertex> & vertices,
+                                  vector<GLuint> & indices, const XMatrix4 * clip )
+{
+    double start = XFun::now();
+
+    // keeps capacity, no allocation in steady state
+    vertices.clear();
+    indices.clear();
+    if( last > list.size() ) last = list.size();
+
+    if( clip && first < last )
+    {
+        // back to front: quads in list order (the sparks are read in
+        // sequence), each key and its digit counts from the translation
+        // emit() loads anyway; only (key, quad) pairs get sorted, the
+        // quads are drawn through indices in sorted order
+        unsigned int counts[BATCH_SORT_PASSES][BATCH_SORT_DIGITS];
+        memset( counts, 0, sizeof(counts) );
+        // keys by quad; the same as last time, quad for quad, give the same
+        // order (a still scene and camera), and the sort is skipped
+        size_t lastQuads = m_keys.size();
+        bool same = true;
+        GLfloat depth;
+        for( size_t i = first; i < last; i++ )
+        {
+            const YDrawItem & item = list.item( i );
+            THEREMAXSpark * spark = (THEREMAXSpark *)item.entity;
+            size_t q = vertices.size() / 4;
+            if( !emit( vertices, spark, spark->vertices, spark->drawAlpha(),
+                       *item.world, clip->m, &depth ) )
+                continue;
+            unsigned int k = batch_key( depth );
+            counts[0][k & BATCH_SORT_MASK]++;
+            counts[1][( k >> BATCH_SORT_BITS ) & BATCH_SORT_MASK]++;
+            counts[2][k >> ( 2 * BATCH_SORT_BITS )]++;
+            if( q < lastQuads )
+            {
+                same = same && m_keys[q] == k;
+                m_keys[q] = k;
+            }
+            else m_keys.push_back( k );
+        }
+        size_t quads = vertices.size() / 4;
+        m_keys.resize( quads );
+
+        if( same && quads && quads == lastQuads && m_pairs.size() == quads )
+        {
+            // last time's sorted pairs stand
+            m_sortTime = 0;
+            m_numSortPasses = 0;
+            m_numSorted = quads;
+            m_numReused++;
+        }
+        else
+        {
+            m_pairs.resize( quads );
+            for( size_t q = 0; q < quads; q++ )
+                m_pairs[q] = ( (unsigned long long)m_keys[q] << 32 ) | q;
+            sort( counts );
+        }
+        indices.resize( 4 * m_pairs.size() );
+        GLuint * out = indices.empty() ? NULL : &indices[0];
+        for( size_t q = 0; q < m_pairs.size(); q++ )
+        {
+            GLuint v = 4 * (GLuint)( m_pairs[q] & 0xffffffff );
+            out[0] = v; out[1] = v + 1; out[2] = v + 2; out[3] = v + 3;
+            out += 4;
+        }
+    }
+    else
+    {
+        m_sortTime = 0;
+        m_numSorted = 0;
+        m_numSortPasses = 0;
+        // (no keys to compare with next time)
+        m_keys.clear();
+        m_pairs.clear();
+        for( size_t i = first; i < last; i++ )
+        {
+            const YDrawItem & item = list.item( i );
+            THEREMAXSpark * spark = (THEREMAXSpark *)item.entity;
+            emit( vertices, spark, spark->vertices, spark->drawAlpha(), *item.world );
+        }
+    }
+
+    m_collectTime = XFun::now() - start;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: sort()
+// desc: least significant digit radix sort of the (key, quad) pairs by key
+//       (stable: equal depths keep draw list order); the key is the high
+//       word, so each pair moves as one value
+//-----------------------------------------------------------------------------
+void THEREMAXSparkBatch::sort( unsigned int counts[][BATCH_SORT_DIGITS] )
+{
+    double start = XFun::now();
+    size_t n = m_pairs.size();
+    m_pairsTmp.resize( n );
+    m_numSortPasses = 0;
+    m_numSorted = n;
+    if( n == 0 ) { m_sortTime = 0; return; }
+
+    unsigned long long * pairs = &m_pairs[0];
+    unsigned long long * pairsOut = &m_pairsTmp[0];
+    for( int pass = 0; pass < BATCH_SORT_PASSES; pass++ )
+    {
+        // a digit every key shares moves nothing
+        int shift = 32 + pass * BATCH_SORT_BITS;
+        if( counts[pass][( pairs[0] >> shift ) & BATCH_SORT_MASK] == n ) continue;
+
+        // bucket starts
+        unsigned int offsets[BATCH_SORT_DIGITS];
+        unsigned int sum = 0;
+        for( int d = 0; d < BATCH_SORT_DIGITS; d++ )
+        {
+            offsets[d] = sum;
+            sum += counts[pass][d];
+        }
+        // scatter
+        for( size_t i = 0; i < n; i++ )
+        {
+            unsigned long long p = pairs[i];
+            pairsOut[offsets[( p >> shift ) & BATCH_SORT_MASK]++] = p;
+        }
+        std::swap( pairs, pairsOut );
+        m_numSortPasses++;
+    }
+    // odd passes left the result in the scratch
+    if( pairs != &m_pairs[0] ) m_pairs.swap( m_pairsTmp );
+
+    m_sortTime = XFun::now() - start;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: emit()
+// desc: four world-space corners for one spark
+//-----------------------------------------------------------------------------
+bool THEREMAXSparkBatch::emit( vector<THEREMAXSparkVertex> & out, YEntity * spark,
+                               const GLfloat * vertices, GLfloat alpha, const XMatrix4 & world,
+                               const GLfloat * clip, GLfloat * depth )
+{
+    // invisible
+    if( alpha <= 0 ) return false;
+
+    const GLfloat * w = world.m;
+    // clip w of the spark's origin (row 3 of the matrix)
+    if( clip ) *depth = clip[3] * w[12] + clip[7] * w[13] + clip[11] * w[14] + clip[15];
+    GLubyte r = batch_byte( spark->col.x ), g = batch_byte( spark->col.y ),
+            b = batch_byte( spark->col.z ), a = batch_byte( alpha );
+    GLfloat uv[4];
+    THEREMAXSpriteAtlas::rect( ((THEREMAXSpark *)spark)->texture, uv );
+
+    for( int i = 0; i < 4; i++ )
+    {
+        const GLfloat * v = vertices + 2 * g_corner_vertex[i];
+        THEREMAXSparkVertex corner;
+        corner.x = w[0] * v[0] + w[4] * v[1] + w[12];
+        corner.y = w[1] * v[0] + w[5] * v[1] + w[13];
+        corner.z = w[2] * v[0] + w[6] * v[1] + w[14];
+        corner.u = uv[g_corner_uv[2 * i] * 2];
+        corner.v = uv[g_corner_uv[2 * i + 1] * 2 + 1];
+        corner.r = r; corner.g = g; corner.b = b; corner.a = a;
+        out.push_back( corner );
+    }
+    return true;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: probe()
+// desc: buffer objects are core in GL 1.5
+//-----------------------------------------------------------------------------
+void THEREMAXSparkBatch::probe()
+{
+    const char * version = (const char *)glGetString( GL_VERSION );
+    int major = 0, minor = 0;
+    if( version ) sscanf( version, "%d.%d", &major, &minor );
+
+    m_mode = ( major > 1 || ( major == 1 && minor >= 5 ) ) ? MODE_BUFFER : MODE_ARRAYS;
+    if( m_mode == MODE_BUFFER )
+    {
+        glGenBuffers( 1, &m_buffer );
+        glGenBuffers( 1, &m_indexBuffer );
+    }
+
+    fprintf( stderr, "[theremax]: spark batch using %s (GL %s)\n",
+             m_mode == MODE_BUFFER ? "streamed buffer object" : "client arrays",
+             version ? version : "?" );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: draw()
+// desc: one draw call for every collected spark
+//-----------------------------------------------------------------------------
+void THEREMAXSparkBatch::draw()
+{
+    draw( m_vertices, m_indices );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: draw()
+// desc: one draw call for the given vertices, through indices if any
+//-----------------------------------------------------------------------------
+void THEREMAXSparkBatch::draw( const vector<THEREMAXSparkVertex> & vertices,
+                               const vector<GLuint> & indices )
+{
+    double start = XFun::now();
+    m_numDrawCalls = 0;
+    m_numSparks = vertices.size() / 4;
+
+    if( m_mode == MODE_UNKNOWN ) probe();
+    if( vertices.empty() ) { m_drawTime = 0; return; }
+
+    // state once (as THEREMAXSpark::render)
+    XGLState::disable( GL_DEPTH_TEST );
+    XGLState::enable( GL_TEXTURE_2D );
+    XGLState::bindTexture( m_texture );
+    XGLState::blendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    XGLState::enable( GL_BLEND );
+
+    const GLvoid * base = &vertices[0];
+    size_t bytes = vertices.size() * sizeof(THEREMAXSparkVertex);
+    if( m_mode == MODE_BUFFER )
+    {
+        glBindBuffer( GL_ARRAY_BUFFER, m_buffer );
+        // orphan last frame's storage so the driver doesn't stall on it
+        if( bytes > m_capacity ) m_capacity = bytes + bytes / 2;
+        glBufferData( GL_ARRAY_BUFFER, m_capacity, NULL, GL_STREAM_DRAW );
+        glBufferSubData( GL_ARRAY_BUFFER, 0, bytes, base );
+        base = NULL;
+    }
+
+    // interleaved
+    const GLubyte * ptr = (const GLubyte *)base;
+    GLsizei stride = sizeof(THEREMAXSparkVertex);
+    glVertexPointer( 3, GL_FLOAT, stride, ptr + offsetof( THEREMAXSparkVertex, x ) );
+    glTexCoordPointer( 2, GL_FLOAT, stride, ptr + offsetof( THEREMAXSparkVertex, u ) );
+    glColorPointer( 4, GL_UNSIGNED_BYTE, stride, ptr + offsetof( THEREMAXSparkVertex, r ) );
+    XGLState::clientArrays( XGL_VERTEX_ARRAY | XGL_TEXCOORD_ARRAY | XGL_COLOR_ARRAY );
+
+    // draw stuff!
+    if( indices.empty() )
+        glDrawArrays( GL_QUADS, 0, (GLsizei)vertices.size() );
+    else
+    {
+        // sorted: the quads as collected, in the order of the indices
+        const GLvoid * order = &indices[0];
+        bytes = indices.size() * sizeof(GLuint);
+        if( m_mode == MODE_BUFFER )
+        {
+            glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer );
+            if( bytes > m_indexCapacity ) m_indexCapacity = bytes + bytes / 2;
+            glBufferData( GL_ELEMENT_ARRAY_BUFFER, m_indexCapacity, NULL, GL_STREAM_DRAW );
+            glBufferSubData( GL_ELEMENT_ARRAY_BUFFER, 0, bytes, order );
+            order = NULL;
+        }
+        glDrawElements( GL_QUADS, (GLsizei)indices.size(), GL_UNSIGNED_INT, order );
+        if( m_mode == MODE_BUFFER ) glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+    }
+    m_numDrawCalls++;
+
+    // (state stays set for whoever draws next)
+    if( m_mode == MODE_BUFFER ) glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+    m_drawTime = XFun::now() - start;
+}
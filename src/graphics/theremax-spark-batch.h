@@ -0,0 +1,138 @@
+//-----------------------------------------------------------------------------
+// name: theremax-spark-batch.h
+// desc: draws every spark in one streamed vertex buffer
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#ifndef __THEREMAX_SPARK_BATCH_H__
+#define __THEREMAX_SPARK_BATCH_H__
+
+#include "y-drawlist.h"
+#include <vector>
+
+// depth sort digits: three passes of 11 bits cover the 32 bit key, and
+// their histograms (32 bit counts) take 24 KB
+#define BATCH_SORT_BITS 11
+#define BATCH_SORT_DIGITS ( 1 << BATCH_SORT_BITS )
+#define BATCH_SORT_MASK ( BATCH_SORT_DIGITS - 1 )
+#define BATCH_SORT_PASSES 3
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: struct THEREMAXSparkVertex
+// desc: one corner of a spark quad (world space)
+//-----------------------------------------------------------------------------
+struct THEREMAXSparkVertex
+{
+    GLfloat x, y, z;
+    GLfloat u, v;
+    GLubyte r, g, b, a;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class THEREMAXSparkBatch
+// desc: turns the sparks of a draw list into world-space quads, then draws
+//       them with one call; GL state is set once per batch instead of once
+//       per spark. Given a camera, collect() orders the quads back to front:
+//       while building a quad, its depth becomes an integer key that orders
+//       as the float does and is counted into the digit histograms; a radix
+//       sort of (key, quad) pairs (a scatter per 11 bit digit that isn't the
+//       same for every key) then gives the indices to draw the quads by, in
+//       O(n) and without moving them. If every key is what it was last time,
+//       the last order is drawn again
+//-----------------------------------------------------------------------------
+class THEREMAXSparkBatch
+{
+public:
+    THEREMAXSparkBatch();
+    ~THEREMAXSparkBatch();
+
+public:
+    // gather the sparks in [first, last) of a sorted draw list; with clip
+    // (world -> clip space), farthest first by clip w (view depth under a
+    // perspective projection), else in draw list order
+    void collect( const YDrawList & list, size_t first, size_t last,
+                  const XMatrix4 * clip = NULL );
+    // draw what was collected (needs a current GL context)
+    void draw();
+    // same, into / out of caller-owned vertices and indices (collect needs
+    // no GL, so it can run on another thread than draw); the indices give
+    // the sorted order, empty if unsorted (the vertices are in list order)
+    void collect( const YDrawList & list, size_t first, size_t last,
+                  std::vector<THEREMAXSparkVertex> & vertices,
+                  std::vector<GLuint> & indices, const XMatrix4 * clip = NULL );
+    void draw( const std::vector<THEREMAXSparkVertex> & vertices,
+               const std::vector<GLuint> & indices );
+    // release GL objects (needs the context they were made in)
+    void cleanup();
+    // sprite atlas to texture with (0: untextured)
+    void setTexture( GLuint texture ) { m_texture = texture; }
+
+public:
+    // sparks in the last draw
+    size_t numSparks() const { return m_numSparks; }
+    // draw calls in the last draw
+    unsigned long numDrawCalls() const { return m_numDrawCalls; }
+    // streaming through a buffer object (else client arrays)
+    bool usingBuffer() const { return m_mode == MODE_BUFFER; }
+    // last collect / draw (CPU side, seconds)
+    double collectTime() const { return m_collectTime; }
+    double drawTime() const { return m_drawTime; }
+    // last depth sort (radix passes, within collectTime; 0 if unsorted or
+    // reused), the sparks in it and the digit passes it needed
+    double sortTime() const { return m_sortTime; }
+    size_t numSorted() const { return m_numSorted; }
+    int numSortPasses() const { return m_numSortPasses; }
+    // sorts skipped because every key matched the last collect's
+    unsigned long numReused() const { return m_numReused; }
+
+protected:
+    // spark quad (false: invisible, nothing added); with clip, also the
+    // clip w of its origin
+    static bool emit( std::vector<THEREMAXSparkVertex> & out, YEntity * spark,
+                      const GLfloat * vertices, GLfloat alpha, const XMatrix4 & world,
+                      const GLfloat * clip = NULL, GLfloat * depth = NULL );
+    // pick buffer object or client arrays
+    void probe();
+    // m_pairs back to front (counts: the histogram of each key digit)
+    void sort( unsigned int counts[][BATCH_SORT_DIGITS] );
+
+protected:
+    enum { MODE_UNKNOWN, MODE_BUFFER, MODE_ARRAYS };
+    int m_mode;
+    // streamed buffers (vertices, sorted indices) and their sizes in bytes
+    GLuint m_buffer;
+    size_t m_capacity;
+    GLuint m_indexBuffer;
+    size_t m_indexCapacity;
+    // atlas
+    GLuint m_texture;
+    // this frame's vertices and indices
+    std::vector<THEREMAXSparkVertex> m_vertices;
+    std::vector<GLuint> m_indices;
+    // depth sort: keys by quad, (key << 32 | quad) pairs in sorted order
+    // (kept: reused while the keys don't change), and the radix scratch
+    std::vector<unsigned int> m_keys;
+    std::vector<unsigned long long> m_pairs;
+    std::vector<unsigned long long> m_pairsTmp;
+    // stats
+    size_t m_numSparks;
+    unsigned long m_numDrawCalls;
+    double m_collectTime;
+    double m_drawTime;
+    double m_sortTime;
+    size_t m_numSorted;
+    int m_numSortPasses;
+    unsigned long m_numReused;
+};
+
+
+
+
+#endif
@@ -0,0 +1,1458 @@
+//-----------------------------------------------------------------------------
+// name: theremax-bench.cpp
+// desc: headless benchmarks for the theremax simulation (no window, no GLUT
+//       context, no camera)
+//
+//   usage: theremax-bench [--steps N] [--seed S] [--lod]
+//                         [--flocks 10,100,...] [--boids 10,100,...]
+//                         [--load snapshot] [--save snapshot] [--render N]
+//                         [--no-state-cache] [--recursive-update]
+//                         [--population] [--profile file]
+//                         [--particles 1000,10000,...]
+//                         [--audio 100,500,2000,...]
+//                         [--sort 20000,200000,...]
+//                         [--fft 256,1024,8192,...]
+//
+//   --load starts from a snapshot instead of a random scene (one row);
+//   --save writes the scene after the run (the last row, with a matrix);
+//   --render draws N frames per render path (recursive drawAll, draw list,
+//   draw list + spark batch) into an offscreen (EGL) buffer;
+//   --no-state-cache issues every GL state call (to compare with the cache);
+//   --recursive-update steps with updateAll instead of the type-batched pass;
+//   --population lets the flock population follow the cv schedule (half to
+//   all of the flocks and boids) and counts allocations while it does;
+//   --profile steps again timing each entity type (and draws, with
+//   --render), prints the per type table and writes it to file (.json for
+//   JSON, else CSV; the last row's)
+//   --particles runs the particle system instead: each count under four
+//   influences, the old per particle update against the batched one, then
+//   as a burst (capacity count, 1% live and replaced as they go)
+//   --audio runs the audio emitter instead, on a synthetic signal analysed
+//   as it would be live, once per emitter budget (microseconds per frame)
+//   --sort collects about that many sparks (flocks of 100 boids) as the
+//   camera orbits, in draw list order and depth sorted (then sorted again
+//   with nothing moved, which reuses the order), checks the sorted quads go
+//   back to front and compares the radix sort with a stable_sort
+//   --fft times rfft of each size both ways, the original CARL code against
+//   YFFTPlan (microseconds per transform), with the largest differences
+//
+// author: Myles Borins
+//   date: 2013
+//-----------------------------------------------------------------------------
+#include "theremax-globals.h"
+#include "theremax-sim.h"
+#include "theremax-render-state.h"
+#include "theremax-flocking.h"
+#include "theremax-snapshot.h"
+#include "theremax-offscreen.h"
+#include "x-fun.h"
+#include "y-slab.h"
+#include "y-particle.h"
+#include "theremax-analysis.h"
+#include "theremax-emitter.h"
+#include "y-fft.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <stdlib.h>
+#include <new>
+#include <algorithm>
+#include <vector>
+#include <string>
+using namespace std;
+
+
+
+
+// defaults
+#define BENCH_DEFAULT_STEPS 60
+#define BENCH_DEFAULT_SEED  1234
+#define BENCH_FRAME_RATE    60.0
+// period (in steps) of the cvIntensity schedule
+#define BENCH_CV_PERIOD     240
+// --particles influences (gravity is along y)
+#define BENCH_PARTICLE_GRAVITY -9.8f
+#define BENCH_PARTICLE_DRAG     0.5f
+#define BENCH_PARTICLE_ATTRACT  2.0f
+#define BENCH_PARTICLE_NOISE    4.0f
+// --audio signal: a kick (Hz, per second) under a sweep (Hz, over the cv
+// period), with hats
+#define BENCH_AUDIO_KICK        60.0
+#define BENCH_AUDIO_KICK_RATE   2.0
+#define BENCH_AUDIO_SWEEP_LOW   200.0
+#define BENCH_AUDIO_SWEEP_HIGH  8000.0
+// --sort flock size, and camera orbit (radians per step)
+#define BENCH_SORT_BOIDS 100
+#define BENCH_SORT_ORBIT 0.01
+// --fft points transformed per timing (split into transforms of the size)
+#define BENCH_FFT_POINTS (1L << 22)
+// offscreen buffer for --render
+#define BENCH_RENDER_WIDTH  1280
+#define BENCH_RENDER_HEIGHT 720
+
+// GL state calls per frame in the last bench_render()
+static double g_stateIssued = 0;
+static double g_stateSkipped = 0;
+// main run uses the batched pass (as the sim does), else updateAll
+static bool g_batchedUpdate = true;
+// population follows the cv schedule
+static bool g_population = false;
+// per type profile written here (NULL: none)
+static const char * g_profile = NULL;
+// heap allocations so far (see operator new below)
+static unsigned long g_allocations = 0;
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: operator new() / operator delete()
+// desc: the global heap, counted; every form is replaced (scalar and array,
+//       nothrow, sized deletes) so all of them count and pair with free()
+//-----------------------------------------------------------------------------
+static void * bench_allocate( size_t size )
+{
+    g_allocations++;
+    return malloc( size ? size : 1 );
+}
+
+void * operator new( size_t size )
+{
+    void * p = bench_allocate( size );
+    if( !p ) throw std::bad_alloc();
+    return p;
+}
+
+void * operator new[]( size_t size )
+{
+    void * p = bench_allocate( size );
+    if( !p ) throw std::bad_alloc();
+    return p;
+}
+
+void * operator new( size_t size, const std::nothrow_t & ) throw()
+{
+    return bench_allocate( size );
+}
+
+void * operator new[]( size_t size, const std::nothrow_t & ) throw()
+{
+    return bench_allocate( size );
+}
+
+void operator delete( void * p ) throw()
+{
+    free( p );
+}
+
+void operator delete[]( void * p ) throw()
+{
+    free( p );
+}
+
+void operator delete( void * p, size_t ) throw()
+{
+    free( p );
+}
+
+void operator delete[]( void * p, size_t ) throw()
+{
+    free( p );
+}
+
+void operator delete( void * p, const std::nothrow_t & ) throw()
+{
+    free( p );
+}
+
+void operator delete[]( void * p, const std::nothrow_t & ) throw()
+{
+    free( p );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_now()
+// desc: monotonic time in nanoseconds
+//-----------------------------------------------------------------------------
+static double bench_now()
+{
+    return XFun::now() * 1e9;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_rss_kb()
+// desc: resident set size in KB (peak if current is unavailable)
+//-----------------------------------------------------------------------------
+static long bench_rss_kb()
+{
+#ifdef __linux
+    // current resident pages
+    FILE * f = fopen( "/proc/self/statm", "r" );
+    if( f )
+    {
+        long size = 0, resident = 0;
+        int n = fscanf( f, "%ld %ld", &size, &resident );
+        fclose( f );
+        if( n == 2 ) return resident * ( sysconf( _SC_PAGESIZE ) / 1024 );
+    }
+#endif
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+#ifdef __APPLE__
+    // bytes on OS X
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_parse_list()
+// desc: parse "a,b,c" into a list of counts
+//-----------------------------------------------------------------------------
+static vector<long> bench_parse_list( const char * str )
+{
+    vector<string> tokens;
+    vector<long> result;
+    XFun::tokenize( str, tokens, "," );
+    for( size_t i = 0; i < tokens.size(); i++ )
+        if( atol( tokens[i].c_str() ) > 0 )
+            result.push_back( atol( tokens[i].c_str() ) );
+    return result;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_cv_schedule()
+// desc: fixed cvIntensity schedule (sweeps through the tendToPlace regime)
+//-----------------------------------------------------------------------------
+static SAMPLE bench_cv_schedule( long step )
+{
+    return (SAMPLE)( 0.5 + 0.45 * sin( TWO_PI * step / BENCH_CV_PERIOD ) );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_render_setup()
+// desc: GL state and camera as initialize_graphics() / look() set them
+//-----------------------------------------------------------------------------
+static void bench_render_setup()
+{
+    glViewport( 0, 0, BENCH_RENDER_WIDTH, BENCH_RENDER_HEIGHT );
+    glClearColor( 0, 0, 0, 1 );
+    glShadeModel( GL_SMOOTH );
+    // (whatever the context had is unknown to the state cache)
+    XGLState::invalidate();
+    XGLState::enable( GL_DEPTH_TEST );
+    XGLState::enable( GL_LIGHTING );
+    glColorMaterial( GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE );
+    XGLState::enable( GL_COLOR_MATERIAL );
+    XGLState::enable( GL_NORMALIZE );
+    glEnable( GL_LIGHT0 );
+
+    glMatrixMode( GL_PROJECTION );
+    glLoadIdentity();
+    gluPerspective( Globals::fov.value, (GLfloat)BENCH_RENDER_WIDTH / BENCH_RENDER_HEIGHT, .005, 500.0 );
+    glMatrixMode( GL_MODELVIEW );
+    glLoadIdentity();
+    gluLookAt( 0.0f, Globals::viewRadius.x * sin( Globals::viewEyeY.x ),
+               Globals::viewRadius.x * cos( Globals::viewEyeY.x ),
+               0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_render()
+// desc: ms per frame (CPU submit + finish) drawing the scene frames times;
+//       recursive draws with drawAll() instead of the sim's draw list
+//-----------------------------------------------------------------------------
+static double bench_render( THEREMAXSim * sim, long frames, GLboolean batch, bool recursive )
+{
+    Globals::sparkBatch = batch;
+    double start = 0;
+    g_stateIssued = g_stateSkipped = 0;
+    for( long f = -1; f < frames; f++ )
+    {
+        // first frame is warm up (allocates)
+        if( f == 0 ) { glFinish(); start = bench_now(); }
+        // (renders leave depth writes as they set them)
+        XGLState::depthMask( GL_TRUE );
+        glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+        if( recursive ) sim->root().drawAll();
+        else sim->systemRender();
+        theremax_offscreen_swap();
+        XGLState::endFrame();
+        if( f < 0 ) continue;
+        g_stateIssued += XGLState::numIssued();
+        g_stateSkipped += XGLState::numSkipped();
+    }
+    if( frames > 0 ) { g_stateIssued /= frames; g_stateSkipped /= frames; }
+    glFinish();
+    return frames > 0 ? ( bench_now() - start ) / 1e6 / frames : 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_update()
+// desc: update the scene steps times, batched or recursive; ns per node
+//-----------------------------------------------------------------------------
+static double bench_update( THEREMAXSim * sim, long steps, bool batched )
+{
+    YTimeInterval dt = 1.0 / BENCH_FRAME_RATE;
+    YUpdateScheduler & updater = sim->updater();
+    // gather outside the timing
+    updater.update( sim->root(), dt );
+
+    double start = bench_now();
+    for( long s = 0; s < steps; s++ )
+    {
+        if( batched ) updater.update( sim->root(), dt );
+        else sim->root().updateAll( dt );
+    }
+    double nodes = (double)updater.numNodes() * steps;
+    return nodes > 0 ? ( bench_now() - start ) / nodes : 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_prepare()
+// desc: draw list prepare (no GL, no culling) after each of steps steps
+//       (0: the scene as it is, again); ms per prepare
+//-----------------------------------------------------------------------------
+static double bench_prepare( THEREMAXSim * sim, long steps )
+{
+    YTimeInterval dt = 1.0 / BENCH_FRAME_RATE;
+    YDrawList & list = sim->drawList();
+    double total = 0;
+    long count = steps > 0 ? steps : 1;
+    for( long s = 0; s < count; s++ )
+    {
+        if( steps > 0 ) sim->step( dt );
+        double start = bench_now();
+        list.prepare( &sim->root() );
+        total += bench_now() - start;
+    }
+    return total / 1e6 / count;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_profile()
+// desc: steps more steps with the profiler on (drawing each one if render),
+//       then the per type table
+//-----------------------------------------------------------------------------
+static void bench_profile( THEREMAXSim * sim, long steps, long render, const char * path )
+{
+    YTimeInterval dt = 1.0 / BENCH_FRAME_RATE;
+    YSceneProfiler & profiler = sim->profiler();
+    Globals::sparkBatch = GL_TRUE;
+    sim->setProfiling( true );
+    for( long s = 0; s < steps; s++ )
+    {
+        sim->step( dt );
+        if( render <= 0 ) continue;
+        XGLState::depthMask( GL_TRUE );
+        glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+        sim->systemRender();
+        theremax_offscreen_swap();
+        XGLState::endFrame();
+    }
+    sim->setProfiling( false );
+
+    profiler.census( sim->root() );
+    profiler.report();
+    bool saved = profiler.save( path );
+    fprintf( stdout, "%8s profile %lu types, %lu hotspots, census:%.2fms%s%s\n", "",
+             (unsigned long)profiler.numTypes(), (unsigned long)profiler.numHotspots(),
+             profiler.censusTime() * 1000, saved ? ", written to " : "", saved ? path : "" );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class BenchOldParticle
+// desc: YParticle as it was (state in the object, eleven slews in update),
+//       with velocity moving the offsets as YParticleSystem does now
+//-----------------------------------------------------------------------------
+class BenchOldParticle : public YFlare
+{
+public:
+    BenchOldParticle() : seed( 1 )
+    {
+        X.slew = Y.slew = Z.slew = 1;
+        ALPHA.set( 1, 1, 1 );
+        oriX.slew = oriY.slew = oriZ.slew = 1;
+        multiplier.set( 1, 1, 1 );
+    }
+
+    void update( YTimeInterval dt )
+    {
+        GLfloat delta = dt;
+        dX.value += vel.x * delta; dX.goal += vel.x * delta;
+        dY.value += vel.y * delta; dY.goal += vel.y * delta;
+        dZ.value += vel.z * delta; dZ.goal += vel.z * delta;
+        X.interp( dt ); Y.interp( dt ); Z.interp( dt );
+        dX.interp( dt ); dY.interp( dt ); dZ.interp( dt );
+        ALPHA.interp( dt );
+        oriX.interp( dt ); oriY.interp( dt ); oriZ.interp( dt );
+        multiplier.interp( dt );
+        loc.x = X.value * multiplier.value + dX.value;
+        loc.y = Y.value * multiplier.value + dY.value;
+        loc.z = Z.value * multiplier.value + dZ.value;
+        alpha = ALPHA.value;
+        ori.set( oriX.value, oriY.value, oriZ.value );
+    }
+
+public:
+    Vector3D multiplier, X, Y, Z, dX, dY, dZ, ALPHA, oriX, oriY, oriZ;
+    unsigned int seed;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: class BenchOldInfluence
+// desc: the old interface, one virtual call per particle; the four kernels
+//       do the same arithmetic as YParticleGravity / Drag / Attractor / Noise
+//-----------------------------------------------------------------------------
+class BenchOldInfluence
+{
+public:
+    BenchOldInfluence( int _kind ) : kind( _kind ) { }
+    virtual ~BenchOldInfluence() { }
+    virtual void update( BenchOldParticle * p, YTimeInterval dt )
+    {
+        GLfloat k;
+        switch( kind )
+        {
+        case 0: // gravity
+            k = BENCH_PARTICLE_GRAVITY * dt;
+            p->vel.y += k;
+            break;
+        case 1: // drag
+            k = 1 - BENCH_PARTICLE_DRAG * dt;
+            p->vel *= k;
+            break;
+        case 2: // attraction to the origin
+            k = BENCH_PARTICLE_ATTRACT * dt;
+            p->vel.x += ( 0 - p->loc.x ) * k;
+            p->vel.y += ( 0 - p->loc.y ) * k;
+            p->vel.z += ( 0 - p->loc.z ) * k;
+            break;
+        default: // noise (as YParticleNoise)
+            k = BENCH_PARTICLE_NOISE * dt;
+            for( int a = 0; a < 3; a++ )
+            {
+                unsigned int & s = p->seed;
+                s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+                p->vel[a] += ( (GLfloat)(int)( s >> 8 ) * ( 2.0f / 16777215.0f ) - 1.0f ) * k;
+            }
+            break;
+        }
+    }
+    int kind;
+};
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_particles_old()
+// desc: YParticleSystem::update as it was: influences x particles with an
+//       active check, updateAll per particle, then a pack; returns the
+//       number active
+//-----------------------------------------------------------------------------
+static int bench_particles_old( vector<BenchOldParticle *> & particles,
+                                vector<BenchOldInfluence *> & influences, YTimeInterval dt )
+{
+    for( size_t i = 0; i < influences.size(); i++ )
+        for( size_t j = 0; j < particles.size(); j++ )
+            if( particles[j]->active )
+                influences[i]->update( particles[j], dt );
+    for( size_t i = 0; i < particles.size(); i++ )
+        if( particles[i]->active )
+            particles[i]->updateAll( dt );
+    size_t count = 0;
+    for( size_t i = 0; i < particles.size(); i++ )
+    {
+        if( !particles[i]->active ) continue;
+        if( i != count ) std::swap( particles[i], particles[count] );
+        count++;
+    }
+    return (int)count;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_particles()
+// desc: n particles under gravity, drag, attraction and noise, exploding
+//       from the origin; the old and the batched update, particles per ms
+//-----------------------------------------------------------------------------
+static void bench_particles( long n, long steps, unsigned int seed )
+{
+    YTimeInterval dt = 1.0 / BENCH_FRAME_RATE;
+
+    // the old way
+    XFun::srand( seed );
+    vector<BenchOldParticle *> oldParticles;
+    vector<BenchOldInfluence *> oldInfluences;
+    for( long i = 0; i < n; i++ )
+    {
+        BenchOldParticle * p = new BenchOldParticle();
+        // as YParticleData::push
+        p->seed = ( ( (unsigned int)i * 2654435761u ) ^ 0x9e3779b9u ) | 1;
+        p->X.update( XFun::rand2f( -1, 1 ), 2 );
+        p->Y.update( XFun::rand2f( -1, 1 ), 2 );
+        p->Z.update( XFun::rand2f( 0, 2 ), 2 );
+        p->oriX.update( XFun::rand2f( -90, 90 ), 1 );
+        p->oriY.update( XFun::rand2f( -90, 90 ), 1 );
+        p->oriZ.update( XFun::rand2f( -90, 90 ), 1 );
+        oldParticles.push_back( p );
+    }
+    for( int k = 0; k < 4; k++ )
+        oldInfluences.push_back( new BenchOldInfluence( k ) );
+
+    // batched
+    XFun::srand( seed );
+    YParticleSystem * system = new YParticleSystem();
+    for( long i = 0; i < n; i++ )
+        system->addParticle( new YParticle() );
+    system->explode( 2, 1, 90, 2, 1 );
+    for( long i = 0; i < n; i++ )
+        system->spawn();
+    system->addInfluence( new YParticleGravity( Vector3D( 0, BENCH_PARTICLE_GRAVITY, 0 ) ) );
+    system->addInfluence( new YParticleDrag( BENCH_PARTICLE_DRAG ) );
+    system->addInfluence( new YParticleAttractor( Vector3D( 0, 0, 0 ), BENCH_PARTICLE_ATTRACT ) );
+    system->addInfluence( new YParticleNoise( BENCH_PARTICLE_NOISE ) );
+
+    double t0 = bench_now();
+    for( long s = 0; s < steps; s++ )
+        bench_particles_old( oldParticles, oldInfluences, dt );
+    double t1 = bench_now();
+    for( long s = 0; s < steps; s++ )
+        system->update( dt );
+    double t2 = bench_now();
+
+    // same arithmetic, so the same places
+    GLfloat diff = 0;
+    vector<YParticle *> & particles = system->getParticles();
+    for( long i = 0; i < n; i++ )
+    {
+        Vector3D d = particles[i]->loc - oldParticles[i]->loc;
+        diff = max( diff, max( fabsf( d.x ), max( fabsf( d.y ), fabsf( d.z ) ) ) );
+    }
+
+    double work = (double)n * steps;
+    double oldRate = t1 > t0 ? work / ( ( t1 - t0 ) / 1e6 ) : 0;
+    double newRate = t2 > t1 ? work / ( ( t2 - t1 ) / 1e6 ) : 0;
+    fprintf( stdout, "%10ld %6ld %14.0f %14.0f %8.2fx %10g\n", n, steps, oldRate, newRate,
+             oldRate > 0 ? newRate / oldRate : 0, diff );
+    fflush( stdout );
+
+    // clean up
+    for( size_t i = 0; i < oldParticles.size(); i++ ) SAFE_DELETE( oldParticles[i] );
+    for( size_t i = 0; i < oldInfluences.size(); i++ ) SAFE_DELETE( oldInfluences[i] );
+    for( size_t i = 0; i < particles.size(); i++ ) SAFE_DELETE( particles[i] );
+    SAFE_DELETE( system );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_particles_burst()
+// desc: capacity n with 1% live, a tenth of those replaced each step; the
+//       old update (over the capacity) against the live span, us per step
+//-----------------------------------------------------------------------------
+static void bench_particles_burst( long n, long steps )
+{
+    YTimeInterval dt = 1.0 / BENCH_FRAME_RATE;
+    long live = n / 100 > 0 ? n / 100 : 1;
+    long churn = live / 10 > 0 ? live / 10 : 1;
+
+    // the old way: spawn took the slot past the last pack, kill cleared active
+    vector<BenchOldParticle *> oldParticles;
+    vector<BenchOldInfluence *> oldInfluences;
+    for( long i = 0; i < n; i++ )
+    {
+        oldParticles.push_back( new BenchOldParticle() );
+        oldParticles[i]->active = i < live;
+    }
+    for( int k = 0; k < 4; k++ )
+        oldInfluences.push_back( new BenchOldInfluence( k ) );
+
+    // live span
+    YParticleSystem * system = new YParticleSystem();
+    for( long i = 0; i < n; i++ )
+    {
+        YParticle * p = new YParticle();
+        p->active = false;
+        system->addParticle( p );
+    }
+    for( long i = 0; i < live; i++ )
+        system->spawn();
+    system->addInfluence( new YParticleGravity( Vector3D( 0, BENCH_PARTICLE_GRAVITY, 0 ) ) );
+    system->addInfluence( new YParticleDrag( BENCH_PARTICLE_DRAG ) );
+    system->addInfluence( new YParticleAttractor( Vector3D( 0, 0, 0 ), BENCH_PARTICLE_ATTRACT ) );
+    system->addInfluence( new YParticleNoise( BENCH_PARTICLE_NOISE ) );
+
+    double t0 = bench_now();
+    for( long s = 0; s < steps; s++ )
+    {
+        int count = bench_particles_old( oldParticles, oldInfluences, dt );
+        for( long c = 0; c < churn; c++ )
+        {
+            oldParticles[c]->active = false;
+            oldParticles[count + c]->activate();
+        }
+    }
+    double t1 = bench_now();
+    vector<YParticle *> & particles = system->getParticles();
+    for( long s = 0; s < steps; s++ )
+    {
+        system->update( dt );
+        for( long c = 0; c < churn; c++ )
+        {
+            system->kill( particles[0] );
+            system->spawn();
+        }
+    }
+    double t2 = bench_now();
+
+    fprintf( stdout, "%10ld burst %ld live, %ld replaced/step: old %.1fus/step, live span "
+             "%.1fus/step (%lu live, %lu spawned, %lu killed)\n", n, live, churn,
+             ( t1 - t0 ) / 1e3 / steps, ( t2 - t1 ) / 1e3 / steps,
+             (unsigned long)system->numActive(), system->numSpawned(), system->numKilled() );
+    fflush( stdout );
+
+    // clean up
+    for( size_t i = 0; i < oldParticles.size(); i++ ) SAFE_DELETE( oldParticles[i] );
+    for( size_t i = 0; i < oldInfluences.size(); i++ ) SAFE_DELETE( oldInfluences[i] );
+    for( size_t i = 0; i < particles.size(); i++ ) SAFE_DELETE( particles[i] );
+    SAFE_DELETE( system );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_audio_signal()
+// desc: next buffer of the --audio signal (stereo); t is in samples
+//-----------------------------------------------------------------------------
+static void bench_audio_signal( SAMPLE * buffer, unsigned int frames, double & t, double & phase )
+{
+    double period = BENCH_CV_PERIOD / BENCH_FRAME_RATE;
+    for( unsigned int i = 0; i < frames; i++, t++ )
+    {
+        double sec = t / THEREMAX_SRATE;
+        // kick: decaying sine on each beat
+        double beat = fmod( sec * BENCH_AUDIO_KICK_RATE, 1.0 );
+        double kick = sin( 2 * M_PI * BENCH_AUDIO_KICK * sec ) * exp( -8 * beat );
+        // sweep up and back over the period
+        double s = fmod( sec / period, 1.0 );
+        s = s < 0.5 ? s * 2 : 2 - s * 2;
+        phase += 2 * M_PI * BENCH_AUDIO_SWEEP_LOW * pow( BENCH_AUDIO_SWEEP_HIGH / BENCH_AUDIO_SWEEP_LOW, s )
+                 / THEREMAX_SRATE;
+        double sweep = 0.3 * sin( phase );
+        // hats: noise on the off beat
+        double hat = beat > 0.5 && beat < 0.55 ? XFun::rand2f( -0.2, 0.2 ) : 0;
+        SAMPLE v = (SAMPLE)( 0.5 * kick + sweep + hat );
+        buffer[i * 2] = buffer[i * 2 + 1] = v;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_audio()
+// desc: the emitter in a sim, with the budget given, fed bands from the
+//       analysis of a synthetic signal (pushed and processed buffer by
+//       buffer as the audio and analysis threads would); report prints the
+//       bands at the end
+//-----------------------------------------------------------------------------
+static void bench_audio( long budget, long steps, unsigned int seed, bool report )
+{
+    XFun::srand( seed );
+    for( int b = 0; b < THEREMAX_AUDIO_BANDS; b++ ) Globals::audioBands[b] = 0;
+
+    THEREMAXAudioAnalysis * analysis = new THEREMAXAudioAnalysis();
+    analysis->init( THEREMAX_SRATE, THEREMAX_FRAMESIZE );
+    THEREMAXSim * sim = new THEREMAXSim();
+    THEREMAXAudioEmitter * emitter = new THEREMAXAudioEmitter();
+    emitter->budget = budget / 1e6;
+    sim->setEmitter( emitter );
+    // publish bakes the emitter's quads (its render cost)
+    THEREMAXRenderState state;
+
+    vector<SAMPLE> buffer( THEREMAX_FRAMESIZE * 2 );
+    double t = 0, phase = 0, audioTime = 0;
+    double dt = 1 / BENCH_FRAME_RATE;
+    double emitTime = 0, maxEmit = 0, live = 0;
+    size_t maxLive = 0;
+    for( long s = 0; s < steps; s++ )
+    {
+        // the audio that played during the frame
+        while( t < ( s + 1 ) * dt * THEREMAX_SRATE )
+        {
+            bench_audio_signal( &buffer[0], THEREMAX_FRAMESIZE, t, phase );
+            analysis->push( &buffer[0], THEREMAX_FRAMESIZE, 2 );
+        }
+        double a0 = bench_now();
+        analysis->process();
+        audioTime += bench_now() - a0;
+
+        sim->step( dt );
+        sim->publish( state, NULL );
+        emitTime += emitter->updateTime();
+        if( emitter->updateTime() > maxEmit ) maxEmit = emitter->updateTime();
+        live += emitter->numActive();
+        if( emitter->numActive() > maxLive ) maxLive = emitter->numActive();
+    }
+
+    fprintf( stdout, "%10.3f %8.3f %8.3f %8.0f %8lu %8lu %8lu %10.3f %10.3f\n",
+             budget / 1e3, emitTime / steps * 1e3, maxEmit * 1e3, live / steps,
+             (unsigned long)maxLive, (unsigned long)emitter->cap(), emitter->numDenied(),
+             emitter->cost() * 1e6, audioTime / 1e6 / steps );
+    fflush( stdout );
+    if( report ) analysis->report();
+
+    // clean up
+    sim->setEmitter( NULL );
+    SAFE_DELETE( emitter );
+    SAFE_DELETE( sim );
+    SAFE_DELETE( analysis );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_sort_camera()
+// desc: world -> clip for the default view orbited by angle about y; only
+//       the w row (depth along the view) is filled in
+//-----------------------------------------------------------------------------
+static XMatrix4 bench_sort_camera( double angle )
+{
+    GLfloat r = Globals::viewRadius.x * cos( Globals::viewEyeY.x );
+    Vector3D eye( r * sin( angle ), Globals::viewRadius.x * sin( Globals::viewEyeY.x ),
+                  r * cos( angle ) );
+    // looking at the origin
+    Vector3D f = eye * -1;
+    f.normalize();
+    XMatrix4 clip;
+    clip.m[3] = f.x; clip.m[7] = f.y; clip.m[11] = f.z;
+    clip.m[15] = -( f * eye );
+    return clip;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_sort_key()
+// desc: (depth, draw list offset), farthest first (for stable_sort)
+//-----------------------------------------------------------------------------
+static bool bench_sort_key( const pair<GLfloat, unsigned int> & a, const pair<GLfloat, unsigned int> & b )
+{
+    return a.first > b.first;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_sort()
+// desc: about n sparks, collected unsorted / sorted each step as the camera
+//       orbits, then sorted again as they are; sorted output checked back to
+//       front, and a stable_sort of the same depths for comparison
+//-----------------------------------------------------------------------------
+static void bench_sort( long n, long steps, unsigned int seed )
+{
+    XFun::srand( seed );
+    Globals::cvIntensity = bench_cv_schedule( 0 );
+    THEREMAXSim * sim = new THEREMAXSim();
+    long flocks = ( n + BENCH_SORT_BOIDS - 1 ) / BENCH_SORT_BOIDS;
+    for( long i = 0; i < flocks; i++ )
+        sim->population().spawnFlock( BENCH_SORT_BOIDS );
+
+    YTimeInterval dt = 1.0 / BENCH_FRAME_RATE;
+    YDrawList & list = sim->drawList();
+    THEREMAXSparkBatch & batch = sim->sparkBatch();
+    vector<THEREMAXSparkVertex> vertices;
+    vector<GLuint> indices;
+    vector< pair<GLfloat, unsigned int> > reference;
+    double plain = 0, sorted = 0, sortOnly = 0, stl = 0, maxSort = 0, still = 0;
+    int passes = 0;
+    size_t sparks = 0;
+    long disorder = 0;
+    for( long s = 0; s < steps; s++ )
+    {
+        sim->step( dt );
+        list.prepare( &sim->root() );
+        list.sort();
+        size_t first = list.lowerBound( THEREMAX_DRAW_KEY_SPARK );
+        size_t last = list.lowerBound( THEREMAX_DRAW_KEY_SPARK_END );
+        sparks = last - first;
+        XMatrix4 clip = bench_sort_camera( s * BENCH_SORT_ORBIT );
+        const GLfloat * c = clip.m;
+
+        double t0 = bench_now();
+        batch.collect( list, first, last, vertices, indices );
+        double t1 = bench_now();
+        batch.collect( list, first, last, vertices, indices, &clip );
+        double t2 = bench_now();
+        plain += t1 - t0;
+        sorted += t2 - t1;
+        sortOnly += batch.sortTime();
+        if( batch.sortTime() > maxSort ) maxSort = batch.sortTime();
+        passes = batch.numSortPasses();
+        // nothing moved: the keys match, the order is reused
+        batch.collect( list, first, last, vertices, indices, &clip );
+        still += bench_now() - t2;
+
+        // back to front (a quad's corners average to its origin)
+        GLfloat previous = 0;
+        for( size_t q = 0; q + 3 < indices.size(); q += 4 )
+        {
+            GLfloat x = 0, y = 0, z = 0;
+            for( int k = 0; k < 4; k++ )
+            {
+                const THEREMAXSparkVertex & v = vertices[indices[q + k]];
+                x += v.x; y += v.y; z += v.z;
+            }
+            GLfloat depth = ( c[3] * x + c[7] * y + c[11] * z ) / 4 + c[15];
+            if( q > 0 && depth > previous + 1e-4f ) disorder++;
+            previous = depth;
+        }
+
+        // the same depths through stable_sort
+        double t3 = bench_now();
+        reference.resize( sparks );
+        for( size_t i = 0; i < sparks; i++ )
+        {
+            const GLfloat * w = list.item( first + i ).world->m;
+            reference[i].first = c[3] * w[12] + c[7] * w[13] + c[11] * w[14] + c[15];
+            reference[i].second = (unsigned int)i;
+        }
+        std::stable_sort( reference.begin(), reference.end(), bench_sort_key );
+        stl += bench_now() - t3;
+    }
+
+    fprintf( stdout, "%10lu %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f %7d %10s\n",
+             (unsigned long)sparks, plain / 1e6 / steps, sorted / 1e6 / steps,
+             sortOnly * 1e3 / steps, maxSort * 1e3, still / 1e6 / steps,
+             stl / 1e6 / steps, passes, disorder ? "NO" : "yes" );
+    fflush( stdout );
+
+    // clean up
+    sim->flockBroadphase().clear();
+    sim->root().deleteChildren();
+    SAFE_DELETE( sim );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// the CARL rfft / cfft as y-fft had them before YFFTPlan, for --fft
+//-----------------------------------------------------------------------------
+static SAMPLE g_carlPi;
+static SAMPLE g_carlTwoPi;
+static void bench_carl_cfft( SAMPLE * x, long NC, unsigned int forward );
+static void bench_carl_bit_reverse( SAMPLE * x, long N );
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_carl_rfft()
+// desc: the original rfft
+//-----------------------------------------------------------------------------
+static void bench_carl_rfft( SAMPLE * x, long N, unsigned int forward )
+{
+    static int first = 1 ;
+    SAMPLE c1, c2, h1r, h1i, h2r, h2i, wr, wi, wpr, wpi, temp, theta ;
+    SAMPLE xr, xi ;
+    long i, i1, i2, i3, i4, N2p1 ;
+
+    if( first )
+    {
+        g_carlPi = (SAMPLE) (4.*atan( 1. )) ;
+        g_carlTwoPi = (SAMPLE) (8.*atan( 1. )) ;
+        first = 0 ;
+    }
+
+    theta = g_carlPi/N ;
+    wr = 1. ;
+    wi = 0. ;
+    c1 = 0.5 ;
+
+    if( forward )
+    {
+        c2 = -0.5 ;
+        bench_carl_cfft( x, N, forward ) ;
+        xr = x[0] ;
+        xi = x[1] ;
+    }
+    else
+    {
+        c2 = 0.5 ;
+        theta = -theta ;
+        xr = x[1] ;
+        xi = 0. ;
+        x[1] = 0. ;
+    }
+    
+    wpr = (SAMPLE) (-2.*pow( sin( 0.5*theta ), 2. )) ;
+    wpi = (SAMPLE) sin( theta ) ;
+    N2p1 = (N<<1) + 1 ;
+    
+    for( i = 0 ; i <= N>>1 ; i++ )
+    {
+        i1 = i<<1 ;
+        i2 = i1 + 1 ;
+        i3 = N2p1 - i2 ;
+        i4 = i3 + 1 ;
+        if( i == 0 )
+        {
+            h1r =  c1*(x[i1] + xr ) ;
+            h1i =  c1*(x[i2] - xi ) ;
+            h2r = -c2*(x[i2] + xi ) ;
+            h2i =  c2*(x[i1] - xr ) ;
+            x[i1] =  h1r + wr*h2r - wi*h2i ;
+            x[i2] =  h1i + wr*h2i + wi*h2r ;
+            xr =  h1r - wr*h2r + wi*h2i ;
+            xi = -h1i + wr*h2i + wi*h2r ;
+        }
+        else
+        {
+            h1r =  c1*(x[i1] + x[i3] ) ;
+            h1i =  c1*(x[i2] - x[i4] ) ;
+            h2r = -c2*(x[i2] + x[i4] ) ;
+            h2i =  c2*(x[i1] - x[i3] ) ;
+            x[i1] =  h1r + wr*h2r - wi*h2i ;
+            x[i2] =  h1i + wr*h2i + wi*h2r ;
+            x[i3] =  h1r - wr*h2r + wi*h2i ;
+            x[i4] = -h1i + wr*h2i + wi*h2r ;
+        }
+
+        wr = (temp = wr)*wpr - wi*wpi + wr ;
+        wi = wi*wpr + temp*wpi + wi ;
+    }
+
+    if( forward )
+        x[1] = xr ;
+    else
+        bench_carl_cfft( x, N, forward ) ;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_carl_cfft()
+// desc: the original cfft (twiddles by recurrence, bit reversal each call)
+//-----------------------------------------------------------------------------
+static void bench_carl_cfft( SAMPLE * x, long NC, unsigned int forward )
+{
+    SAMPLE wr, wi, wpr, wpi, theta, scale ;
+    long mmax, ND, m, i, j, delta ;
+    ND = NC<<1 ;
+    bench_carl_bit_reverse( x, ND ) ;
+    
+    for( mmax = 2 ; mmax < ND ; mmax = delta )
+    {
+        delta = mmax<<1 ;
+        theta = g_carlTwoPi/( forward? mmax : -mmax ) ;
+        wpr = (SAMPLE) (-2.*pow( sin( 0.5*theta ), 2. )) ;
+        wpi = (SAMPLE) sin( theta ) ;
+        wr = 1. ;
+        wi = 0. ;
+
+        for( m = 0 ; m < mmax ; m += 2 )
+        {
+            SAMPLE rtemp, itemp ;
+            for( i = m ; i < ND ; i += delta )
+            {
+                j = i + mmax ;
+                rtemp = wr*x[j] - wi*x[j+1] ;
+                itemp = wr*x[j+1] + wi*x[j] ;
+                x[j] = x[i] - rtemp ;
+                x[j+1] = x[i+1] - itemp ;
+                x[i] += rtemp ;
+                x[i+1] += itemp ;
+            }
+
+            wr = (rtemp = wr)*wpr - wi*wpi + wr ;
+            wi = wi*wpr + rtemp*wpi + wi ;
+        }
+    }
+
+    // scale output
+    scale = (SAMPLE)(forward ? 1./ND : 2.) ;
+    {
+        SAMPLE *xi=x, *xe=x+ND ;
+        while( xi < xe )
+            *xi++ *= scale ;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_carl_bit_reverse()
+// desc: the original bit reversal
+//-----------------------------------------------------------------------------
+static void bench_carl_bit_reverse( SAMPLE * x, long N )
+{
+    SAMPLE rtemp, itemp ;
+    long i, j, m ;
+    for( i = j = 0 ; i < N ; i += 2, j += m )
+    {
+        if( j > i )
+        {
+            rtemp = x[j] ; itemp = x[j+1] ; /* complex exchange */
+            x[j] = x[i] ; x[j+1] = x[i+1] ;
+            x[i] = rtemp ; x[i+1] = itemp ;
+        }
+
+        for( m = N>>1 ; m >= 2 && j >= m ; m >>= 1 )
+            j -= m ;
+    }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_fft_error()
+// desc: largest difference, relative to the largest reference value
+//-----------------------------------------------------------------------------
+static double bench_fft_error( const SAMPLE * x, const SAMPLE * reference, long n )
+{
+    double diff = 0, peak = 0;
+    for( long i = 0; i < n; i++ )
+    {
+        diff = max( diff, (double)fabs( x[i] - reference[i] ) );
+        peak = max( peak, (double)fabs( reference[i] ) );
+    }
+    return peak > 0 ? diff / peak : diff;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_fft()
+// desc: rfft of n points both ways, the original against the plan (the
+//       same input copied in before each transform, for both); errors are
+//       against the original
+//-----------------------------------------------------------------------------
+static void bench_fft( long n, unsigned int seed )
+{
+    XFun::srand( seed );
+    vector<SAMPLE> input( n ), spectrum( n ), reference( n ), x( n );
+    for( long i = 0; i < n; i++ )
+        input[i] = (SAMPLE)XFun::rand2f( -1, 1 );
+    long reps = max( BENCH_FFT_POINTS / n, 1L );
+
+    double t0 = bench_now();
+    YFFTPlan * plan = YFFTPlan::get( n );
+    double build = bench_now() - t0;
+    if( !plan )
+    {
+        fprintf( stderr, "[theremax-bench]: --fft %ld: not a power of 2\n", n );
+        return;
+    }
+
+    // forward
+    t0 = bench_now();
+    for( long r = 0; r < reps; r++ )
+    {
+        memcpy( &reference[0], &input[0], sizeof(SAMPLE) * n );
+        bench_carl_rfft( &reference[0], n / 2, FFT_FORWARD );
+    }
+    double carlForward = bench_now() - t0;
+    t0 = bench_now();
+    for( long r = 0; r < reps; r++ )
+    {
+        memcpy( &x[0], &input[0], sizeof(SAMPLE) * n );
+        plan->forward( &x[0] );
+    }
+    double planForward = bench_now() - t0;
+    double errorForward = bench_fft_error( &x[0], &reference[0], n );
+
+    // inverse of that spectrum
+    spectrum = reference;
+    t0 = bench_now();
+    for( long r = 0; r < reps; r++ )
+    {
+        memcpy( &reference[0], &spectrum[0], sizeof(SAMPLE) * n );
+        bench_carl_rfft( &reference[0], n / 2, FFT_INVERSE );
+    }
+    double carlInverse = bench_now() - t0;
+    t0 = bench_now();
+    for( long r = 0; r < reps; r++ )
+    {
+        memcpy( &x[0], &spectrum[0], sizeof(SAMPLE) * n );
+        plan->inverse( &x[0] );
+    }
+    double planInverse = bench_now() - t0;
+    double errorInverse = bench_fft_error( &x[0], &reference[0], n );
+
+    // the wrapper agrees with the plan
+    memcpy( &x[0], &input[0], sizeof(SAMPLE) * n );
+    rfft( &x[0], n / 2, FFT_FORWARD );
+    memcpy( &reference[0], &input[0], sizeof(SAMPLE) * n );
+    plan->forward( &reference[0] );
+    bool same = memcmp( &x[0], &reference[0], sizeof(SAMPLE) * n ) == 0;
+
+    fprintf( stdout, "%7ld %9.3f %9.3f %9.3f %7.1fx %9.3f %9.3f %7.1fx %9.1e %9.1e %8s\n",
+             n, build / 1e6, carlForward / 1e3 / reps, planForward / 1e3 / reps,
+             carlForward / planForward, carlInverse / 1e3 / reps, planInverse / 1e3 / reps,
+             carlInverse / planInverse,
+             errorForward, errorInverse, same ? "yes" : "NO" );
+    fflush( stdout );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: bench_flocks()
+// desc: run one flocks x boids configuration
+//-----------------------------------------------------------------------------
+static void bench_flocks( long numFlocks, long numBoids, long steps, unsigned int seed, bool lod,
+                          const char * load, const char * save, long render )
+{
+    // same scene every run
+    XFun::srand( seed );
+    Globals::cvIntensity = bench_cv_schedule( 0 );
+
+    long rssBefore = bench_rss_kb();
+    double t0 = bench_now();
+
+    // build the scene (as in initialize_simulation)
+    THEREMAXSim * sim = new THEREMAXSim();
+    sim->setBatchedUpdate( g_batchedUpdate );
+    // camera where look() puts it by default
+    if( lod )
+    {
+        sim->setViewpoint( Vector3D( 0, Globals::viewRadius.x * sin( Globals::viewEyeY.x ),
+                                     Globals::viewRadius.x * cos( Globals::viewEyeY.x ) ) );
+        sim->flockLod().reportInterval = 0;
+    }
+    if( load )
+    {
+        // the snapshot decides the scene
+        if( !theremax_snapshot_load( sim, load ) )
+        {
+            SAFE_DELETE( sim );
+            return;
+        }
+        numFlocks = (long)sim->flockBroadphase().size();
+        numBoids = numFlocks ? (long)sim->flockBroadphase().flocks()[0]->boids().size() : 0;
+    }
+    THEREMAXPopulation & population = sim->population();
+    for( long i = 0; !load && i < numFlocks; i++ )
+        population.spawnFlock( (int)numBoids );
+    if( g_population )
+    {
+        population.following = true;
+        population.minFlocks = numFlocks > 1 ? numFlocks / 2 : 1;
+        population.maxFlocks = numFlocks;
+        population.minBoids = (int)( numBoids > 1 ? numBoids / 2 : 1 );
+        population.maxBoids = (int)numBoids;
+        population.maxChanges = numFlocks > 20 ? numFlocks / 20 : 1;
+    }
+
+    double t1 = bench_now();
+    long rssScene = bench_rss_kb();
+
+    // run (allocations: the first cv period grows the pools, then none)
+    YTimeInterval dt = 1.0 / BENCH_FRAME_RATE;
+    unsigned long allocStart = g_allocations, allocWarm = g_allocations;
+    for( long s = 0; s < steps; s++ )
+    {
+        if( s == BENCH_CV_PERIOD ) allocWarm = g_allocations;
+        Globals::cvIntensity = bench_cv_schedule( s );
+        sim->step( dt );
+    }
+    unsigned long allocEnd = g_allocations;
+
+    double t2 = bench_now();
+
+    // keep it
+    if( save ) theremax_snapshot_save( sim, save );
+
+    // estimated scene bytes (objects only)
+    double sceneBytes = numFlocks * ( sizeof(THEREMAXFlock) + numBoids * sizeof(YEntity *) )
+        + (double)numFlocks * numBoids * ( sizeof(THEREMAXBoid) + sizeof(YEntity *) );
+    double boidSteps = (double)numFlocks * numBoids * steps;
+
+    fprintf( stdout, "%8ld %8ld %10ld %6ld %12.1f %12.3f %10.0f %10ld\n",
+             numFlocks, numBoids, numFlocks * numBoids, steps,
+             boidSteps > 0 ? ( t2 - t1 ) / boidSteps : 0,
+             ( t1 - t0 ) / 1e6, sceneBytes / 1024, rssScene - rssBefore );
+    if( lod )
+    {
+        THEREMAXFlockLod & l = sim->flockLod();
+        fprintf( stdout, "%8s lod full:%lu reduced:%lu aggregate:%lu saved:%.3fms/step\n", "",
+                 l.boidsAt( THEREMAX_LOD_FULL ), l.boidsAt( THEREMAX_LOD_REDUCED ),
+                 l.boidsAt( THEREMAX_LOD_AGGREGATE ), l.savedTime() * 1000 );
+    }
+    if( g_population )
+    {
+        fprintf( stdout, "%8s population %lu flocks (pooled %lu flocks %lu boids), spawned:%lu "
+                 "despawned:%lu created:%lu, allocations first %d steps:%lu after:%lu\n", "",
+                 (unsigned long)population.numFlocks(), (unsigned long)population.numPooledFlocks(),
+                 (unsigned long)population.numPooledBoids(), population.numSpawned(),
+                 population.numDespawned(), population.numCreated(), BENCH_CV_PERIOD,
+                 ( steps > BENCH_CV_PERIOD ? allocWarm : allocEnd ) - allocStart,
+                 steps > BENCH_CV_PERIOD ? allocEnd - allocWarm : 0 );
+        population.following = false;
+    }
+    // update pass alone, on the scene as it is now
+    if( steps > 0 )
+    {
+        double recursive = bench_update( sim, steps, false );
+        double batched = bench_update( sim, steps, true );
+        YUpdateScheduler & updater = sim->updater();
+        fprintf( stdout, "%8s update recursive:%.1fns/node batched:%.1fns/node "
+                 "(%lu nodes, %lu batches, %lu unbatched, gather:%.2fms)%s\n", "",
+                 recursive, batched, (unsigned long)updater.numNodes(),
+                 (unsigned long)updater.numBatches(), (unsigned long)updater.numUnbatched(),
+                 updater.gatherTime() * 1000, g_batchedUpdate ? "" : " (steps recursive)" );
+    }
+    // world transforms: recomputed while the boids move, cached when still
+    if( steps > 0 )
+    {
+        YDrawList & list = sim->drawList();
+        double moving = bench_prepare( sim, steps );
+        size_t movingTransforms = list.numTransforms();
+        double still = bench_prepare( sim, 0 );
+        fprintf( stdout, "%8s prepare moving:%.2fms (%lu transforms) still:%.2fms "
+                 "(%lu transforms, %lu nodes)\n", "", moving, (unsigned long)movingTransforms,
+                 still, (unsigned long)list.numTransforms(), (unsigned long)list.numNodes() );
+    }
+    // what the scene's slabs hold
+    const vector<YSlab *> & slabs = YSlab::slabs();
+    for( size_t i = 0; i < slabs.size(); i++ )
+    {
+        if( !slabs[i]->numObjects() ) continue;
+        fprintf( stdout, "%8s slab %s: %lu x %lu bytes, %.1f KB of %.1f KB reserved\n", "",
+                 slabs[i]->name(), (unsigned long)slabs[i]->numObjects(),
+                 (unsigned long)slabs[i]->slotSize(), slabs[i]->bytesUsed() / 1024.0,
+                 slabs[i]->bytesReserved() / 1024.0 );
+    }
+    if( render > 0 )
+    {
+        double recursive = bench_render( sim, render, GL_FALSE, true );
+        double listed = bench_render( sim, render, GL_FALSE, false );
+        double listedIssued = g_stateIssued, listedSkipped = g_stateSkipped;
+        YDrawList & list = sim->drawList();
+        fprintf( stdout, "%8s render recursive:%.2fms/frame draw list:%.2fms/frame "
+                 "(%lu items, %lu nodes, %lu transforms, %lu culled in %lu tests, prepare:%.2fms "
+                 "sort:%.2fms submit:%.2fms)\n", "",
+                 recursive, listed, (unsigned long)list.size(), (unsigned long)list.numNodes(),
+                 (unsigned long)list.numTransforms(),
+                 (unsigned long)list.numCulled(), (unsigned long)list.numCullTests(),
+                 list.prepareTime() * 1000, list.sortTime() * 1000, list.submitTime() * 1000 );
+        double batched = bench_render( sim, render, GL_TRUE, false );
+        THEREMAXSparkBatch & batch = sim->sparkBatch();
+        fprintf( stdout, "%8s render spark batch:%.2fms/frame (%lu sparks, %lu draw, "
+                 "collect:%.2fms draw:%.2fms)\n", "",
+                 batched, (unsigned long)batch.numSparks(), batch.numDrawCalls(),
+                 batch.collectTime() * 1000, batch.drawTime() * 1000 );
+        // unbatched: one set of state calls per spark
+        fprintf( stdout, "%8s gl state calls/frame unbatched issued:%.0f skipped:%.0f, "
+                 "batched issued:%.0f skipped:%.0f%s\n", "",
+                 listedIssued, listedSkipped, g_stateIssued, g_stateSkipped,
+                 XGLState::caching() ? "" : " (cache off)" );
+    }
+    if( g_profile && steps > 0 ) bench_profile( sim, steps, render, g_profile );
+    fflush( stdout );
+
+    // clean up
+    if( render > 0 ) sim->sparkBatch().cleanup();
+    double t3 = bench_now();
+    sim->flockBroadphase().clear();
+    sim->root().deleteChildren();
+    double t4 = bench_now();
+    fprintf( stdout, "%8s teardown:%.3fms\n", "", ( t4 - t3 ) / 1e6 );
+    fflush( stdout );
+    SAFE_DELETE( sim );
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+// name: main()
+// desc: entry point
+//-----------------------------------------------------------------------------
+int main( int argc, const char ** argv )
+{
+    long steps = BENCH_DEFAULT_STEPS;
+    unsigned int seed = BENCH_DEFAULT_SEED;
+    bool lod = false;
+    const char * load = NULL;
+    const char * save = NULL;
+    long render = 0;
+    vector<long> flockCounts;
+    vector<long> boidCounts;
+    vector<long> particleCounts;
+    vector<long> audioBudgets;
+    vector<long> sortCounts;
+    vector<long> fftSizes;
+
+    // default matrix
+    flockCounts.push_back( 10 ); flockCounts.push_back( 100 );
+    flockCounts.push_back( 1000 ); flockCounts.push_back( 10000 );
+    boidCounts.push_back( 10 ); boidCounts.push_back( 100 );
+
+    for( int i = 1; i < argc; i++ )
+    {
+        if( strcmp( argv[i], "--steps" ) == 0 && i + 1 < argc ) {
+            steps = atol( argv[++i] );
+        } else if( strcmp( argv[i], "--seed" ) == 0 && i + 1 < argc ) {
+            seed = (unsigned int)atol( argv[++i] );
+        } else if( strcmp( argv[i], "--lod" ) == 0 ) {
+            lod = true;
+        } else if( strcmp( argv[i], "--flocks" ) == 0 && i + 1 < argc ) {
+            flockCounts = bench_parse_list( argv[++i] );
+        } else if( strcmp( argv[i], "--boids" ) == 0 && i + 1 < argc ) {
+            boidCounts = bench_parse_list( argv[++i] );
+        } else if( strcmp( argv[i], "--load" ) == 0 && i + 1 < argc ) {
+            load = argv[++i];
+        } else if( strcmp( argv[i], "--save" ) == 0 && i + 1 < argc ) {
+            save = argv[++i];
+        } else if( strcmp( argv[i], "--render" ) == 0 && i + 1 < argc ) {
+            render = atol( argv[++i] );
+        } else if( strcmp( argv[i], "--no-state-cache" ) == 0 ) {
+            XGLState::setCaching( false );
+        } else if( strcmp( argv[i], "--recursive-update" ) == 0 ) {
+            g_batchedUpdate = false;
+        } else if( strcmp( argv[i], "--population" ) == 0 ) {
+            g_population = true;
+        } else if( strcmp( argv[i], "--profile" ) == 0 && i + 1 < argc ) {
+            g_profile = argv[++i];
+        } else if( strcmp( argv[i], "--particles" ) == 0 && i + 1 < argc ) {
+            particleCounts = bench_parse_list( argv[++i] );
+        } else if( strcmp( argv[i], "--audio" ) == 0 && i + 1 < argc ) {
+            audioBudgets = bench_parse_list( argv[++i] );
+        } else if( strcmp( argv[i], "--sort" ) == 0 && i + 1 < argc ) {
+            sortCounts = bench_parse_list( argv[++i] );
+        } else if( strcmp( argv[i], "--fft" ) == 0 && i + 1 < argc ) {
+            fftSizes = bench_parse_list( argv[++i] );
+        } else {
+            fprintf( stderr, "usage: theremax-bench [--steps N] [--seed S] [--lod] "
+                     "[--flocks a,b,...] [--boids a,b,...] [--load file] [--save file] [--render N] "
+                     "[--no-state-cache] [--recursive-update] [--population] [--profile file] "
+                     "[--particles a,b,...] [--audio a,b,...] [--sort a,b,...] [--fft a,b,...]\n" );
+            return -1;
+        }
+    }
+
+    fprintf( stderr, "[theremax-bench]: %ld steps at %.0f fps, seed %u\n",
+             steps, BENCH_FRAME_RATE, seed );
+    // particles instead of flocks
+    if( particleCounts.size() )
+    {
+        fprintf( stdout, "%10s %6s %14s %14s %9s %10s\n", "particles", "steps",
+                 "old(p/ms)", "batched(p/ms)", "speedup", "max diff" );
+        for( size_t i = 0; i < particleCounts.size(); i++ )
+            bench_particles( particleCounts[i], steps, seed );
+        for( size_t i = 0; i < particleCounts.size(); i++ )
+            bench_particles_burst( particleCounts[i], steps );
+        return 0;
+    }
+    // audio emitter instead of flocks
+    if( audioBudgets.size() )
+    {
+        fprintf( stdout, "%10s %8s %8s %8s %8s %8s %8s %10s %10s\n", "budget(ms)",
+                 "emit(ms)", "max(ms)", "live", "maxlive", "cap", "denied",
+                 "us/part", "fft(ms)" );
+        for( size_t i = 0; i < audioBudgets.size(); i++ )
+            bench_audio( audioBudgets[i], steps, seed, i + 1 == audioBudgets.size() );
+        return 0;
+    }
+    // fft instead of flocks
+    if( fftSizes.size() )
+    {
+        fprintf( stdout, "%7s %9s %9s %9s %8s %9s %9s %8s %9s %9s %8s\n", "size",
+                 "plan(ms)", "carl(us)", "fwd(us)", "speedup", "carl(us)", "inv(us)",
+                 "speedup", "fwd err", "inv err", "wrapper" );
+        for( size_t i = 0; i < fftSizes.size(); i++ )
+            bench_fft( fftSizes[i], seed );
+        return 0;
+    }
+    // spark depth sort instead of flocks
+    if( sortCounts.size() )
+    {
+        fprintf( stdout, "%10s %10s %10s %10s %10s %10s %10s %7s %10s\n", "sparks",
+                 "plain(ms)", "sorted(ms)", "sort(ms)", "max(ms)", "still(ms)",
+                 "stable(ms)", "passes", "in order" );
+        for( size_t i = 0; i < sortCounts.size(); i++ )
+            bench_sort( sortCounts[i], steps, seed );
+        return 0;
+    }
+    // context for --render
+    if( render > 0 )
+    {
+        if( !theremax_offscreen_init( BENCH_RENDER_WIDTH, BENCH_RENDER_HEIGHT ) )
+            return -1;
+        fprintf( stderr, "[theremax-bench]: rendering %ld frames %dx%d on %s\n", render,
+                 BENCH_RENDER_WIDTH, BENCH_RENDER_HEIGHT, (const char *)glGetString( GL_RENDERER ) );
+        bench_render_setup();
+    }
+    fprintf( stdout, "%8s %8s %10s %6s %12s %12s %10s %10s\n",
+             "flocks", "boids", "total", "steps", "ns/boid-step",
+             "build(ms)", "scene(KB)", "rss(KB)" );
+
+    // one row from a snapshot
+    if( load )
+    {
+        bench_flocks( 0, 0, steps, seed, lod, load, save, render );
+        theremax_offscreen_shutdown();
+        return 0;
+    }
+
+    // run the matrix
+    for( size_t f = 0; f < flockCounts.size(); f++ )
+        for( size_t b = 0; b < boidCounts.size(); b++ )
+            bench_flocks( flockCounts[f], boidCounts[b], steps, seed, lod, NULL, save, render );
+
+    theremax_offscreen_shutdown();
+    return 0;
+}
@@ -10,6 +10,7 @@
 #include "theremax-audio.h"
 #include "theremax-cv-thread.h"
 #include "theremax-gfx.h"
+#include "theremax-globals.h"
 
 using namespace std;
 
@@ -17,6 +18,8 @@ int main(int argc, const char **argv)
 {
     unsigned int inputDevice = 0;
     unsigned int outputDevice = 1;
+    long offscreenFrames = 0;
+    const char * dumpFrames = NULL;
 
     // check variable for input / output devices
     for (int i = 1; i < argc; i++) {
@@ -27,9 +30,31 @@ int main(int argc, const char **argv)
             inputDevice = atoi(argv[++i]);
         } else if (strcmp(argv[i], "--output-device") == 0 && i + 1 < argc) {
             outputDevice = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            Globals::snapshotPath = argv[++i];
+            Globals::snapshotRestore = true;
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            Globals::profilePath = argv[++i];
+        } else if (strcmp(argv[i], "--offscreen") == 0 && i + 1 < argc) {
+            offscreenFrames = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--dump-frames") == 0 && i + 1 < argc) {
+            dumpFrames = argv[++i];
+        } else if (strcmp(argv[i], "--single-thread") == 0) {
+            Globals::simThread = false;
         }
     }
 
+    // headless: graphics only, no window, webcam or audio
+    if (offscreenFrames > 0)
+    {
+        if ( !theremax_gfx_offscreen(offscreenFrames, dumpFrames) )
+        {
+            cerr << "[theremax]: cannot render offscreen.." << endl;
+            return -1;
+        }
+        return 0;
+    }
+
     // Initialize graphics engine / simulation
     if ( !theremax_gfx_init(argc, argv) )
     {